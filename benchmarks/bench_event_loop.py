@@ -0,0 +1,38 @@
+"""Micro-benchmark: C++ event-loop throughput on a single-node M/M/1 queue.
+
+Reports departures/sec and ns/departure (best of several repeats) so
+changes to the hot loop can be compared run-to-run.
+
+Usage:
+    python benchmarks/bench_event_loop.py [num_events] [repeats]
+"""
+
+import sys
+import time
+
+
+def bench_once(num_events: int, seed: int) -> float:
+    """Run one M/M/1 FCFS simulation, return elapsed seconds."""
+    import _queue_sim_cpp as cpp
+
+    server = cpp.FCFS(cpp.ExponentialDist(2.0))
+    system = cpp.QueueSystem([server], cpp.ExponentialDist(1.0))
+    t0 = time.perf_counter()
+    system.sim(num_events=num_events, seed=seed)
+    return time.perf_counter() - t0
+
+
+def main() -> None:
+    num_events = int(sys.argv[1]) if len(sys.argv) > 1 else 10_000_000
+    repeats = int(sys.argv[2]) if len(sys.argv) > 2 else 5
+
+    bench_once(num_events // 10, seed=0)  # warm caches / page in the module
+    best = min(bench_once(num_events, seed=i) for i in range(repeats))
+
+    print(f"M/M/1 FCFS, {num_events:,d} departures, best of {repeats}")
+    print(f"  {num_events / best / 1e6:8.2f} M departures/s")
+    print(f"  {best / num_events * 1e9:8.1f} ns/departure")
+
+
+if __name__ == "__main__":
+    main()
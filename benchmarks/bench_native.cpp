@@ -0,0 +1,284 @@
+// Native benchmark suite for the C++ engine: event-loop throughput across
+// policies, size distributions, multi-server and network scaling, event
+// logging, replicate() thread scaling and the lockstep engine.  Each case reports the best of
+// several repeats as departures/sec and ns/departure.
+//
+// Build and run directly, or through benchmarks/bench_native.py, which
+// also keeps and compares baselines:
+//
+//   c++ -O2 -std=c++17 -Icsrc/include -pthread -o bench_native
+//       benchmarks/bench_native.cpp
+//   ./bench_native [--events N] [--repeats R] [--filter SUBSTR]
+//                  [--max-threads T] [--list] [--json]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "queue_sim/queue_system.hpp"
+
+using namespace queue_sim;
+
+namespace {
+
+struct Case {
+    std::string name;
+    int64_t events;                    // departures per run
+    std::function<void(int)> run;      // one timed run for a seed
+};
+
+struct Options {
+    int events = 1000000;
+    int repeats = 5;
+    int max_threads = 0;  // 0: hardware concurrency
+    std::string filter;
+    bool list = false;
+    bool json = false;
+};
+
+// -- System builders --------------------------------------------------------
+
+constexpr double LOAD = 0.7;
+
+struct SizeFamily {
+    const char* name;
+    Distribution dist;
+    double mean;
+};
+
+std::vector<SizeFamily> sizeFamilies() {
+    // Bounded Pareto(1, 1000, 1.5): E[X] = a C (k^(1-a) - p^(1-a)) / (a - 1).
+    BoundedParetoDist bp(1.0, 1000.0, 1.5);
+    double bp_mean = 1.5 * bp.C *
+                     (std::pow(1.0, -0.5) - std::pow(1000.0, -0.5)) / 0.5;
+    HyperExponentialDist h2(0.9, 1.8, 0.18);
+    ErlangDist erlang(4, 4.0);
+    LognormalDist lognormal(-0.5, 1.0);
+    return {
+        {"exp", ExponentialDist(1.0), 1.0},
+        {"h2", h2, h2.mean},
+        {"bpareto", bp, bp_mean},
+        {"erlang4", erlang, erlang.mean},
+        {"lognormal", lognormal, lognormal.mean},
+        {"det", DeterministicDist(1.0), 1.0},
+    };
+}
+
+std::shared_ptr<Server> makeServer(const std::string& policy, Distribution d,
+                                   int k = 1) {
+    if (policy == "fcfs") return std::make_shared<FCFS>(std::move(d), k);
+    if (policy == "ps") return std::make_shared<PS>(std::move(d), k);
+    if (policy == "srpt") return std::make_shared<SRPT>(std::move(d));
+    if (policy == "fb") return std::make_shared<FB>(std::move(d));
+    throw std::invalid_argument("unknown policy " + policy);
+}
+
+// n FCFS servers; external traffic enters server 0 and every departure
+// leaves with probability 1/2 or moves to a uniformly chosen server, so
+// each server sees at most about twice the external rate.
+QueueSystem network(int n) {
+    std::vector<std::shared_ptr<Server>> servers;
+    for (int i = 0; i < n; ++i) {
+        servers.push_back(std::make_shared<FCFS>(ExponentialDist(3.0)));
+    }
+    std::vector<std::vector<double>> M(n, std::vector<double>(n + 1, 0.5 / n));
+    for (auto& row : M) row[n] = 0.5;
+    return QueueSystem(std::move(servers), ExponentialDist(1.0), std::move(M));
+}
+
+QueueSystem tandem(int n) {
+    std::vector<std::shared_ptr<Server>> servers;
+    std::vector<std::vector<double>> M(n, std::vector<double>(n + 1, 0.0));
+    for (int i = 0; i < n; ++i) {
+        servers.push_back(std::make_shared<FCFS>(ExponentialDist(1.0 / LOAD)));
+        M[i][i + 1] = 1.0;
+    }
+    return QueueSystem(std::move(servers), ExponentialDist(1.0), std::move(M));
+}
+
+// Shares one system between the timed runs of a case, so the scratch
+// storage it keeps is warm after the first repeat, as in a sweep.
+template <class Fn>
+std::function<void(int)> on(QueueSystem system, Fn fn) {
+    auto shared = std::make_shared<QueueSystem>(std::move(system));
+    return [shared, fn](int seed) { fn(*shared, seed); };
+}
+
+std::vector<Case> buildCases(const Options& opt) {
+    std::vector<Case> cases;
+    const int n = opt.events;
+
+    // -- policy x size distribution, single server at load 0.7 --
+    for (const char* policy : {"fcfs", "ps", "srpt", "fb"}) {
+        for (const SizeFamily& f : sizeFamilies()) {
+            QueueSystem q({makeServer(policy, f.dist)},
+                          ExponentialDist(LOAD / f.mean));
+            cases.push_back({std::string("policy/") + policy + "/" + f.name,
+                             n, on(std::move(q), [n](QueueSystem& s, int seed) {
+                                 s.sim(n, seed);
+                             })});
+        }
+    }
+
+    // -- M/M/k scaling at load 0.7 --
+    for (const char* policy : {"fcfs", "ps"}) {
+        for (int k : {1, 2, 4, 8, 16, 32, 64}) {
+            QueueSystem q({makeServer(policy, ExponentialDist(1.0), k)},
+                          ExponentialDist(LOAD * k));
+            cases.push_back({std::string("servers/") + policy + "/k=" +
+                                 std::to_string(k),
+                             n, on(std::move(q), [n](QueueSystem& s, int seed) {
+                                 s.sim(n, seed);
+                             })});
+        }
+    }
+
+    // -- network size, dense transition matrix --
+    for (int size : {1, 2, 4, 8, 16, 32, 64}) {
+        cases.push_back({"network/n=" + std::to_string(size), n,
+                         on(network(size), [n](QueueSystem& s, int seed) {
+                             s.sim(n, seed);
+                         })});
+    }
+
+    // -- event logging off / in memory --
+    for (int size : {1, 4}) {
+        for (bool log : {false, true}) {
+            cases.push_back(
+                {"events/tandem" + std::to_string(size) + "/" +
+                     (log ? "on" : "off"),
+                 n, on(tandem(size), [n, log](QueueSystem& s, int seed) {
+                     s.sim(n, seed, 0, false, log);
+                 })});
+        }
+    }
+
+    // -- replicate() thread scaling, 16 replications of n / 4 --
+    int hw = static_cast<int>(std::thread::hardware_concurrency());
+    int max_threads = opt.max_threads > 0 ? opt.max_threads : std::max(1, hw);
+    const int reps = 16;
+    const int per_rep = std::max(1, n / 4);
+    for (int t = 1; t <= max_threads; t *= 2) {
+        QueueSystem q({std::make_shared<FCFS>(ExponentialDist(1.0 / LOAD))},
+                      ExponentialDist(1.0));
+        cases.push_back({"replicate/threads=" + std::to_string(t),
+                         int64_t(reps) * per_rep,
+                         on(std::move(q), [=](QueueSystem& s, int seed) {
+                             s.replicate(reps, per_rep, seed, 0, t);
+                         })});
+    }
+
+    // -- lockstep engine vs the event loop, same 16 replications --
+    for (const char* policy : {"fcfs", "srpt"}) {
+        for (bool vec : {false, true}) {
+            QueueSystem q({makeServer(policy, ExponentialDist(1.0 / LOAD))},
+                          ExponentialDist(1.0));
+            cases.push_back({std::string("lockstep/") + policy + "/" +
+                                 (vec ? "on" : "off"),
+                             int64_t(reps) * per_rep,
+                             on(std::move(q), [=](QueueSystem& s, int seed) {
+                                 s.replicate(reps, per_rep, seed, 0, 1, false,
+                                             false, false, nullptr,
+                                             ProgressFn(), vec);
+                             })});
+        }
+    }
+    return cases;
+}
+
+// -- Driver -----------------------------------------------------------------
+
+double timeOnce(const Case& c, int seed) {
+    auto t0 = std::chrono::steady_clock::now();
+    c.run(seed);
+    auto t1 = std::chrono::steady_clock::now();
+    return std::chrono::duration<double>(t1 - t0).count();
+}
+
+[[noreturn]] void usage(const char* argv0) {
+    std::fprintf(stderr,
+                 "usage: %s [--events N] [--repeats R] [--filter SUBSTR] "
+                 "[--max-threads T] [--list] [--json]\n",
+                 argv0);
+    std::exit(2);
+}
+
+Options parse(int argc, char** argv) {
+    Options opt;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&]() -> const char* {
+            if (i + 1 >= argc) usage(argv[0]);
+            return argv[++i];
+        };
+        if (arg == "--events") {
+            opt.events = std::atoi(value());
+        } else if (arg == "--repeats") {
+            opt.repeats = std::atoi(value());
+        } else if (arg == "--filter") {
+            opt.filter = value();
+        } else if (arg == "--max-threads") {
+            opt.max_threads = std::atoi(value());
+        } else if (arg == "--list") {
+            opt.list = true;
+        } else if (arg == "--json") {
+            opt.json = true;
+        } else {
+            usage(argv[0]);
+        }
+    }
+    if (opt.events < 1 || opt.repeats < 1) usage(argv[0]);
+    return opt;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options opt = parse(argc, argv);
+    std::vector<Case> cases = buildCases(opt);
+
+    if (opt.json) std::printf("[\n");
+    else if (!opt.list) {
+        std::printf("%-28s %12s %12s %12s\n", "case", "departures",
+                    "M dep/s", "ns/dep");
+    }
+    bool first = true;
+    for (const Case& c : cases) {
+        if (c.name.find(opt.filter) == std::string::npos) continue;
+        if (opt.list) {
+            std::printf("%s\n", c.name.c_str());
+            continue;
+        }
+        timeOnce(c, 0);  // warm caches and the system's scratch storage
+        double best = timeOnce(c, 1);
+        for (int r = 1; r < opt.repeats; ++r) {
+            best = std::min(best, timeOnce(c, 1 + r));
+        }
+        double rate = static_cast<double>(c.events) / best;
+        double ns = best / static_cast<double>(c.events) * 1e9;
+        if (opt.json) {
+            std::printf("%s  {\"name\": \"%s\", \"events\": %lld, "
+                        "\"seconds\": %.6g, \"events_per_sec\": %.6g, "
+                        "\"ns_per_event\": %.6g}",
+                        first ? "" : ",\n", c.name.c_str(),
+                        static_cast<long long>(c.events), best, rate, ns);
+        } else {
+            std::printf("%-28s %12lld %12.2f %12.1f\n", c.name.c_str(),
+                        static_cast<long long>(c.events), rate / 1e6, ns);
+        }
+        std::fflush(stdout);
+        first = false;
+    }
+    if (opt.json) std::printf("\n]\n");
+    return 0;
+}
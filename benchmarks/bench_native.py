@@ -0,0 +1,170 @@
+"""Native benchmark suite: build and run bench_native.cpp, and keep or
+compare against a stored baseline.
+
+The driver times the C++ engine directly (no Python in the loop) over
+policy x size distribution, M/M/k scaling, network size, event logging
+on/off and replicate() thread scaling, and reports departures/sec and
+ns/departure (best of several repeats).
+
+Usage:
+    python benchmarks/bench_native.py                    # run and print
+    python benchmarks/bench_native.py --save base.json   # store a baseline
+    python benchmarks/bench_native.py --compare base.json [--tolerance 0.10]
+
+With --compare, cases whose ns/departure grew by more than the tolerance
+are flagged and the exit status is 1.  Baselines are only comparable on
+the same machine and compiler; record one before a change and compare
+after it.  Set CXX to choose the compiler.
+"""
+
+import argparse
+import json
+import os
+import platform
+import shlex
+import subprocess
+import sys
+from pathlib import Path
+
+ROOT = Path(__file__).resolve().parent.parent
+SOURCE = ROOT / "benchmarks" / "bench_native.cpp"
+INCLUDE = ROOT / "csrc" / "include"
+BUILD_DIR = ROOT / "_bench_build"
+BINARY = BUILD_DIR / "bench_native"
+CXXFLAGS = ["-O2", "-std=c++17", "-pthread"]
+
+
+def _compiler() -> list[str]:
+    return shlex.split(os.environ.get("CXX", "c++"))
+
+
+def _compiler_version() -> str:
+    out = subprocess.run(_compiler() + ["--version"], capture_output=True, text=True)
+    return out.stdout.splitlines()[0] if out.stdout else "unknown"
+
+
+def build() -> Path:
+    """Compile the driver unless the binary is newer than every source."""
+    sources = [SOURCE, *INCLUDE.glob("queue_sim/*.hpp")]
+    if BINARY.exists() and all(
+        BINARY.stat().st_mtime >= s.stat().st_mtime for s in sources
+    ):
+        return BINARY
+    BUILD_DIR.mkdir(exist_ok=True)
+    cmd = _compiler() + CXXFLAGS + [f"-I{INCLUDE}", str(SOURCE), "-o", str(BINARY)]
+    print("building:", " ".join(cmd), file=sys.stderr)
+    subprocess.run(cmd, check=True)
+    return BINARY
+
+
+def run(args: argparse.Namespace) -> list[dict]:
+    """Run the driver, return one record per case."""
+    cmd = [
+        str(build()),
+        "--json",
+        "--events",
+        str(args.events),
+        "--repeats",
+        str(args.repeats),
+    ]
+    if args.filter:
+        cmd += ["--filter", args.filter]
+    if args.max_threads:
+        cmd += ["--max-threads", str(args.max_threads)]
+    out = subprocess.run(cmd, check=True, capture_output=True, text=True)
+    return json.loads(out.stdout)
+
+
+def _machine() -> dict:
+    return {
+        "platform": platform.platform(),
+        "processor": platform.processor() or platform.machine(),
+        "cpus": os.cpu_count(),
+        "compiler": _compiler_version(),
+    }
+
+
+def print_results(results: list[dict]) -> None:
+    print(f"{'case':<28s} {'departures':>12s} {'M dep/s':>10s} {'ns/dep':>10s}")
+    print("-" * 63)
+    for r in results:
+        print(
+            f"{r['name']:<28s} {r['events']:>12,d} "
+            f"{r['events_per_sec'] / 1e6:>10.2f} {r['ns_per_event']:>10.1f}"
+        )
+
+
+def compare(results: list[dict], baseline: dict, tolerance: float, filtered: bool) -> int:
+    """Print the change per case; return the number of regressions."""
+    if baseline.get("machine") != _machine():
+        print(
+            "warning: baseline was recorded on a different machine or "
+            "compiler; differences may not mean much",
+            file=sys.stderr,
+        )
+    before = {r["name"]: r for r in baseline["results"]}
+    print(f"{'case':<28s} {'base ns':>10s} {'now ns':>10s} {'change':>9s}")
+    print("-" * 61)
+    regressions = 0
+    for r in results:
+        old = before.get(r["name"])
+        if old is None:
+            print(f"{r['name']:<28s} {'-':>10s} {r['ns_per_event']:>10.1f}       new")
+            continue
+        change = r["ns_per_event"] / old["ns_per_event"] - 1.0
+        slower = change > tolerance
+        regressions += slower
+        print(
+            f"{r['name']:<28s} {old['ns_per_event']:>10.1f} "
+            f"{r['ns_per_event']:>10.1f} {change:>+8.1%}"
+            + ("  SLOWER" if slower else "")
+        )
+    missing = sorted(set(before) - {r["name"] for r in results})
+    if missing and not filtered:
+        print("not run:", ", ".join(missing))
+    return regressions
+
+
+def main() -> None:
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--events", type=int, default=1_000_000,
+                        help="departures per run (default 1e6)")
+    parser.add_argument("--repeats", type=int, default=5,
+                        help="timed runs per case; the best is kept")
+    parser.add_argument("--filter", default="",
+                        help="only cases whose name contains this")
+    parser.add_argument("--max-threads", type=int, default=0,
+                        help="largest replicate() thread count (default: all CPUs)")
+    parser.add_argument("--save", metavar="PATH", help="write results as a baseline")
+    parser.add_argument("--compare", metavar="PATH", help="compare with a baseline")
+    parser.add_argument("--tolerance", type=float, default=0.10,
+                        help="allowed ns/departure growth before flagging (0.10 = 10%%)")
+    args = parser.parse_args()
+
+    results = run(args)
+    if args.compare:
+        baseline = json.loads(Path(args.compare).read_text())
+        regressions = compare(results, baseline, args.tolerance, bool(args.filter))
+    else:
+        print_results(results)
+        regressions = 0
+
+    if args.save:
+        record = {
+            "machine": _machine(),
+            "events": args.events,
+            "repeats": args.repeats,
+            "filter": args.filter,
+            "results": results,
+        }
+        Path(args.save).write_text(json.dumps(record, indent=2) + "\n")
+        print(f"baseline written to {args.save}", file=sys.stderr)
+
+    if regressions:
+        print(f"{regressions} case(s) slower than the baseline by more than "
+              f"{args.tolerance:.0%}", file=sys.stderr)
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
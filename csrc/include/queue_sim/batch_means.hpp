@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "stats.hpp"
+
+namespace queue_sim {
+
+// Non-overlapping batch means over one long measurement run.  The run's
+// completions are cut into n_batches consecutive batches of
+// num_events / n_batches; each batch measures its own area under N(t),
+// giving batch_N (area / batch duration) and batch_T (area / batch
+// completions, the same Little's-law estimate as the whole run).  With
+// batches long enough to be nearly independent, their t interval is a
+// CI for the steady-state means while paying the warmup only once,
+// instead of once per replication.  Completions past the last full batch
+// count towards the run's overall means only.
+struct BatchMeans {
+    int n_batches = 0;
+    int batch_size = 0;  // completions per batch, set by the run
+    std::vector<double> batch_N;
+    std::vector<double> batch_T;
+
+    BatchMeans() = default;
+    explicit BatchMeans(int n_batches) : n_batches(n_batches) {}
+
+    // Reset for a run of `num_events` completions; returns the batch size.
+    int begin(int num_events) {
+        batch_N.clear();
+        batch_T.clear();
+        batch_N.reserve(n_batches);
+        batch_T.reserve(n_batches);
+        batch_size = n_batches > 0 ? num_events / n_batches : 0;
+        return batch_size;
+    }
+
+    void add(double area, double duration, int completions) {
+        batch_N.push_back(duration > 0.0 ? area / duration : 0.0);
+        batch_T.push_back(area / completions);
+    }
+
+    bool full() const {
+        return static_cast<int>(batch_N.size()) >= n_batches;
+    }
+
+    double ciHalfN(double confidence = 0.95) const {
+        return ciHalfWidth(batch_N, confidence);
+    }
+    double ciHalfT(double confidence = 0.95) const {
+        return ciHalfWidth(batch_T, confidence);
+    }
+
+    // Lag-1 autocorrelation of batch_T.  Near zero means the batches are
+    // long enough to treat as independent; clearly positive values mean
+    // the CI is too narrow and fewer, longer batches are needed.
+    double lag1T() const {
+        size_t n = batch_T.size();
+        if (n < 2) return 0.0;
+        double m = sampleMean(batch_T);
+        double num = 0.0, den = 0.0;
+        for (size_t i = 0; i < n; ++i) {
+            double d = batch_T[i] - m;
+            den += d * d;
+            if (i + 1 < n) num += d * (batch_T[i + 1] - m);
+        }
+        return den > 0.0 ? num / den : 0.0;
+    }
+};
+
+}  // namespace queue_sim
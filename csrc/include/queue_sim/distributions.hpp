@@ -1,18 +1,28 @@
 #pragma once
 
+#include <algorithm>
 #include <cmath>
-#include <random>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
 #include <variant>
+#include <vector>
+
+#include "mapped_file.hpp"
+#include "rng.hpp"
+#include "serialize.hpp"
 
 namespace queue_sim {
 
 struct ExponentialDist {
     double mu;  // rate parameter; E[X] = 1/mu
-    explicit ExponentialDist(double mu) : mu(mu) {}
+    double mean;
+    explicit ExponentialDist(double mu) : mu(mu), mean(1.0 / mu) {}
 
-    double sample(std::mt19937_64 &rng) const {
-        std::uniform_real_distribution<double> u(0.0, 1.0);
-        return -(1.0 / mu) * std::log(1.0 - u(rng));
+    double sample(Rng &rng) const {
+        return mean * rng.exponential();
     }
 };
 
@@ -20,28 +30,326 @@ struct UniformDist {
     double a, b;
     UniformDist(double a, double b) : a(a), b(b) {}
 
-    double sample(std::mt19937_64 &rng) const {
-        std::uniform_real_distribution<double> u(0.0, 1.0);
-        return (b - a) * u(rng) + a;
+    double sample(Rng &rng) const {
+        return (b - a) * rng.uniform() + a;
     }
 };
 
 struct BoundedParetoDist {
     double k, p, alpha, C;
+    // Per-draw constants of the inverse CDF, hoisted out of sample().
+    double kNegAlpha, negInvAlpha;
     BoundedParetoDist(double k, double p, double alpha)
         : k(k), p(p), alpha(alpha),
-          C(std::pow(k, alpha) / (1.0 - std::pow(k / p, alpha))) {}
+          C(std::pow(k, alpha) / (1.0 - std::pow(k / p, alpha))),
+          kNegAlpha(std::pow(k, -alpha)), negInvAlpha(-1.0 / alpha) {}
+
+    double sample(Rng &rng) const {
+        return rng.boundedPareto(C, kNegAlpha, negInvAlpha);
+    }
+};
+
+// -- Phase-type and other parametric families --------------------------------
+//
+// Constructors reject parameters outside the family's support; `mean` is
+// E[X], handy for setting loads.
+
+inline void requirePositive(double value, const char* what) {
+    if (!(value > 0.0) || !std::isfinite(value)) {
+        throw std::invalid_argument(std::string(what) +
+                                    " must be positive and finite, got " +
+                                    std::to_string(value));
+    }
+}
+
+// Two-phase hyperexponential: Exp(mu1) with probability p, else Exp(mu2).
+// The usual model of high-variability (C^2 > 1) sizes.
+struct HyperExponentialDist {
+    double p, mu1, mu2;
+    double mean1, mean2, mean;
+    HyperExponentialDist(double p, double mu1, double mu2)
+        : p(p), mu1(mu1), mu2(mu2), mean1(1.0 / mu1), mean2(1.0 / mu2),
+          mean(p / mu1 + (1.0 - p) / mu2) {
+        if (!(p >= 0.0 && p <= 1.0)) {
+            throw std::invalid_argument(
+                "HyperExponentialDist p must be in [0, 1], got " +
+                std::to_string(p));
+        }
+        requirePositive(mu1, "HyperExponentialDist mu1");
+        requirePositive(mu2, "HyperExponentialDist mu2");
+    }
 
-    double sample(std::mt19937_64 &rng) const {
-        std::uniform_real_distribution<double> u(0.0, 1.0);
-        return std::pow(-u(rng) / C + std::pow(k, -alpha), -1.0 / alpha);
+    double sample(Rng &rng) const {
+        double scale = rng.uniform() < p ? mean1 : mean2;
+        return scale * rng.exponential();
     }
 };
 
-using Distribution = std::variant<ExponentialDist, UniformDist, BoundedParetoDist>;
+// Erlang-k: the sum of k independent Exp(mu) phases, E[X] = k / mu.
+// C^2 = 1/k, so it models low-variability sizes.
+struct ErlangDist {
+    int k;
+    double mu;
+    double phaseMean, mean;
+    ErlangDist(int k, double mu)
+        : k(k), mu(mu), phaseMean(1.0 / mu), mean(k / mu) {
+        if (k < 1) {
+            throw std::invalid_argument("ErlangDist k must be >= 1, got " +
+                                        std::to_string(k));
+        }
+        requirePositive(mu, "ErlangDist mu");
+    }
+
+    double sample(Rng &rng) const {
+        double sum = 0.0;
+        for (int i = 0; i < k; ++i) sum += rng.exponential();
+        return phaseMean * sum;
+    }
+};
 
-inline double sample(Distribution &dist, std::mt19937_64 &rng) {
+// exp(N(mu, sigma^2)), parameterized like random.lognormvariate.  The
+// normal variate comes from Box-Muller on two uniforms; the second normal
+// of the pair is dropped so the distribution stays stateless.
+struct LognormalDist {
+    double mu, sigma, mean;
+    LognormalDist(double mu, double sigma)
+        : mu(mu), sigma(sigma), mean(std::exp(mu + 0.5 * sigma * sigma)) {
+        if (!(sigma >= 0.0) || !std::isfinite(sigma) || !std::isfinite(mu)) {
+            throw std::invalid_argument(
+                "LognormalDist needs finite mu and sigma >= 0, got sigma " +
+                std::to_string(sigma));
+        }
+    }
+
+    double sample(Rng &rng) const {
+        constexpr double two_pi = 6.283185307179586;
+        double r = std::sqrt(-2.0 * std::log(1.0 - rng.uniform()));
+        double z = r * std::cos(two_pi * rng.uniform());
+        return std::exp(mu + sigma * z);
+    }
+};
+
+// Weibull with the given shape and scale: scale * E^(1/shape) for a
+// standard exponential E.  shape < 1 is heavy-tailed, shape = 1 is
+// exponential with mean `scale`.
+struct WeibullDist {
+    double shape, scale, invShape, mean;
+    WeibullDist(double shape, double scale = 1.0)
+        : shape(shape), scale(scale), invShape(1.0 / shape),
+          mean(scale * std::tgamma(1.0 + 1.0 / shape)) {
+        requirePositive(shape, "WeibullDist shape");
+        requirePositive(scale, "WeibullDist scale");
+    }
+
+    double sample(Rng &rng) const {
+        return scale * std::pow(rng.exponential(), invShape);
+    }
+};
+
+// Always `value`; D in Kendall notation (M/D/1).  Draws no random numbers.
+struct DeterministicDist {
+    double value, mean;
+    explicit DeterministicDist(double value) : value(value), mean(value) {
+        if (!(value >= 0.0) || !std::isfinite(value)) {
+            throw std::invalid_argument(
+                "DeterministicDist value must be finite and non-negative, "
+                "got " + std::to_string(value));
+        }
+    }
+
+    double sample(Rng &) const { return value; }
+};
+
+// -- Data-driven families -----------------------------------------------------
+
+// Resamples observed values.  The inverse of their empirical CDF is the
+// sorted sample itself, so a draw is one uniform and one table lookup,
+// whatever the sample size.  With `interpolate`, draws are spread linearly
+// between adjacent order statistics (a continuous distribution on
+// [min, max]) instead of repeating the observations exactly.
+//
+// The sorted table is shared by every copy, so cloning servers for
+// replications is cheap; wrapSorted() uses an already-sorted buffer in
+// place, kept alive by `owner`.
+struct EmpiricalDist {
+    std::shared_ptr<const void> owner;
+    const double* sorted = nullptr;
+    size_t n = 0;
+    bool interpolate = false;
+    double mean = 0.0;
+
+    EmpiricalDist(const double* values, size_t n, bool interpolate = false)
+        : n(n), interpolate(interpolate) {
+        auto table = std::make_shared<std::vector<double>>(values, values + n);
+        std::sort(table->begin(), table->end());
+        sorted = table->data();
+        owner = std::move(table);
+        validate();
+    }
+
+    static EmpiricalDist wrapSorted(const double* values, size_t n,
+                                    std::shared_ptr<const void> owner,
+                                    bool interpolate = false) {
+        return EmpiricalDist(values, n, std::move(owner), interpolate);
+    }
+
+    static bool isSorted(const double* values, size_t n) {
+        return std::is_sorted(values, values + n);
+    }
+
+    double sample(Rng &rng) const {
+        if (!interpolate) {
+            size_t i = static_cast<size_t>(rng.uniform() * n);
+            return sorted[i < n ? i : n - 1];
+        }
+        double x = rng.uniform() * static_cast<double>(n - 1);
+        size_t i = static_cast<size_t>(x);
+        if (i + 1 >= n) return sorted[n - 1];
+        return sorted[i] + (x - static_cast<double>(i)) *
+                               (sorted[i + 1] - sorted[i]);
+    }
+
+private:
+    EmpiricalDist(const double* values, size_t n,
+                  std::shared_ptr<const void> owner, bool interpolate)
+        : owner(std::move(owner)), sorted(values), n(n),
+          interpolate(interpolate) {
+        validate();
+    }
+
+    // Sizes and interarrival times: finite and non-negative.
+    void validate() {
+        if (n == 0) {
+            throw std::invalid_argument("EmpiricalDist needs at least one value");
+        }
+        if (!(sorted[0] >= 0.0) || !std::isfinite(sorted[n - 1])) {
+            throw std::invalid_argument(
+                "EmpiricalDist values must be finite and non-negative");
+        }
+        double sum = 0.0;
+        for (size_t i = 0; i < n; ++i) sum += sorted[i];
+        mean = sum / static_cast<double>(n);
+    }
+};
+
+// Replays one column of a recorded trace, e.g. measured interarrival
+// times or job sizes.  The file holds packed native-endian float64
+// records of `n_columns` values each, starting `offset` bytes in, as
+// written by np.column_stack([...]).tofile(path).  Each draw returns the
+// column's value in the next record, wrapping around at the end; every run
+// replays from the first record (see rewind()), so a replayed stream does
+// not vary between replications.  The mapping is shared by all copies and
+// read sequentially; each copy keeps its own cursor.
+struct TraceDist {
+    std::shared_ptr<const MappedFile> file;
+    const double* values = nullptr;
+    size_t stride = 1;  // doubles per record
+    size_t n = 0;       // records
+    mutable size_t pos = 0;
+
+    explicit TraceDist(const std::string& path, int column = 0,
+                       int n_columns = 1, size_t offset = 0) {
+        if (n_columns < 1 || column < 0 || column >= n_columns) {
+            throw std::invalid_argument(
+                "TraceDist column must be in [0, n_columns), got column " +
+                std::to_string(column) + " of " + std::to_string(n_columns));
+        }
+        if (offset % sizeof(double) != 0) {
+            throw std::invalid_argument(
+                "TraceDist offset must be a multiple of 8, got " +
+                std::to_string(offset));
+        }
+        file = std::make_shared<const MappedFile>(path);
+        size_t record = sizeof(double) * static_cast<size_t>(n_columns);
+        size_t bytes = file->size() >= offset ? file->size() - offset : 0;
+        if (bytes == 0 || bytes % record != 0) {
+            throw std::invalid_argument(
+                "trace '" + path + "' does not hold a whole, non-zero number "
+                "of " + std::to_string(n_columns) + "-column float64 records");
+        }
+        stride = static_cast<size_t>(n_columns);
+        n = bytes / record;
+        values = reinterpret_cast<const double*>(file->data() + offset) +
+                 column;
+    }
+
+    double sample(Rng &) const {
+        double v = values[pos * stride];
+        if (++pos == n) pos = 0;
+        return v;
+    }
+};
+
+// Adding a family: define it above, list it here, and register its Python
+// class in bindings.cpp; conversion from Python picks it up from the
+// variant.
+using Distribution = std::variant<ExponentialDist, UniformDist,
+                                  BoundedParetoDist, HyperExponentialDist,
+                                  ErlangDist, LognormalDist, WeibullDist,
+                                  DeterministicDist, EmpiricalDist, TraceDist>;
+
+inline double sample(Distribution &dist, Rng &rng) {
     return std::visit([&rng](auto &d) { return d.sample(rng); }, dist);
 }
 
+// Concrete distributions skip the variant dispatch entirely, letting the
+// specialized engine inline the sampler.
+template <class Dist>
+inline double sample(const Dist &dist, Rng &rng) {
+    return dist.sample(rng);
+}
+
+// Restart a trace replay at its first record; a no-op for random families.
+// Servers rewind their size distributions on reset() and traffic sources
+// their arrival distributions at the start of a run.
+template <class Dist>
+inline void rewind(Dist &) {}
+
+inline void rewind(TraceDist &dist) { dist.pos = 0; }
+
+inline void rewind(Distribution &dist) {
+    std::visit([](auto &d) { rewind(d); }, dist);
+}
+
+// Dynamic state for snapshots: a trace's cursor; nothing for the random
+// families, whose parameters belong to the configuration.
+template <class Dist>
+inline void saveState(BinaryWriter &, const Dist &) {}
+
+template <class Dist>
+inline void loadState(BinaryReader &, Dist &) {}
+
+inline void saveState(BinaryWriter &w, const TraceDist &dist) {
+    w.put<uint64_t>(dist.pos);
+}
+
+inline void loadState(BinaryReader &r, TraceDist &dist) {
+    auto pos = r.get<uint64_t>();
+    if (pos >= dist.n) BinaryReader::corrupt();
+    dist.pos = static_cast<size_t>(pos);
+}
+
+inline void saveState(BinaryWriter &w, const Distribution &dist) {
+    w.put<uint64_t>(dist.index());
+    std::visit([&](const auto &d) { saveState(w, d); }, dist);
+}
+
+inline void loadState(BinaryReader &r, Distribution &dist) {
+    if (r.get<uint64_t>() != dist.index()) {
+        throw std::invalid_argument(
+            "snapshot distribution family does not match this system");
+    }
+    std::visit([&](auto &d) { loadState(r, d); }, dist);
+}
+
+// Invoke fn(concrete) if `dist` holds one of the families the specialized
+// engine is instantiated for; returns false (without calling fn) otherwise.
+template <class Fn>
+inline bool visitCommon(const Distribution &dist, Fn &&fn) {
+    if (auto *d = std::get_if<ExponentialDist>(&dist)) { fn(*d); return true; }
+    if (auto *d = std::get_if<UniformDist>(&dist)) { fn(*d); return true; }
+    if (auto *d = std::get_if<BoundedParetoDist>(&dist)) { fn(*d); return true; }
+    return false;
+}
+
 }  // namespace queue_sim
@@ -0,0 +1,727 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "batch_means.hpp"
+#include "distributions.hpp"
+#include "event_calendar.hpp"
+#include "event_log.hpp"
+#include "job_pool.hpp"
+#include "profile.hpp"
+#include "quantile_sketch.hpp"
+#include "response_times.hpp"
+#include "rng.hpp"
+#include "routing.hpp"
+#include "server.hpp"
+#include "stats.hpp"
+#include "thread_pool.hpp"
+#include "traffic.hpp"
+
+namespace queue_sim {
+
+// A job finished at `server` during the current event, still to be
+// routed.
+struct Completion {
+    int server;
+    JobId job;
+};
+
+// Scratch storage owned by a run and reused across its events (and, in
+// replicate(), across every replication on a thread), so the steady-state
+// event loop never touches the allocator.
+struct RunScratch {
+    EventCalendar calendar;
+    std::vector<Completion> completed;
+    JobPool jobs;
+    // Common-random-number substreams: sizes at server i in streams[2i],
+    // routing out of it in streams[2i + 1].  Empty unless a run uses CRN.
+    std::vector<Rng> streams;
+
+    void reset(int n_servers) {
+        calendar.reset(n_servers);
+        jobs.reset();
+        completed.clear();
+        // Capacity persists across events; size it for the common case.
+        completed.reserve(n_servers);
+    }
+};
+
+struct ReplicationRawResult {
+    std::vector<double> raw_N;
+    std::vector<double> raw_T;
+    // Per-replication, per-server statistics (server_stats[rep][server]).
+    std::vector<std::vector<ServerStats>> server_stats;
+    // Per-replication, per-class statistics; empty for single-class runs.
+    std::vector<std::vector<ClassStats>> class_stats;
+    // Per-replication traces, indexed like raw_*; empty unless requested.
+    std::vector<ResponseTimes> response_times;
+    std::vector<std::shared_ptr<EventLog>> event_logs;
+    // Per-replication response-time sketches, and all of them merged in
+    // replication order.
+    std::vector<ResponseTimeSketch> sketches;
+    ResponseTimeSketch merged_sketch;
+    bool cancelled = false;  // stopped early; fields hold finished reps only
+    bool converged = false;  // a StoppingRule's target was met
+};
+
+// Sequential stopping for replicate(): run min_replications, then
+// further waves of wave_size, until the `confidence`-level interval for
+// E[T] has half-width at most rel_half_width * |mean T|, or the
+// replication budget is spent.  Every wave is a parallel replicate()
+// over the next block of replication indices, so stopping after n
+// replications gives exactly the first n of a fixed-size run.
+struct StoppingRule {
+    double rel_half_width = 0.05;
+    double confidence = 0.95;
+    int min_replications = 10;
+    int wave_size = 10;
+
+    void validate() const {
+        if (!(rel_half_width > 0.0)) {
+            throw std::invalid_argument(
+                "rel_half_width must be positive, got " +
+                std::to_string(rel_half_width));
+        }
+        if (!(confidence > 0.0 && confidence < 1.0)) {
+            throw std::invalid_argument(
+                "confidence must be in (0, 1), got " +
+                std::to_string(confidence));
+        }
+        if (min_replications < 2) {
+            throw std::invalid_argument(
+                "min_replications must be >= 2, got " +
+                std::to_string(min_replications));
+        }
+        if (wave_size < 1) {
+            throw std::invalid_argument(
+                "wave_size must be >= 1, got " + std::to_string(wave_size));
+        }
+    }
+
+    bool satisfied(const std::vector<double>& raw_T) const {
+        if (raw_T.size() < 2) return false;
+        return ciHalfWidth(raw_T, confidence) <=
+               rel_half_width * std::abs(sampleMean(raw_T));
+    }
+};
+
+// Shared between a running replicate() and other threads: `cancel` asks
+// it to stop, `done`/`total` report how far it has got.  Copies start
+// fresh, so the owning QueueSystem stays copyable.
+struct ReplicationControl {
+    std::atomic<bool> cancel{false};
+    std::atomic<int> done{0};
+    std::atomic<int> total{0};
+
+    ReplicationControl() = default;
+    ReplicationControl(const ReplicationControl&) {}
+    ReplicationControl& operator=(const ReplicationControl&) { return *this; }
+};
+
+using ProgressFn = std::function<void(int done, int total)>;
+
+// The event loop, shared by QueueSystem (servers behind virtual dispatch)
+// and QueueSystemT (one concrete, `final` policy type).  Everything is
+// templated on the server type `Srv` and the arrival distribution, so
+// with a concrete policy the compiler inlines update()/arrival() and the
+// size/arrival samplers straight into the loop.
+struct SimEngine {
+    template <class Srv>
+    static std::vector<Srv*> handles(std::vector<std::shared_ptr<Srv>>& v) {
+        std::vector<Srv*> out;
+        out.reserve(v.size());
+        for (auto& s : v) out.push_back(s.get());
+        return out;
+    }
+
+    template <class Srv>
+    static std::vector<Srv*> handles(std::vector<Srv>& v) {
+        std::vector<Srv*> out;
+        out.reserve(v.size());
+        for (auto& s : v) out.push_back(&s);
+        return out;
+    }
+
+    // Deliver `job` to server `dest` at absolute time `now`.  The server
+    // is first brought forward to `now` (it is only touched lazily); if
+    // that advance itself finishes a job, it is appended to `completed` so
+    // the caller routes it.  Returns false if the job was rejected by a
+    // full buffer, in which case its record is released.
+    template <class Srv>
+    static bool admit(const std::vector<Srv*>& srvs,
+                      EventCalendar& calendar, int dest, double now,
+                      JobId job, std::vector<Completion>& completed) {
+        Srv& s = *srvs[dest];
+        double dt = now - s.clock;
+        s.accumulate(dt);
+        if (s.update(dt)) {
+            completed.push_back({dest, s._last_job});
+        }
+        s.num_arrivals += 1;
+        bool accepted = !s.is_full();
+        if (accepted) {
+            (*s.pool)[job].visits += 1;
+            s.arrival(job);
+            if (s.state > s.stats.max_state) s.stats.max_state = s.state;
+        } else {
+            s.num_rejected += 1;
+            s.pool->release(job);
+        }
+        calendar.update(dest, s.nextEventTime());
+        return accepted;
+    }
+
+    // Fire the earliest scheduled server event (a completion, or an FB
+    // level crossing).  Advancing by the server's own TTNC drives it to
+    // exactly zero, so the event is never missed to rounding.
+    template <class Srv>
+    static void fireNext(const std::vector<Srv*>& srvs,
+                         EventCalendar& calendar,
+                         std::vector<Completion>& completed) {
+        int idx = calendar.top();
+        Srv& s = *srvs[idx];
+        s.accumulate(s.TTNC);
+        if (s.update(s.TTNC)) {
+            completed.push_back({idx, s._last_job});
+        }
+        calendar.update(idx, s.nextEventTime());
+    }
+
+    // Cooperative cancellation: `stop` is polled every 4096 events so the
+    // check costs nothing measurable in the hot loop.  A stopped run
+    // returns early with meaningless estimates; callers discard them.
+    static bool stopRequested(const std::atomic<bool>* stop, unsigned& polls) {
+        return stop && (++polls & 4095u) == 0 &&
+               stop->load(std::memory_order_relaxed);
+    }
+
+    // One run of the classic single-class system: external arrivals into
+    // server 0, routed by `routing`.
+    template <class Srv, class ArrivalDist>
+    static std::pair<double, double> sim_internal(
+            RunScratch& scratch,
+            const std::vector<Srv*>& srvs,
+            ArrivalDist arrival_dist,
+            const RoutingTable& routing,
+            int num_events,
+            uint64_t seed,
+            int warmup,
+            RngConfig rng_config = RngConfig(),
+            ResponseTimes* response_times = nullptr,
+            EventLog* event_log = nullptr,
+            ResponseTimeSketch* sketch = nullptr,
+            BatchMeans* batches = nullptr,
+            const std::atomic<bool>* stop = nullptr,
+            RunProfile* profile = nullptr) {
+        SingleClassTraffic<ArrivalDist> traffic(std::move(arrival_dist),
+                                                routing);
+        return simLoop(scratch, srvs, traffic, num_events, seed, warmup,
+                       rng_config, response_times, event_log, sketch, batches,
+                       stop, profile);
+    }
+
+    // The event loop proper, driven by a traffic source (see traffic.hpp)
+    // that supplies external arrivals, routing and per-class accounting.
+    // `profile` is filled in profiling builds only (see profile.hpp).
+    template <class Srv, class Traffic>
+    static std::pair<double, double> simLoop(
+            RunScratch& scratch,
+            const std::vector<Srv*>& srvs,
+            Traffic& traffic,
+            int num_events,
+            uint64_t seed,
+            int warmup,
+            RngConfig rng_config = RngConfig(),
+            ResponseTimes* response_times = nullptr,
+            EventLog* event_log = nullptr,
+            ResponseTimeSketch* sketch = nullptr,
+            BatchMeans* batches = nullptr,
+            const std::atomic<bool>* stop = nullptr,
+            RunProfile* profile = nullptr) {
+        const bool crn = rng_config.crn;
+        Rng rng(crn ? RngConfig::arrivalSeed(seed) : seed, rng_config.kind);
+        int n_servers = static_cast<int>(srvs.size());
+
+        // Servers keep their own clocks and are advanced only when they
+        // are the event target or receive a job; the calendar orders their
+        // absolute next-event times.  Job records live in the scratch pool
+        // for the whole run and move between servers by index.
+        scratch.reset(n_servers);
+        EventCalendar& calendar = scratch.calendar;
+        std::vector<Completion>& completed = scratch.completed;
+        JobPool& jobs = scratch.jobs;
+        Profiler prof(profile);
+        prof.start(srvs.size());
+
+        std::vector<Rng>& streams = scratch.streams;
+        if (crn) {
+            streams.resize(2 * static_cast<size_t>(n_servers));
+            for (int i = 0; i < n_servers; ++i) {
+                streams[2 * i].seed(RngConfig::sizeSeed(seed, i),
+                                    rng_config.kind);
+                streams[2 * i + 1].seed(RngConfig::routingSeed(seed, i),
+                                        rng_config.kind);
+            }
+        }
+        auto routeRng = [&](int from) -> Rng& {
+            return crn ? streams[2 * from + 1] : rng;
+        };
+
+        for (int i = 0; i < n_servers; ++i) {
+            srvs[i]->setRNG(crn ? &streams[2 * i] : &rng);
+            srvs[i]->setJobPool(&jobs);
+            srvs[i]->reset();
+        }
+
+        int num_completions = 0;
+        double now = 0.0;
+        traffic.start(rng);
+        int state = 0;
+        unsigned polls = 0;
+
+        // -- warmup phase (no accumulation) ----------------------------------
+        if (warmup > 0) {
+            int warmup_done = 0;
+            while (warmup_done < warmup && !stopRequested(stop, polls)) {
+                completed.clear();
+                if (calendar.topTime() <= traffic.nextTime()) {
+                    now = calendar.topTime();
+                    fireNext(srvs, calendar, completed);
+                    prof.fired(completed);
+                } else {
+                    now = traffic.nextTime();
+                    int cls = traffic.nextClass();
+                    int entry = traffic.entry(cls);
+                    if (admit(srvs, calendar, entry, now,
+                              jobs.acquire(now, cls), completed)) {
+                        state += 1;
+                        traffic.arrive(cls, now);
+                        prof.arrival(*srvs[entry], entry);
+                    } else {
+                        prof.rejectedArrival();
+                    }
+                    traffic.redraw(cls, now, rng);
+                }
+                for (size_t c = 0; c < completed.size(); ++c) {
+                    auto [idx, job] = completed[c];
+                    int cls = jobs[job].job_class;
+                    int dest = traffic.route(cls, idx, routeRng(idx));
+                    if (dest >= n_servers) {
+                        jobs.release(job);
+                        warmup_done += 1;
+                        state -= 1;
+                        traffic.leave(cls, now);
+                        prof.departure();
+                    } else if (!admit(srvs, calendar, dest, now, job,
+                                      completed)) {
+                        warmup_done += 1;
+                        state -= 1;
+                        traffic.leave(cls, now);
+                        prof.rejection();
+                    } else {
+                        prof.route(*srvs[dest], dest);
+                    }
+                }
+            }
+        }
+
+        // Clear per-server rejection counters and statistics so
+        // measurement reflects only the measurement phase.
+        for (Srv* s : srvs) {
+            s->num_rejected = 0;
+            s->num_arrivals = 0;
+            s->beginStats(now);
+        }
+        traffic.begin(now);
+        prof.beginMeasurement();
+
+        // -- measurement phase -----------------------------------------------
+        double area_n = 0.0;
+        double start = now;
+        double clock = 0.0;
+
+        // Next batch boundary, in completions; never reached without
+        // `batches`, so the loop pays one compare per event.
+        int batch_size = batches ? batches->begin(num_events) : 0;
+        int batch_end = batch_size > 0 ? batch_size
+                                       : std::numeric_limits<int>::max();
+        double batch_area = 0.0;
+        double batch_clock = 0.0;
+        int batch_done = 0;
+
+        while (num_completions < num_events) {
+            if (stopRequested(stop, polls)) break;
+            double t_next = std::min(calendar.topTime(), traffic.nextTime());
+            area_n += static_cast<double>(state) * (t_next - now);
+            now = t_next;
+            clock = now - start;
+
+            completed.clear();
+            if (calendar.topTime() <= traffic.nextTime()) {
+                fireNext(srvs, calendar, completed);
+                prof.fired(completed);
+            } else {
+                int cls = traffic.nextClass();
+                int entry = traffic.entry(cls);
+                if (admit(srvs, calendar, entry, now, jobs.acquire(now, cls),
+                          completed)) {
+                    state += 1;
+                    traffic.arrive(cls, now);
+                    prof.arrival(*srvs[entry], entry);
+                    if (event_log) {
+                        event_log->push(clock, EventLog::ARRIVAL, EventLog::EXTERNAL, entry, state);
+                    }
+                } else {
+                    traffic.reject(cls);
+                    prof.rejectedArrival();
+                    if (event_log) {
+                        event_log->push(clock, EventLog::REJECTION, EventLog::EXTERNAL, entry, state);
+                    }
+                }
+                traffic.redraw(cls, now, rng);
+            }
+
+            for (size_t c = 0; c < completed.size(); ++c) {
+                auto [idx, job] = completed[c];
+                int cls = jobs[job].job_class;
+                int dest = traffic.route(cls, idx, routeRng(idx));
+                ServerStats& st = srvs[idx]->stats;
+                st.completions += 1;
+                st.response_sum += srvs[idx]->_last_response_time;
+                if (sketch) {
+                    sketch->per_server[idx].add(srvs[idx]->_last_response_time);
+                }
+                if (dest >= n_servers) {
+                    num_completions += 1;
+                    state -= 1;
+                    traffic.leave(cls, now);
+                    prof.departure();
+                    if (response_times || sketch) {
+                        const Job& j = jobs[job];
+                        double sojourn = now - j.entry;
+                        if (response_times) response_times->push(sojourn, j.visits);
+                        if (sketch) sketch->end_to_end.add(sojourn);
+                    }
+                    if (event_log) {
+                        event_log->push(clock, EventLog::DEPARTURE, idx, EventLog::SYSTEM_EXIT, state);
+                    }
+                    jobs.release(job);
+                } else if (!admit(srvs, calendar, dest, now, job, completed)) {
+                    num_completions += 1;
+                    state -= 1;
+                    traffic.leave(cls, now);
+                    traffic.reject(cls);
+                    prof.rejection();
+                    if (event_log) {
+                        event_log->push(clock, EventLog::REJECTION, idx, dest, state);
+                    }
+                } else {
+                    prof.route(*srvs[dest], dest);
+                    if (event_log) {
+                        event_log->push(clock, EventLog::ROUTE, idx, dest, state);
+                    }
+                }
+            }
+
+            if (num_completions >= batch_end) {
+                batches->add(area_n - batch_area, clock - batch_clock,
+                             num_completions - batch_done);
+                batch_area = area_n;
+                batch_clock = clock;
+                batch_done = num_completions;
+                batch_end = batches->full() ? std::numeric_limits<int>::max()
+                                            : batch_end + batch_size;
+            }
+        }
+
+        for (Srv* s : srvs) s->finishStats(now, clock);
+        traffic.finish(now, clock);
+        prof.finish(rng, crn ? &streams : nullptr, jobs, completed, event_log,
+                    srvs);
+
+        double mean_n = area_n / clock;
+        double mean_t = area_n / std::max(1, num_completions);
+        return {mean_n, mean_t};
+    }
+
+    // Scheduler behind replicate() and sweep(): runs tasks 0..n_tasks-1
+    // on the shared thread pool, handing indices out from an atomic
+    // counter.  `make_worker()` is called once per pool thread and returns
+    // that thread's `bool(int i)` runner, which holds any thread-private
+    // state (servers, scratch) and returns false if `ctl.cancel` cut task
+    // i short.  The calling thread only coordinates, calling
+    // `progress(done, n_tasks)` as tasks finish; a worker's exception is
+    // rethrown here.  Returns a finished flag per task.
+    template <class MakeWorker>
+    static std::vector<char> runTasks(int n_tasks, int n_threads,
+                                      ReplicationControl& ctl,
+                                      const ProgressFn& progress,
+                                      MakeWorker make_worker) {
+        std::vector<char> finished(n_tasks, 0);
+        std::atomic<int> next{0};
+        std::mutex mutex;
+        std::condition_variable changed;
+        int done = 0;
+        int active = ThreadPool::resolveThreads(n_threads, n_tasks);
+        std::exception_ptr error;
+        std::atomic<bool>& stop = ctl.cancel;
+
+        auto worker = [&] {
+            try {
+                auto run = make_worker();
+                while (!stop.load(std::memory_order_relaxed)) {
+                    int i = next.fetch_add(1);
+                    if (i >= n_tasks) break;
+                    if (!run(i)) break;
+                    finished[i] = 1;
+                    ctl.done.fetch_add(1);
+                    {
+                        std::lock_guard<std::mutex> lk(mutex);
+                        ++done;
+                    }
+                    changed.notify_all();
+                }
+            } catch (...) {
+                std::lock_guard<std::mutex> lk(mutex);
+                if (!error) error = std::current_exception();
+                stop.store(true);
+            }
+            // Notify under the lock: once `active` hits zero the caller may
+            // return and destroy `changed`.
+            std::lock_guard<std::mutex> lk(mutex);
+            --active;
+            changed.notify_all();
+        };
+
+        ThreadPool::instance().submit(active, worker);
+
+        std::unique_lock<std::mutex> lk(mutex);
+        int reported = 0;
+        while (true) {
+            changed.wait(lk, [&] { return active == 0 || done != reported; });
+            if (done != reported && progress) {
+                reported = done;
+                lk.unlock();
+                try {
+                    progress(reported, n_tasks);
+                } catch (...) {
+                    stop.store(true);
+                    lk.lock();
+                    changed.wait(lk, [&] { return active == 0; });
+                    throw;
+                }
+                lk.lock();
+            } else {
+                reported = done;
+            }
+            if (active == 0 && done == reported) break;
+        }
+        lk.unlock();
+
+        if (error) std::rethrow_exception(error);
+        return finished;
+    }
+
+    // Run n_replications independent replications on the shared thread
+    // pool.  Workers pull replication indices from an atomic counter, so a
+    // long (e.g. heavy-tailed) replication never leaves other threads idle
+    // behind a static partition.  `make_servers()` returns a fresh,
+    // thread-private server container (cloned shared_ptrs or concrete
+    // policy values); per-replication seeds make the result independent
+    // of scheduling.
+    //
+    // The calling thread only coordinates: it calls `progress(done, total)`
+    // each time replications finish.  With `track_response_times` /
+    // `track_events` every replication records into its own preallocated
+    // slot of the result, so workers never share a buffer; visit counts
+    // come with the response times only under `track_visits`.  Likewise a
+    // non-null `sketch_prototype` (an empty sketch of the right accuracy
+    // and server count) gives each replication its own copy to fill; the
+    // copies are merged once all workers are done.  A non-zero
+    // `event_window.capacity` bounds each replication's event log.
+    //
+    // `traffic` is copied for each worker thread (see traffic.hpp); per-class
+    // results land in `class_stats` when it reports any.
+    //
+    // With a `stopping` rule, n_replications is only the budget:
+    // replications run in waves until the confidence interval for E[T]
+    // is narrow enough (see StoppingRule).
+    //
+    // Setting `control->cancel` (or
+    // throwing from `progress`) stops the workers cooperatively; the
+    // result then holds only the replications that ran to completion, in
+    // index order, with `cancelled` set.
+    template <class MakeServers, class Traffic>
+    static ReplicationRawResult replicate(
+            MakeServers make_servers,
+            const Traffic& traffic,
+            int n_replications,
+            int num_events,
+            uint64_t base_seed,
+            int warmup,
+            int n_threads,
+            RngConfig rng_config = RngConfig(),
+            bool track_response_times = false,
+            bool track_visits = false,
+            bool track_events = false,
+            const ResponseTimeSketch* sketch_prototype = nullptr,
+            const EventWindow& event_window = EventWindow(),
+            const StoppingRule* stopping = nullptr,
+            ReplicationControl* control = nullptr,
+            const ProgressFn& progress = ProgressFn()) {
+        if (stopping) stopping->validate();
+        ReplicationControl local_control;
+        ReplicationControl& ctl = control ? *control : local_control;
+        ctl.cancel.store(false);
+        ctl.done.store(0);
+        ctl.total.store(std::max(0, n_replications));
+
+        ReplicationRawResult result;
+        if (n_replications <= 0) return result;
+        if (sketch_prototype) result.merged_sketch = *sketch_prototype;
+        bool per_class = traffic.classStats() != nullptr;
+
+        // Replications [first, first + count) as one parallel wave,
+        // appended to `result`.
+        auto runWave = [&](int first, int count) {
+            int end = first + count;
+            result.raw_N.resize(end);
+            result.raw_T.resize(end);
+            result.server_stats.resize(end);
+            if (per_class) result.class_stats.resize(end);
+            if (track_response_times) result.response_times.resize(end);
+            if (track_events) result.event_logs.resize(end);
+            if (sketch_prototype) result.sketches.resize(end, *sketch_prototype);
+
+            std::atomic<bool>& stop = ctl.cancel;
+            ProgressFn wave_progress;
+            if (progress) {
+                wave_progress = [&](int done, int) {
+                    progress(first + done, n_replications);
+                };
+            }
+            std::vector<char> finished = runTasks(
+                count, n_threads, ctl, wave_progress, [&] {
+                    // Clone servers once for this thread
+                    return [&, local_servers = make_servers(),
+                            local_traffic = traffic,
+                            scratch = RunScratch()](int k) mutable {
+                        int i = first + k;
+                        auto srvs = handles(local_servers);
+                        uint64_t rep_seed =
+                            derive_seed(base_seed, static_cast<uint64_t>(i));
+                        ResponseTimes* rt = nullptr;
+                        if (track_response_times) {
+                            rt = &result.response_times[i];
+                            *rt = ResponseTimes::allocate(num_events,
+                                                          track_visits);
+                        }
+                        EventLog* el = nullptr;
+                        if (track_events) {
+                            result.event_logs[i] = std::make_shared<EventLog>();
+                            el = result.event_logs[i].get();
+                            if (event_window.capacity) {
+                                el->keepLast(event_window);
+                            } else {
+                                el->reserve(static_cast<size_t>(num_events) * 2);
+                            }
+                        }
+                        ResponseTimeSketch* sk =
+                            sketch_prototype ? &result.sketches[i] : nullptr;
+                        auto [n, t] = simLoop(
+                            scratch, srvs, local_traffic,
+                            num_events, rep_seed, warmup, rng_config,
+                            rt, el, sk, nullptr, &stop);
+                        if (stop.load()) {
+                            // Cut short; drop it and its traces.
+                            if (rt) *rt = ResponseTimes();
+                            if (el) result.event_logs[i].reset();
+                            return false;
+                        }
+                        if (el) el->finishWindow();
+                        result.raw_N[i] = n;
+                        result.raw_T[i] = t;
+                        auto& stats = result.server_stats[i];
+                        stats.clear();
+                        for (const auto* sv : srvs) stats.push_back(sv->stats);
+                        if (per_class) {
+                            result.class_stats[i] = *local_traffic.classStats();
+                        }
+                        return true;
+                    };
+                });
+            int done = static_cast<int>(
+                std::count(finished.begin(), finished.end(), 1));
+
+            if (done < count) {
+                size_t kept = first;
+                for (int k = 0; k < count; ++k) {
+                    if (!finished[k]) continue;
+                    int i = first + k;
+                    result.raw_N[kept] = result.raw_N[i];
+                    result.raw_T[kept] = result.raw_T[i];
+                    result.server_stats[kept] = std::move(result.server_stats[i]);
+                    if (per_class) {
+                        result.class_stats[kept] = std::move(result.class_stats[i]);
+                    }
+                    if (track_response_times) {
+                        result.response_times[kept] =
+                            std::move(result.response_times[i]);
+                    }
+                    if (track_events) {
+                        result.event_logs[kept] = std::move(result.event_logs[i]);
+                    }
+                    if (sketch_prototype) {
+                        result.sketches[kept] = std::move(result.sketches[i]);
+                    }
+                    ++kept;
+                }
+                result.raw_N.resize(kept);
+                result.raw_T.resize(kept);
+                result.server_stats.resize(kept);
+                if (per_class) result.class_stats.resize(kept);
+                if (track_response_times) result.response_times.resize(kept);
+                if (track_events) result.event_logs.resize(kept);
+                if (sketch_prototype) result.sketches.resize(kept);
+                result.cancelled = true;
+            }
+        };
+
+        if (!stopping) {
+            runWave(0, n_replications);
+        } else {
+            // Waves have fixed sizes, so where the rule stops does not
+            // depend on n_threads.
+            int target = std::min(stopping->min_replications, n_replications);
+            while (true) {
+                int have = static_cast<int>(result.raw_T.size());
+                runWave(have, target - have);
+                if (result.cancelled) break;
+                if (stopping->satisfied(result.raw_T)) {
+                    result.converged = true;
+                    break;
+                }
+                if (target >= n_replications) break;
+                target = std::min(target + stopping->wave_size, n_replications);
+            }
+            ctl.total.store(static_cast<int>(result.raw_T.size()));
+        }
+        for (const auto& sk : result.sketches) result.merged_sketch.merge(sk);
+        return result;
+    }
+};
+
+}  // namespace queue_sim
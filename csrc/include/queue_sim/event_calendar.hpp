@@ -0,0 +1,89 @@
+#pragma once
+
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace queue_sim {
+
+// Indexed binary min-heap of absolute event times, one slot per server.
+//
+// Each server owns exactly one entry (its next completion time, or +inf
+// when idle).  update() re-keys a single slot in O(log n), so the event
+// loop only touches servers that actually change state.
+class EventCalendar {
+public:
+    void reset(int n) {
+        times.assign(n, std::numeric_limits<double>::infinity());
+        heap.resize(n);
+        pos.resize(n);
+        for (int i = 0; i < n; ++i) {
+            heap[i] = i;
+            pos[i] = i;
+        }
+    }
+
+    int size() const { return static_cast<int>(heap.size()); }
+
+    // Index of the slot with the earliest time.
+    int top() const { return heap[0]; }
+
+    double topTime() const {
+        return heap.empty() ? std::numeric_limits<double>::infinity()
+                            : times[heap[0]];
+    }
+
+    double time(int slot) const { return times[slot]; }
+
+    void update(int slot, double t) {
+        double old = times[slot];
+        times[slot] = t;
+        if (t < old) {
+            siftUp(pos[slot]);
+        } else if (t > old) {
+            siftDown(pos[slot]);
+        }
+    }
+
+private:
+    std::vector<double> times;  // slot -> absolute event time
+    std::vector<int> heap;      // heap position -> slot
+    std::vector<int> pos;       // slot -> heap position
+
+    bool less(int a, int b) const {
+        // Break ties by slot index so simultaneous events resolve in
+        // server order, matching the old linear sweep.
+        double ta = times[heap[a]], tb = times[heap[b]];
+        return ta < tb || (ta == tb && heap[a] < heap[b]);
+    }
+
+    void swap(int a, int b) {
+        std::swap(heap[a], heap[b]);
+        pos[heap[a]] = a;
+        pos[heap[b]] = b;
+    }
+
+    void siftUp(int i) {
+        while (i > 0) {
+            int parent = (i - 1) / 2;
+            if (!less(i, parent)) break;
+            swap(i, parent);
+            i = parent;
+        }
+    }
+
+    void siftDown(int i) {
+        int n = static_cast<int>(heap.size());
+        while (true) {
+            int l = 2 * i + 1;
+            if (l >= n) break;
+            int m = l;
+            if (l + 1 < n && less(l + 1, l)) m = l + 1;
+            if (!less(m, i)) break;
+            swap(i, m);
+            i = m;
+        }
+    }
+};
+
+}  // namespace queue_sim
@@ -1,39 +1,131 @@
 #pragma once
-#include <string>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <utility>
 #include <vector>
 
 namespace queue_sim {
 
+// Bounded ("windowed") event capture: keep only the last `capacity`
+// events, and copy that window out whenever a trigger fires.  A zero
+// capacity keeps the whole trace.
+struct EventWindow {
+    size_t capacity = 0;
+    // Fire when the system state rises to at least this value from below
+    // (negative: never).
+    int32_t trigger_state = -1;
+    // Fire on a rejection (external or routed).
+    bool trigger_on_rejection = false;
+    // Take the snapshot this many events after the trigger, so it shows
+    // what followed as well as what led up to it.
+    size_t post_trigger_events = 0;
+    // Stop snapshotting after this many, bounding memory under overload.
+    size_t max_snapshots = 16;
+};
+
+// Struct-of-arrays event trace with fixed-width columns (21 bytes per
+// event), so long traces stay compact and each column can be handed to
+// NumPy without copying.
 struct EventLog {
-    // -- Event kind constants (match Python EventLog) --
-    static constexpr const char* ARRIVAL    = "arrival";
-    static constexpr const char* DEPARTURE  = "departure";
-    static constexpr const char* ROUTE      = "route";
-    static constexpr const char* REJECTION  = "rejection";
+    // -- Event kinds (uint8 codes; KIND_NAMES gives the Python spelling) --
+    enum Kind : uint8_t {
+        ARRIVAL   = 0,
+        DEPARTURE = 1,
+        ROUTE     = 2,
+        REJECTION = 3,
+    };
+    static constexpr const char* KIND_NAMES[] = {
+        "arrival", "departure", "route", "rejection"};
 
     // -- Special server indices --
-    static constexpr int EXTERNAL    = -1;
-    static constexpr int SYSTEM_EXIT = -1;
+    static constexpr int32_t EXTERNAL    = -1;
+    static constexpr int32_t SYSTEM_EXIT = -1;
 
     std::vector<double> times;
-    std::vector<std::string> kinds;
-    std::vector<int> from_servers;
-    std::vector<int> to_servers;
-    std::vector<int> states;
+    std::vector<uint8_t> kinds;
+    std::vector<int32_t> from_servers;
+    std::vector<int32_t> to_servers;
+    std::vector<int32_t> states;
+
+    // A window copied out when a trigger fired on the `trigger_index`-th
+    // event pushed (at `trigger_time`).
+    struct Snapshot {
+        double trigger_time;
+        uint64_t trigger_index;
+        std::shared_ptr<EventLog> events;
+    };
+    std::vector<Snapshot> snapshots;
+
+    // Called with the buffered columns every `chunk_events` events (and
+    // by flush()); the columns are cleared afterwards.  Lets a run stream
+    // its trace to disk in fixed-size chunks instead of holding it all.
+    using ChunkFn = std::function<void(const EventLog&)>;
 
-    void push(double time, const char* kind,
-              int from_server, int to_server, int state) {
+    void push(double time, Kind kind,
+              int32_t from_server, int32_t to_server, int32_t state) {
+        if (window.capacity) {
+            pushWindowed(time, kind, from_server, to_server, state);
+            return;
+        }
         times.push_back(time);
-        kinds.emplace_back(kind);
+        kinds.push_back(kind);
         from_servers.push_back(from_server);
         to_servers.push_back(to_server);
         states.push_back(state);
+        if (times.size() >= flush_at) flush();
+    }
+
+    // Route events to `on_chunk` every `chunk_events` events; an empty
+    // function restores plain in-memory logging.
+    void streamTo(ChunkFn on_chunk, size_t chunk_events) {
+        window = EventWindow();
+        sink = std::move(on_chunk);
+        flush_at = sink ? std::max<size_t>(chunk_events, 1)
+                        : std::numeric_limits<size_t>::max();
+        if (sink) reserve(flush_at);
+    }
+
+    // Hand any buffered events to the sink.
+    void flush() {
+        if (!sink || times.empty()) return;
+        sink(*this);
+        clearColumns();
+    }
+
+    // Keep only the last `w.capacity` events, snapshotting on `w`'s
+    // triggers; call finishWindow() once the run is over.
+    void keepLast(const EventWindow& w) {
+        streamTo(nullptr, 0);
+        clear();
+        window = w;
+        if (window.capacity) {
+            // The triggering event must still be in the snapshot.
+            window.post_trigger_events =
+                std::min(window.post_trigger_events, window.capacity - 1);
+            reserve(window.capacity);
+        }
+    }
+
+    // Put the ring back in time order (oldest first) and take a snapshot
+    // still waiting for its post-trigger events.
+    void finishWindow() {
+        if (!window.capacity) return;
+        if (pending) takeSnapshot();
+        rotateColumns(head);
+        head = 0;
     }
 
     void clear() {
-        times.clear(); kinds.clear();
-        from_servers.clear(); to_servers.clear();
-        states.clear();
+        clearColumns();
+        snapshots.clear();
+        pushed = 0;
+        pending = 0;
+        armed_at = 0;
+        last_state = 0;
     }
 
     void reserve(size_t n) {
@@ -43,6 +135,94 @@ struct EventLog {
     }
 
     size_t size() const { return times.size(); }
+
+private:
+    ChunkFn sink;
+    size_t flush_at = std::numeric_limits<size_t>::max();
+
+    // -- Ring-buffer state --
+    EventWindow window;
+    size_t head = 0;          // slot of the oldest event once full
+    uint64_t pushed = 0;      // events seen since keepLast()
+    size_t pending = 0;       // events left before a deferred snapshot
+    uint64_t armed_at = 0;    // triggers ignored up to this many events
+    int32_t last_state = 0;
+    double trigger_time = 0.0;
+    uint64_t trigger_index = 0;
+
+    void clearColumns() {
+        times.clear(); kinds.clear();
+        from_servers.clear(); to_servers.clear();
+        states.clear();
+        head = 0;
+    }
+
+    void pushWindowed(double time, Kind kind,
+                      int32_t from_server, int32_t to_server, int32_t state) {
+        if (times.size() < window.capacity) {
+            times.push_back(time);
+            kinds.push_back(kind);
+            from_servers.push_back(from_server);
+            to_servers.push_back(to_server);
+            states.push_back(state);
+        } else {
+            times[head] = time;
+            kinds[head] = kind;
+            from_servers[head] = from_server;
+            to_servers[head] = to_server;
+            states[head] = state;
+            if (++head == window.capacity) head = 0;
+        }
+        ++pushed;
+
+        if (pending) {
+            if (--pending == 0) takeSnapshot();
+        } else if (pushed > armed_at &&
+                   snapshots.size() < window.max_snapshots) {
+            bool fire =
+                (window.trigger_on_rejection && kind == REJECTION) ||
+                (window.trigger_state >= 0 && state >= window.trigger_state &&
+                 last_state < window.trigger_state);
+            if (fire) {
+                trigger_time = time;
+                trigger_index = pushed - 1;
+                pending = window.post_trigger_events;
+                if (!pending) takeSnapshot();
+            }
+        }
+        last_state = state;
+    }
+
+    // Copy the window out in time order, then hold further triggers off
+    // until it has been completely overwritten, so snapshots never
+    // overlap.
+    void takeSnapshot() {
+        pending = 0;
+        auto snap = std::make_shared<EventLog>();
+        size_t n = times.size();
+        snap->reserve(n);
+        for (size_t k = 0; k < n; ++k) {
+            size_t i = head + k < n ? head + k : head + k - n;
+            snap->times.push_back(times[i]);
+            snap->kinds.push_back(kinds[i]);
+            snap->from_servers.push_back(from_servers[i]);
+            snap->to_servers.push_back(to_servers[i]);
+            snap->states.push_back(states[i]);
+        }
+        snapshots.push_back({trigger_time, trigger_index, std::move(snap)});
+        armed_at = pushed + window.capacity;
+    }
+
+    void rotateColumns(size_t first) {
+        if (first == 0) return;
+        std::rotate(times.begin(), times.begin() + first, times.end());
+        std::rotate(kinds.begin(), kinds.begin() + first, kinds.end());
+        std::rotate(from_servers.begin(), from_servers.begin() + first,
+                    from_servers.end());
+        std::rotate(to_servers.begin(), to_servers.begin() + first,
+                    to_servers.end());
+        std::rotate(states.begin(), states.begin() + first, states.end());
+    }
 };
 
 }  // namespace queue_sim
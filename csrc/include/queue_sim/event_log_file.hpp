@@ -0,0 +1,136 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "event_log.hpp"
+
+namespace queue_sim {
+
+// Append-only on-disk event log: a self-describing header followed by
+// packed fixed-width records, one per event, in native byte order.
+//
+//   offset  size  field
+//        0     8  magic "QSEVLOG\0"
+//        8     4  uint32 format version (1)
+//       12     4  uint32 header size = offset of the first record
+//       16     8  uint64 event count (written by close(); 0 if unfinished)
+//       24     4  uint32 record size (21)
+//       28     4  uint32 number of columns (5)
+//       32  24*n  per column: char name[16], char numpy typestr[4]
+//                 (e.g. "<f8"), uint32 offset within the record
+//
+// Records can be memory-mapped directly as a NumPy structured array
+// (queue_sim.event_log.MappedEventLog).  An unfinished file stays readable:
+// the record count is then the data size divided by the record size.
+class EventLogWriter {
+public:
+    static constexpr char MAGIC[8] = {'Q', 'S', 'E', 'V', 'L', 'O', 'G', '\0'};
+    static constexpr uint32_t VERSION = 1;
+    static constexpr uint32_t RECORD_BYTES = 8 + 1 + 4 + 4 + 4;
+
+    explicit EventLogWriter(const std::string& path) : path(path) {
+        file = std::fopen(path.c_str(), "wb");
+        if (!file) {
+            throw std::runtime_error("cannot open event log file '" + path +
+                                     "' for writing");
+        }
+        try {
+            writeHeader();
+        } catch (...) {
+            std::fclose(file);
+            throw;
+        }
+    }
+
+    EventLogWriter(const EventLogWriter&) = delete;
+    EventLogWriter& operator=(const EventLogWriter&) = delete;
+
+    ~EventLogWriter() {
+        if (file) std::fclose(file);
+    }
+
+    // Append every event buffered in `chunk`.
+    void write(const EventLog& chunk) {
+        size_t n = chunk.size();
+        buffer.resize(n * RECORD_BYTES);
+        char* out = buffer.data();
+        for (size_t i = 0; i < n; ++i, out += RECORD_BYTES) {
+            std::memcpy(out, &chunk.times[i], 8);
+            out[8] = static_cast<char>(chunk.kinds[i]);
+            std::memcpy(out + 9, &chunk.from_servers[i], 4);
+            std::memcpy(out + 13, &chunk.to_servers[i], 4);
+            std::memcpy(out + 17, &chunk.states[i], 4);
+        }
+        if (std::fwrite(buffer.data(), 1, buffer.size(), file) != buffer.size()) {
+            throw std::runtime_error("failed writing event log file '" + path + "'");
+        }
+        count += n;
+    }
+
+    // Record the final event count and close the file.
+    void close() {
+        if (!file) return;
+        bool ok = std::fseek(file, 16, SEEK_SET) == 0 &&
+                  std::fwrite(&count, sizeof(count), 1, file) == 1;
+        ok = std::fclose(file) == 0 && ok;
+        file = nullptr;
+        if (!ok) {
+            throw std::runtime_error("failed finishing event log file '" + path + "'");
+        }
+    }
+
+    uint64_t size() const { return count; }
+
+private:
+    std::string path;
+    std::FILE* file = nullptr;
+    uint64_t count = 0;
+    std::vector<char> buffer;
+
+    struct Column {
+        const char* name;
+        const char* typestr;  // byte-order character filled in at runtime
+        uint32_t offset;
+    };
+
+    void writeHeader() {
+        static const Column columns[] = {
+            {"time", "=f8", 0},
+            {"kind", "|u1", 8},
+            {"from_server", "=i4", 9},
+            {"to_server", "=i4", 13},
+            {"state", "=i4", 17},
+        };
+        const uint32_t n_columns = 5;
+        const uint32_t header_bytes = 32 + 24 * n_columns;
+        const uint16_t probe = 1;
+        const char order =
+            *reinterpret_cast<const char*>(&probe) == 1 ? '<' : '>';
+
+        std::vector<char> header(header_bytes, 0);
+        char* h = header.data();
+        std::memcpy(h, MAGIC, 8);
+        std::memcpy(h + 8, &VERSION, 4);
+        std::memcpy(h + 12, &header_bytes, 4);
+        std::memcpy(h + 16, &count, 8);
+        std::memcpy(h + 24, &RECORD_BYTES, 4);
+        std::memcpy(h + 28, &n_columns, 4);
+        for (uint32_t c = 0; c < n_columns; ++c) {
+            char* d = h + 32 + 24 * c;
+            std::strncpy(d, columns[c].name, 16);
+            std::memcpy(d + 16, columns[c].typestr, 3);
+            if (d[16] == '=') d[16] = order;
+            std::memcpy(d + 20, &columns[c].offset, 4);
+        }
+        if (std::fwrite(h, 1, header.size(), file) != header.size()) {
+            throw std::runtime_error("failed writing event log file '" + path + "'");
+        }
+    }
+};
+
+}  // namespace queue_sim
@@ -1,33 +1,123 @@
 #pragma once
 
 #include <algorithm>
+#include <functional>
 #include <limits>
+#include <memory>
+#include <string>
+#include <utility>
+#include <variant>
 #include <vector>
 
 #include "server.hpp"
 
 namespace queue_sim {
 
-class FB : public Server {
+template <class SizeDist>
+class BasicFB final : public Server {
 public:
-    struct Job {
-        double remaining;
+    SizeDist sizeDist;
+
+    // Jobs are grouped by attained service.  All jobs in a level have the
+    // same attained service, so only the level's counter advances; within
+    // a level the job with the smallest size finishes first.  A new job
+    // always has the least attained service, so levels form a stack:
+    // levels.back() is the group currently in service and attained
+    // service strictly increases towards levels.front().
+    using Entry = std::pair<double, JobId>;  // (size, job)
+
+    struct Level {
         double attained;
-        double arrivalTime;
+        std::vector<Entry> jobs;  // min-heap on size
     };
 
-    std::vector<Job> jobs;
+    std::vector<Level> levels;
+    // Emptied level heaps kept for reuse, so opening a level (which
+    // happens on most arrivals) does not allocate.
+    std::vector<std::vector<Entry>> spareHeaps;
+    // Whether the event TTNC counts down to is a completion (vs. the
+    // active level catching up with the next one).
+    bool nextIsCompletion = false;
 
-    explicit FB(Distribution sizeDist, int buffer_capacity = -1)
-        : Server(std::move(sizeDist), 1, buffer_capacity) {}
+    explicit BasicFB(SizeDist sizeDist, int buffer_capacity = -1)
+        : Server(1, buffer_capacity), sizeDist(std::move(sizeDist)) {}
 
     std::shared_ptr<Server> clone() const override {
-        return std::make_shared<FB>(sizeDist, buffer_capacity);
+        auto copy = std::make_shared<BasicFB>(sizeDist, buffer_capacity);
+        copy->class_size_dists = class_size_dists;
+        return copy;
+    }
+
+    std::shared_ptr<Server> cloneState() const override {
+        return std::make_shared<BasicFB>(*this);
+    }
+
+    void saveState(BinaryWriter& w) const override {
+        w.put(std::string("FB"));
+        Server::saveState(w);
+        queue_sim::saveState(w, sizeDist);
+        // Level heaps are written as laid out: merges iterate over them.
+        w.put<uint64_t>(levels.size());
+        for (const Level &level : levels) {
+            w.put(level.attained);
+            w.put<uint64_t>(level.jobs.size());
+            for (const Entry &e : level.jobs) {
+                w.put(e.first);
+                w.put(e.second);
+            }
+        }
+        w.put(nextIsCompletion);
+    }
+
+    void loadState(BinaryReader& r) override {
+        expectPolicy(r, "FB");
+        Server::loadState(r);
+        queue_sim::loadState(r, sizeDist);
+        while (!levels.empty()) popLevel();
+        auto n_levels = r.get<uint64_t>();
+        for (uint64_t i = 0; i < n_levels; ++i) {
+            pushLevel();
+            levels.back().attained = r.get<double>();
+            auto n_jobs = r.get<uint64_t>();
+            for (uint64_t j = 0; j < n_jobs; ++j) {
+                double size = r.get<double>();
+                levels.back().jobs.push_back({size, loadJob(r)});
+            }
+        }
+        nextIsCompletion = r.get<bool>();
+    }
+
+    // Levels are never empty, and a lone level has no level to catch up
+    // with.
+    bool consistent() const override {
+        if (!validCommon() || !fifo.empty()) return false;
+        size_t n = 0;
+        for (const Level &level : levels) {
+            if (level.jobs.empty()) return false;
+            n += level.jobs.size();
+        }
+        return n == static_cast<size_t>(state) &&
+               (levels.size() != 1 || nextIsCompletion);
+    }
+
+    size_t queueCapacity() const override {
+        size_t n = Server::queueCapacity();
+        for (const Level &level : levels) n += level.jobs.capacity();
+        for (const auto &heap : spareHeaps) n += heap.capacity();
+        return n;
+    }
+
+    // Same configuration with the size distribution resolved to `D`.
+    template <class D>
+    BasicFB<D> specialize() const {
+        return BasicFB<D>(std::get<D>(sizeDist), buffer_capacity);
     }
 
     void reset() override {
         Server::reset();
-        jobs.clear();
+        rewind(sizeDist);
+        while (!levels.empty()) popLevel();
+        nextIsCompletion = false;
     }
 
     double nextJob() override {
@@ -38,8 +128,13 @@ public:
         // FB computes response times directly in update(); no-op here.
     }
 
-    void arrival() override {
-        jobs.push_back({sample(sizeDist, *rng), 0.0, clock});
+    void arrival(JobId job) override {
+        (*pool)[job].arrival = clock;
+        Entry entry{drawSize(sizeDist, job), job};
+        if (levels.empty() || levels.back().attained > 0.0) {
+            pushLevel();
+        }
+        pushJob(levels.back().jobs, entry);
         state += 1;
         recalcTTNC();
     }
@@ -47,76 +142,87 @@ public:
     bool update(double dt) override {
         TTNC -= dt;
         clock += dt;
-        if (jobs.empty()) return false;
-
-        // Find active set (minimum attained service)
-        double min_att = jobs[0].attained;
-        for (const auto &j : jobs)
-            min_att = std::min(min_att, j.attained);
-
-        int numActive = 0;
-        for (const auto &j : jobs) {
-            if (j.attained <= min_att + 1e-12) numActive++;
+        if (levels.empty()) return false;
+
+        Level &active = levels.back();
+        active.attained += dt / static_cast<double>(active.jobs.size());
+
+        if (TTNC > 0.0) return false;
+
+        if (nextIsCompletion) {
+            // Snap to the finishing job's size so no error accumulates.
+            active.attained = active.jobs.front().first;
+            JobId job = popJob(active.jobs).second;
+            double response_time = clock - (*pool)[job].arrival;
+            _last_job = job;
+            _last_response_time = response_time;
+            if (active.jobs.empty()) popLevel();
+            state -= 1;
+            num_completions += 1;
+            double n = static_cast<double>(num_completions);
+            T = T * (n - 1.0) / n + response_time / n;
+            recalcTTNC();
+            return true;
         }
 
-        // Apply work to active jobs only
-        double work = dt / numActive;
-        for (auto &j : jobs) {
-            if (j.attained <= min_att + 1e-12) {
-                j.remaining -= work;
-                j.attained += work;
-            }
-        }
-
-        if (TTNC <= 0.0) {
-            // Check for completion (remaining ≈ 0)
-            for (auto it = jobs.begin(); it != jobs.end(); ++it) {
-                if (it->remaining <= 1e-12) {
-                    double response_time = clock - it->arrivalTime;
-                    _last_response_time = response_time;
-                    jobs.erase(it);
-                    state -= 1;
-                    num_completions += 1;
-                    double n = static_cast<double>(num_completions);
-                    T = T * (n - 1.0) / n + response_time / n;
-                    recalcTTNC();
-                    return true;
-                }
-            }
-            // Level crossing — active set expanded, recalculate
-            recalcTTNC();
+        // Level crossing: the active group reached the next level's
+        // attained service.  Merge the smaller heap into the larger.
+        Level &next = levels[levels.size() - 2];
+        if (active.jobs.size() > next.jobs.size()) {
+            std::swap(active.jobs, next.jobs);
         }
+        for (const Entry &e : active.jobs) pushJob(next.jobs, e);
+        popLevel();
+        recalcTTNC();
         return false;
     }
 
 private:
+    static void pushJob(std::vector<Entry> &heap, const Entry &entry) {
+        heap.push_back(entry);
+        std::push_heap(heap.begin(), heap.end(), std::greater<Entry>());
+    }
+
+    static Entry popJob(std::vector<Entry> &heap) {
+        std::pop_heap(heap.begin(), heap.end(), std::greater<Entry>());
+        Entry entry = heap.back();
+        heap.pop_back();
+        return entry;
+    }
+
+    void pushLevel() {
+        levels.push_back({0.0, {}});
+        if (!spareHeaps.empty()) {
+            levels.back().jobs = std::move(spareHeaps.back());
+            spareHeaps.pop_back();
+        }
+    }
+
+    void popLevel() {
+        levels.back().jobs.clear();
+        spareHeaps.push_back(std::move(levels.back().jobs));
+        levels.pop_back();
+    }
+
     void recalcTTNC() {
-        if (jobs.empty()) {
+        if (levels.empty()) {
             TTNC = std::numeric_limits<double>::infinity();
             return;
         }
 
-        double min_att = jobs[0].attained;
-        for (const auto &j : jobs)
-            min_att = std::min(min_att, j.attained);
-
-        int numActive = 0;
-        double min_rem_active = std::numeric_limits<double>::infinity();
-        double next_level = std::numeric_limits<double>::infinity();
-
-        for (const auto &j : jobs) {
-            if (j.attained <= min_att + 1e-12) {
-                numActive++;
-                min_rem_active = std::min(min_rem_active, j.remaining);
-            } else {
-                next_level = std::min(next_level, j.attained);
-            }
+        const Level &active = levels.back();
+        double numActive = static_cast<double>(active.jobs.size());
+        double to_completion = active.jobs.front().first - active.attained;
+        double to_crossing = std::numeric_limits<double>::infinity();
+        if (levels.size() > 1) {
+            to_crossing = levels[levels.size() - 2].attained - active.attained;
         }
 
-        double time_to_completion = min_rem_active * numActive;
-        double time_to_crossing = (next_level - min_att) * numActive;
-        TTNC = std::min(time_to_completion, time_to_crossing);
+        nextIsCompletion = to_completion <= to_crossing;
+        TTNC = std::min(to_completion, to_crossing) * numActive;
     }
 };
 
+using FB = BasicFB<Distribution>;
+
 }  // namespace queue_sim
@@ -1,38 +1,95 @@
 #pragma once
 
-#include <algorithm>
-#include <deque>
+#include <functional>
 #include <limits>
+#include <memory>
+#include <queue>
+#include <string>
+#include <utility>
+#include <variant>
 #include <vector>
 
 #include "server.hpp"
 
 namespace queue_sim {
 
-class FCFS : public Server {
+template <class SizeDist>
+class BasicFCFS final : public Server {
 public:
-    // Multi-server state (only used when num_servers > 1)
-    std::vector<double> channelRemaining;
-    std::vector<double> channelArrivals;
-    std::deque<double> waitQueue;
-
-    explicit FCFS(Distribution sizeDist, int num_servers = 1,
-                  int buffer_capacity = -1)
-        : Server(std::move(sizeDist), num_servers, buffer_capacity) {}
+    SizeDist sizeDist;
+
+    // Multi-server state (only used when num_servers > 1).  Each busy
+    // channel is (absolute completion time on this server's clock, job),
+    // kept in a min-heap so an event costs O(log k) instead of touching
+    // every channel.
+    using Channel = std::pair<double, JobId>;
+    std::priority_queue<Channel, std::vector<Channel>, std::greater<Channel>>
+        channels;
+    JobQueue waitQueue;
+
+    explicit BasicFCFS(SizeDist sizeDist, int num_servers = 1,
+                       int buffer_capacity = -1)
+        : Server(num_servers, buffer_capacity),
+          sizeDist(std::move(sizeDist)) {}
 
     std::shared_ptr<Server> clone() const override {
-        return std::make_shared<FCFS>(sizeDist, num_servers, buffer_capacity);
+        auto copy = std::make_shared<BasicFCFS>(sizeDist, num_servers,
+                                                buffer_capacity);
+        copy->class_size_dists = class_size_dists;
+        return copy;
+    }
+
+    std::shared_ptr<Server> cloneState() const override {
+        return std::make_shared<BasicFCFS>(*this);
+    }
+
+    void saveState(BinaryWriter& w) const override {
+        w.put(std::string("FCFS"));
+        Server::saveState(w);
+        queue_sim::saveState(w, sizeDist);
+        saveHeap(w, channels);
+        waitQueue.save(w);
+    }
+
+    void loadState(BinaryReader& r) override {
+        expectPolicy(r, "FCFS");
+        Server::loadState(r);
+        queue_sim::loadState(r, sizeDist);
+        loadHeap(r, channels);
+        waitQueue.load(r, *pool);
+    }
+
+    // One channel per job up to num_servers, the rest waiting.
+    bool consistent() const override {
+        if (num_servers == 1) return Server::consistent();
+        if (!validCommon() || !fifo.empty()) return false;
+        size_t n = static_cast<size_t>(state);
+        return channels.size() == std::min(n, static_cast<size_t>(num_servers)) &&
+               channels.size() + waitQueue.size() == n;
+    }
+
+    size_t queueCapacity() const override {
+        return Server::queueCapacity() + heapCapacity(channels) +
+               waitQueue.capacity();
+    }
+
+    // Same configuration with the size distribution resolved to `D`.
+    template <class D>
+    BasicFCFS<D> specialize() const {
+        return BasicFCFS<D>(std::get<D>(sizeDist), num_servers,
+                            buffer_capacity);
     }
 
     void reset() override {
         Server::reset();
-        channelRemaining.clear();
-        channelArrivals.clear();
+        rewind(sizeDist);
+        // Keep the heap's storage for the next run.
+        while (!channels.empty()) channels.pop();
         waitQueue.clear();
     }
 
     double nextJob() override {
-        return sample(sizeDist, *rng);
+        return drawSize(sizeDist, fifo.front());
     }
 
     void updateET() override {
@@ -44,20 +101,20 @@ public:
         // Response time is computed directly in update().
     }
 
-    void arrival() override {
+    void arrival(JobId job) override {
         if (num_servers == 1) {
-            Server::arrival();
+            Server::arrival(job);
             return;
         }
         state += 1;
-        if (static_cast<int>(channelRemaining.size()) < num_servers) {
+        (*pool)[job].arrival = clock;
+        if (static_cast<int>(channels.size()) < num_servers) {
             // Free channel available — start immediately
-            channelRemaining.push_back(sample(sizeDist, *rng));
-            channelArrivals.push_back(clock);
+            channels.push({clock + drawSize(sizeDist, job), job});
             recalcTTNC();
         } else {
             // All channels busy — queue
-            waitQueue.push_back(clock);
+            waitQueue.push(job);
         }
     }
 
@@ -67,36 +124,27 @@ public:
         }
 
         clock += time_elapsed;
-
-        // Subtract elapsed time from all active channels
-        for (auto &r : channelRemaining) r -= time_elapsed;
         TTNC -= time_elapsed;
 
         if (TTNC <= 0.0) {
-            // Find the channel with minimum remaining (the one that completed)
-            auto it = std::min_element(
-                channelRemaining.begin(), channelRemaining.end());
-            int idx = static_cast<int>(it - channelRemaining.begin());
+            // The earliest-finishing channel is the one that completed
+            JobId job = channels.top().second;
+            channels.pop();
 
             // Compute response time for the departing job
-            double response_time = clock - channelArrivals[idx];
+            double response_time = clock - (*pool)[job].arrival;
+            _last_job = job;
             _last_response_time = response_time;
             num_completions += 1;
             double n = static_cast<double>(num_completions);
             T = T * (n - 1.0) / n + response_time / n;
-
-            // Remove completed channel
-            channelRemaining.erase(it);
-            channelArrivals.erase(channelArrivals.begin() + idx);
             state -= 1;
 
-            // Pull from wait queue if non-empty
+            // Pull from wait queue if non-empty.  The job was already
+            // counted in `state` when it arrived.
             if (!waitQueue.empty()) {
-                double arrTime = waitQueue.front();
-                waitQueue.pop_front();
-                channelRemaining.push_back(sample(sizeDist, *rng));
-                channelArrivals.push_back(arrTime);
-                state += 1;
+                JobId queued = waitQueue.pop();
+                channels.push({clock + drawSize(sizeDist, queued), queued});
             }
 
             recalcTTNC();
@@ -107,13 +155,14 @@ public:
 
 private:
     void recalcTTNC() {
-        if (channelRemaining.empty()) {
+        if (channels.empty()) {
             TTNC = std::numeric_limits<double>::infinity();
             return;
         }
-        TTNC = *std::min_element(
-            channelRemaining.begin(), channelRemaining.end());
+        TTNC = channels.top().first - clock;
     }
 };
 
+using FCFS = BasicFCFS<Distribution>;
+
 }  // namespace queue_sim
@@ -0,0 +1,172 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "serialize.hpp"
+
+namespace queue_sim {
+
+using JobId = int32_t;
+constexpr JobId NO_JOB = -1;
+
+// Record of one job in the system.  Servers hold only JobIds, so routing
+// a job to another server hands over its slot instead of copying it.
+struct Job {
+    double arrival = 0.0;  // when the job joined its current server
+    double entry = 0.0;    // when it entered the network
+    int32_t visits = 0;    // stations it has been admitted to so far
+    int16_t job_class = 0; // traffic class (TrafficClass index)
+    JobId next = NO_JOB;   // free-list link while the slot is unused
+};
+
+// Slab of Job records shared by every server in a run, with an intrusive
+// free list.  Slots are recycled LIFO, so the records a run touches stay
+// hot in cache, and the slab only grows until it holds the peak number
+// of jobs in the system; reset() keeps that capacity, so the steady-state
+// event loop (and later runs reusing the pool) never allocates.
+//
+// Growing may move the slab: hold JobIds, not Job references, across
+// acquire().
+class JobPool {
+public:
+    // A fresh record for a class-`job_class` job entering the network at
+    // time `entry`.
+    JobId acquire(double entry = 0.0, int job_class = 0) {
+        if (freeHead == NO_JOB) grow();
+        JobId id = freeHead;
+        freeHead = slots[id].next;
+        slots[id].next = NO_JOB;
+        slots[id].entry = entry;
+        slots[id].visits = 0;
+        slots[id].job_class = static_cast<int16_t>(job_class);
+        ++live;
+        return id;
+    }
+
+    void release(JobId id) {
+        slots[id].next = freeHead;
+        freeHead = id;
+        --live;
+    }
+
+    Job& operator[](JobId id) { return slots[id]; }
+    const Job& operator[](JobId id) const { return slots[id]; }
+
+    // Forget every job but keep the storage.
+    void reset() {
+        freeHead = NO_JOB;
+        live = 0;
+        linkFree(0);
+    }
+
+    size_t size() const { return live; }
+    size_t capacity() const { return slots.size(); }
+    bool contains(JobId id) const {
+        return id >= 0 && static_cast<size_t>(id) < slots.size();
+    }
+
+    void save(BinaryWriter& w) const {
+        w.put(slots);
+        w.put(freeHead);
+        w.put<uint64_t>(live);
+    }
+
+    void load(BinaryReader& r) {
+        slots = r.getVector<Job>();
+        freeHead = r.get<JobId>();
+        live = static_cast<size_t>(r.get<uint64_t>());
+        if (live > slots.size()) BinaryReader::corrupt();
+        // Every slot is either live or on the free list exactly once, so
+        // the walk must end (at NO_JOB) after the remaining slots.
+        size_t free = 0;
+        for (JobId id = freeHead; id != NO_JOB; id = slots[id].next) {
+            if (!contains(id) || ++free > slots.size() - live)
+                BinaryReader::corrupt();
+        }
+        if (free != slots.size() - live) BinaryReader::corrupt();
+    }
+
+private:
+    std::vector<Job> slots;
+    JobId freeHead = NO_JOB;
+    size_t live = 0;
+
+    void grow() {
+        size_t old = slots.size();
+        slots.resize(old ? old * 2 : 64);
+        linkFree(old);
+    }
+
+    // Push slots [from, end) onto the free list, lowest index on top.
+    void linkFree(size_t from) {
+        for (size_t i = slots.size(); i-- > from;) {
+            slots[i].next = freeHead;
+            freeHead = static_cast<JobId>(i);
+        }
+    }
+};
+
+// FIFO of JobIds in a power-of-two ring buffer.  Contiguous ids keep
+// queue traffic sequential (unlike links through the pool), and the ring
+// only reallocates when it outgrows its previous peak.
+class JobQueue {
+public:
+    bool empty() const { return count == 0; }
+    size_t size() const { return count; }
+    size_t capacity() const { return ring.size(); }
+    JobId front() const { return ring[head]; }
+
+    void push(JobId id) {
+        if (count == ring.size()) grow();
+        ring[(head + count) & (ring.size() - 1)] = id;
+        ++count;
+    }
+
+    JobId pop() {
+        JobId id = ring[head];
+        head = (head + 1) & (ring.size() - 1);
+        --count;
+        return id;
+    }
+
+    void clear() {
+        head = 0;
+        count = 0;
+    }
+
+    // Jobs in queue order; a loaded queue starts at the front of its ring.
+    void save(BinaryWriter& w) const {
+        w.put<uint64_t>(count);
+        for (size_t i = 0; i < count; ++i) {
+            w.put(ring[(head + i) & (ring.size() - 1)]);
+        }
+    }
+
+    // Every id must name a slot of `pool`.
+    void load(BinaryReader& r, const JobPool& pool) {
+        clear();
+        auto n = r.get<uint64_t>();
+        for (uint64_t i = 0; i < n; ++i) {
+            JobId id = r.get<JobId>();
+            if (!pool.contains(id)) BinaryReader::corrupt();
+            push(id);
+        }
+    }
+
+private:
+    std::vector<JobId> ring;
+    size_t head = 0;
+    size_t count = 0;
+
+    void grow() {
+        std::vector<JobId> bigger(ring.empty() ? 16 : ring.size() * 2);
+        for (size_t i = 0; i < count; ++i) {
+            bigger[i] = ring[(head + i) & (ring.size() - 1)];
+        }
+        ring.swap(bigger);
+        head = 0;
+    }
+};
+
+}  // namespace queue_sim
@@ -0,0 +1,404 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "distributions.hpp"
+#include "engine.hpp"
+#include "rng.hpp"
+#include "routing.hpp"
+#include "server.hpp"
+
+namespace queue_sim {
+
+// Lockstep engine for replications of the smallest systems: one
+// single-channel FCFS or SRPT server fed by one arrival stream, with
+// concrete (devirtualized) arrival and size distributions.  LANES
+// replications advance together, one event per lane per step, with their
+// state held as structure-of-arrays.  Each step runs in two passes:
+//
+//   1. Branch-free over all lanes: pick the next event (completion or
+//      arrival), integrate the number in system, advance server clocks
+//      and remaining work.  Written as selects over plain arrays so the
+//      compiler vectorizes it for whatever ISA the build targets.
+//   2. Per lane: the queue operation and the draws the event needs, from
+//      the lane's own block-buffered stream (whose -log(1 - u) transform
+//      is itself vectorized, see Rng).
+//
+// There is no event calendar, job pool or virtual dispatch: a single
+// server needs only its count, the FIFO of arrival times (FCFS) or a
+// small heap of remaining sizes (SRPT).  Each lane performs exactly the
+// floating-point operations and draws of SimEngine::simLoop in the same
+// order, so replication i gives the same raw_N, raw_T and server_stats
+// bit for bit as the event-loop replicate(), provided the compiler does not
+// contract multiply-adds into FMAs differently in the two (setup.py builds
+// with -ffp-contract=off).  Like BasicSRPT, the SRPT heap serves equal
+// remaining sizes in order of arrival.
+template <bool IsSRPT, class ArrivalDist, class SizeDist>
+class LockstepBatch {
+public:
+    static constexpr int LANES = 8;
+
+    LockstepBatch(ArrivalDist arrivalDist, SizeDist sizeDist,
+                  int buffer_capacity, const RoutingTable& routing,
+                  RngConfig rng_config)
+        : arrivalDist(std::move(arrivalDist)),
+          sizeDist(std::move(sizeDist)),
+          buffer_capacity(buffer_capacity),
+          routing(routing),
+          rngConfig(rng_config) {}
+
+    // Same contract as SimEngine::replicate() without traces: per-
+    // replication seeds, waves under a StoppingRule, cooperative
+    // cancellation keeping only finished replications.  Work is handed
+    // out to the thread pool LANES replications at a time.
+    ReplicationRawResult replicate(int n_replications, int num_events,
+                                   uint64_t base_seed, int warmup,
+                                   int n_threads,
+                                   const StoppingRule* stopping = nullptr,
+                                   ReplicationControl* control = nullptr,
+                                   const ProgressFn& progress = ProgressFn()) const {
+        if (stopping) stopping->validate();
+        ReplicationControl local_control;
+        ReplicationControl& ctl = control ? *control : local_control;
+        ctl.cancel.store(false);
+        ctl.done.store(0);
+        ctl.total.store(std::max(0, n_replications));
+
+        ReplicationRawResult result;
+        if (n_replications <= 0) return result;
+
+        auto runWave = [&](int first, int count) {
+            int end = first + count;
+            result.raw_N.resize(end);
+            result.raw_T.resize(end);
+            result.server_stats.resize(end);
+            std::vector<char> rep_done(count, 0);
+            std::atomic<int> wave_done{0};
+
+            ProgressFn wave_progress;
+            if (progress) {
+                wave_progress = [&](int, int) {
+                    progress(first + wave_done.load(), n_replications);
+                };
+            }
+            int n_groups = (count + LANES - 1) / LANES;
+            SimEngine::runTasks(
+                n_groups, n_threads, ctl, wave_progress, [&] {
+                    // Lanes hold LANES streams each; keep them off the stack.
+                    return [&, lanes = std::make_unique<Lanes>()](int g) {
+                        int lo = first + g * LANES;
+                        int n = std::min(LANES, end - lo);
+                        if (!run(*lanes, lo, n, num_events, base_seed, warmup,
+                                 result, &ctl.cancel)) {
+                            return false;
+                        }
+                        std::fill_n(rep_done.begin() + (lo - first), n, 1);
+                        // runTasks counts the group once.
+                        ctl.done.fetch_add(n - 1);
+                        wave_done.fetch_add(n);
+                        return true;
+                    };
+                });
+
+            int done = static_cast<int>(
+                std::count(rep_done.begin(), rep_done.end(), 1));
+            if (done < count) {
+                size_t kept = first;
+                for (int k = 0; k < count; ++k) {
+                    if (!rep_done[k]) continue;
+                    int i = first + k;
+                    result.raw_N[kept] = result.raw_N[i];
+                    result.raw_T[kept] = result.raw_T[i];
+                    result.server_stats[kept] = std::move(result.server_stats[i]);
+                    ++kept;
+                }
+                result.raw_N.resize(kept);
+                result.raw_T.resize(kept);
+                result.server_stats.resize(kept);
+                result.cancelled = true;
+            }
+        };
+
+        if (!stopping) {
+            runWave(0, n_replications);
+        } else {
+            int target = std::min(stopping->min_replications, n_replications);
+            while (true) {
+                int have = static_cast<int>(result.raw_T.size());
+                runWave(have, target - have);
+                if (result.cancelled) break;
+                if (stopping->satisfied(result.raw_T)) {
+                    result.converged = true;
+                    break;
+                }
+                if (target >= n_replications) break;
+                target = std::min(target + stopping->wave_size, n_replications);
+            }
+            ctl.total.store(static_cast<int>(result.raw_T.size()));
+        }
+        return result;
+    }
+
+private:
+    ArrivalDist arrivalDist;
+    SizeDist sizeDist;
+    int buffer_capacity;
+    const RoutingTable& routing;
+    RngConfig rngConfig;
+
+    // Arrival times of the jobs at an FCFS server, in order.
+    struct TimeQueue {
+        std::vector<double> ring;
+        size_t head = 0;
+        size_t count = 0;
+
+        void clear() { head = count = 0; }
+
+        void push(double t) {
+            if (count == ring.size()) {
+                std::vector<double> bigger(ring.empty() ? 16 : ring.size() * 2);
+                for (size_t i = 0; i < count; ++i) {
+                    bigger[i] = ring[(head + i) & (ring.size() - 1)];
+                }
+                ring.swap(bigger);
+                head = 0;
+            }
+            ring[(head + count) & (ring.size() - 1)] = t;
+            ++count;
+        }
+
+        double pop() {
+            double t = ring[head];
+            head = (head + 1) & (ring.size() - 1);
+            --count;
+            return t;
+        }
+    };
+
+    // A waiting SRPT job: (remaining size, arrival time).
+    using Waiting = std::pair<double, double>;
+
+    // Event flags from pass 1.
+    enum : uint8_t { ARRIVE = 1, COMPLETE = 2 };
+
+    // One group's state, reused across the groups a thread runs.
+    struct Lanes {
+        // -- pass 1 (vectorized) --
+        double now[LANES];       // system time
+        double next_arr[LANES];  // next external arrival
+        double dep[LANES];       // server's next event (calendar time)
+        double clock[LANES];     // server clock
+        double ttnc[LANES];      // server's time to next completion
+        double area_n[LANES];    // measured integral of jobs in system
+        double start[LANES];     // when measurement began
+        double duration[LANES];  // measured time so far
+        double st_area[LANES];   // ServerStats::area
+        double st_busy[LANES];   // ServerStats::busy_time
+        int state[LANES];
+        uint8_t active[LANES];
+        uint8_t measuring[LANES];
+        uint8_t event[LANES];
+
+        // -- pass 2 (per lane) --
+        int completions[LANES];  // measured departures
+        int warmup_done[LANES];
+        int max_state[LANES];
+        int64_t st_completions[LANES];
+        double st_response[LANES];
+        double running_arrival[LANES];  // SRPT: job in service
+        Rng rng[LANES];
+        Rng size_rng[LANES];   // CRN substreams (unused without CRN)
+        Rng route_rng[LANES];
+        TimeQueue fifo[LANES];
+        std::vector<Waiting> waiting[LANES];  // SRPT min-heap
+    };
+
+    // SimEngine::simLoop's start of measurement for one lane.
+    static void beginMeasurement(Lanes& s, int l) {
+        s.measuring[l] = 1;
+        s.start[l] = s.now[l];
+        s.area_n[l] = 0.0;
+        s.completions[l] = 0;
+        s.max_state[l] = s.state[l];
+        s.st_completions[l] = 0;
+        s.st_response[l] = 0.0;
+        // Server::beginStats: pre-credit the untouched interval.
+        double dt = s.clock[l] - s.now[l];
+        s.st_area[l] = s.state[l] * dt;
+        s.st_busy[l] = std::min(s.state[l], 1) * dt;
+    }
+
+    // Replications [first, first + n) in lanes 0..n-1.  Returns false if
+    // `stop` cut the group short.
+    bool run(Lanes& s, int first, int n, int num_events, uint64_t base_seed,
+             int warmup, ReplicationRawResult& result,
+             const std::atomic<bool>* stop) const {
+        const bool crn = rngConfig.crn;
+        const bool tandem = routing.tandem();
+        const double inf = std::numeric_limits<double>::infinity();
+        ArrivalDist arrival = arrivalDist;
+        SizeDist size = sizeDist;
+
+        for (int l = 0; l < LANES; ++l) {
+            bool used = l < n;
+            s.active[l] = used;
+            s.measuring[l] = 0;
+            s.event[l] = 0;
+            s.now[l] = 0.0;
+            s.clock[l] = 0.0;
+            s.ttnc[l] = inf;
+            s.dep[l] = inf;
+            s.next_arr[l] = inf;
+            s.area_n[l] = 0.0;
+            s.start[l] = 0.0;
+            s.duration[l] = 0.0;
+            s.st_area[l] = 0.0;
+            s.st_busy[l] = 0.0;
+            s.state[l] = 0;
+            s.warmup_done[l] = 0;
+            s.fifo[l].clear();
+            s.waiting[l].clear();
+            if (!used) continue;
+            uint64_t seed = derive_seed(base_seed, static_cast<uint64_t>(first + l));
+            s.rng[l].seed(crn ? RngConfig::arrivalSeed(seed) : seed,
+                          rngConfig.kind);
+            if (crn) {
+                s.size_rng[l].seed(RngConfig::sizeSeed(seed, 0), rngConfig.kind);
+                s.route_rng[l].seed(RngConfig::routingSeed(seed, 0),
+                                    rngConfig.kind);
+            }
+            rewind(arrival);
+            s.next_arr[l] = sample(arrival, s.rng[l]);
+            if (warmup <= 0) beginMeasurement(s, l);
+            if (s.measuring[l] && num_events <= 0) s.active[l] = 0;
+        }
+
+        unsigned polls = 0;
+        int live = 0;
+        for (int l = 0; l < n; ++l) live += s.active[l];
+        while (live > 0) {
+            if (SimEngine::stopRequested(stop, polls)) return false;
+
+            // -- pass 1: every lane at once ---------------------------------
+            for (int l = 0; l < LANES; ++l) {
+                bool a = s.active[l];
+                bool m = a && s.measuring[l];
+                bool fire = s.dep[l] <= s.next_arr[l];
+                double t = fire ? s.dep[l] : s.next_arr[l];
+                double st = s.state[l];
+                s.area_n[l] = m ? s.area_n[l] + st * (t - s.now[l]) : s.area_n[l];
+                s.duration[l] = m ? t - s.start[l] : s.duration[l];
+                s.now[l] = a ? t : s.now[l];
+                double dt = fire ? s.ttnc[l] : t - s.clock[l];
+                s.st_area[l] = a ? s.st_area[l] + st * dt : s.st_area[l];
+                s.st_busy[l] = a ? s.st_busy[l] + std::min(st, 1.0) * dt
+                                 : s.st_busy[l];
+                double ttnc = s.ttnc[l] - dt;
+                s.ttnc[l] = a ? ttnc : s.ttnc[l];
+                s.clock[l] = a ? s.clock[l] + dt : s.clock[l];
+                uint8_t ev = (fire ? 0 : ARRIVE) | (ttnc <= 0.0 ? COMPLETE : 0);
+                s.event[l] = a ? ev : 0;
+            }
+
+            // -- pass 2: queues and draws, lane by lane ---------------------
+            for (int l = 0; l < n; ++l) {
+                uint8_t ev = s.event[l];
+                if (!ev) continue;
+                Rng& rng = s.rng[l];
+                Rng& size_rng = crn ? s.size_rng[l] : rng;
+                bool completed = false;
+                double response = 0.0;
+
+                if (ev & COMPLETE) {
+                    s.state[l] -= 1;
+                    completed = true;
+                    if constexpr (IsSRPT) {
+                        response = s.clock[l] - s.running_arrival[l];
+                        s.ttnc[l] = s.state[l] > 0 ? popWaiting(s, l) : inf;
+                    } else {
+                        response = s.clock[l] - s.fifo[l].pop();
+                        s.ttnc[l] = s.state[l] > 0 ? sample(size, size_rng) : inf;
+                    }
+                }
+                if (ev & ARRIVE) {
+                    if (buffer_capacity < 0 || s.state[l] < buffer_capacity) {
+                        if constexpr (IsSRPT) {
+                            auto& heap = s.waiting[l];
+                            if (s.state[l] > 0) {
+                                heap.push_back({s.ttnc[l], s.running_arrival[l]});
+                                std::push_heap(heap.begin(), heap.end(),
+                                               std::greater<Waiting>());
+                            }
+                            heap.push_back({sample(size, size_rng), s.clock[l]});
+                            std::push_heap(heap.begin(), heap.end(),
+                                           std::greater<Waiting>());
+                            s.ttnc[l] = popWaiting(s, l);
+                        } else {
+                            s.fifo[l].push(s.clock[l]);
+                            if (s.state[l] == 0) s.ttnc[l] = sample(size, size_rng);
+                        }
+                        s.state[l] += 1;
+                        s.max_state[l] = std::max(s.max_state[l], s.state[l]);
+                    }
+                    s.next_arr[l] = s.now[l] + sample(arrival, rng);
+                }
+                s.dep[l] = s.clock[l] + s.ttnc[l];
+
+                if (!completed) continue;
+                if (!tandem) routing.route(0, crn ? s.route_rng[l] : rng);
+                if (s.measuring[l]) {
+                    s.st_completions[l] += 1;
+                    s.st_response[l] += response;
+                    if (++s.completions[l] >= num_events) {
+                        s.active[l] = 0;
+                        --live;
+                    }
+                } else if (++s.warmup_done[l] >= warmup) {
+                    beginMeasurement(s, l);
+                    if (num_events <= 0) {
+                        s.active[l] = 0;
+                        --live;
+                    }
+                }
+            }
+        }
+
+        for (int l = 0; l < n; ++l) {
+            int i = first + l;
+            double clock = s.duration[l];
+            result.raw_N[i] = s.area_n[l] / clock;
+            result.raw_T[i] = s.area_n[l] / std::max(1, s.completions[l]);
+            // Server::finishStats at the lane's final time.
+            ServerStats st;
+            double dt = s.now[l] - s.clock[l];
+            st.area = s.st_area[l] + s.state[l] * dt;
+            st.busy_time = s.st_busy[l] + std::min(s.state[l], 1) * dt;
+            st.duration = clock;
+            st.max_state = s.max_state[l];
+            st.num_servers = 1;
+            st.completions = s.st_completions[l];
+            st.response_sum = s.st_response[l];
+            result.server_stats[i].assign(1, st);
+        }
+        return true;
+    }
+
+    // SRPT: start the waiting job with the least remaining size.
+    static double popWaiting(Lanes& s, int l) {
+        auto& heap = s.waiting[l];
+        std::pop_heap(heap.begin(), heap.end(), std::greater<Waiting>());
+        auto [remaining, arrived] = heap.back();
+        heap.pop_back();
+        s.running_arrival[l] = arrived;
+        return remaining;
+    }
+};
+
+}  // namespace queue_sim
@@ -0,0 +1,113 @@
+#pragma once
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+
+namespace queue_sim {
+
+// Read-only memory mapping of a whole file.  Pages are faulted in on first
+// touch and can be dropped again by the kernel, so a trace far larger than
+// RAM costs address space rather than memory.  POSIX mmap, or a file
+// mapping view on Windows.
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path) : path(path) { map(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile() {
+        if (!addr) return;
+#ifdef _WIN32
+        ::UnmapViewOfFile(addr);
+#else
+        ::munmap(addr, length);
+#endif
+    }
+
+    const unsigned char* data() const {
+        return static_cast<const unsigned char*>(addr);
+    }
+    size_t size() const { return length; }
+
+    const std::string path;
+
+private:
+    void* addr = nullptr;
+    size_t length = 0;
+
+#ifdef _WIN32
+    void map() {
+        // Replays read front to back.
+        HANDLE file = ::CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                                    nullptr, OPEN_EXISTING,
+                                    FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            throw std::runtime_error("cannot open '" + path + "' for reading");
+        }
+        LARGE_INTEGER st;
+        if (!::GetFileSizeEx(file, &st)) {
+            ::CloseHandle(file);
+            throw std::runtime_error("cannot stat '" + path + "'");
+        }
+        length = static_cast<size_t>(st.QuadPart);
+        if (length > 0) {
+            // A view keeps its mapping alive, so neither handle is needed
+            // once it exists.
+            HANDLE mapping = ::CreateFileMappingA(file, nullptr, PAGE_READONLY,
+                                                  0, 0, nullptr);
+            void* p = mapping ? ::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0)
+                              : nullptr;
+            if (mapping) ::CloseHandle(mapping);
+            if (!p) {
+                ::CloseHandle(file);
+                throw std::runtime_error("cannot map '" + path + "'");
+            }
+            addr = p;
+        }
+        ::CloseHandle(file);
+    }
+#else
+    void map() {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("cannot open '" + path + "' for reading");
+        }
+        struct stat st;
+        if (::fstat(fd, &st) != 0) {
+            ::close(fd);
+            throw std::runtime_error("cannot stat '" + path + "'");
+        }
+        length = static_cast<size_t>(st.st_size);
+        if (length > 0) {
+            void* p = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p == MAP_FAILED) {
+                ::close(fd);
+                throw std::runtime_error("cannot map '" + path + "'");
+            }
+            // Replays read front to back.
+            ::madvise(p, length, MADV_SEQUENTIAL);
+            addr = p;
+        }
+        ::close(fd);
+    }
+#endif
+};
+
+}  // namespace queue_sim
@@ -0,0 +1,178 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace queue_sim {
+
+// Hot-path instrumentation, compiled in only when QUEUE_SIM_PROFILE is
+// defined (setup.py does so when the environment variable of that name is
+// set).  Every hook in the event loop sits behind `if constexpr
+// (PROFILING)`, so a normal build carries no counters at all.
+#ifdef QUEUE_SIM_PROFILE
+inline constexpr bool PROFILING = true;
+#else
+inline constexpr bool PROFILING = false;
+#endif
+
+struct ServerProfile {
+    int peak_state = 0;         // most jobs present at once, warmup included
+    size_t queue_capacity = 0;  // entries allocated by its queues at the end
+};
+
+// What one sim() did, warmup included.  Left zeroed (with `enabled`
+// false) by builds without profiling.
+struct RunProfile {
+    bool enabled = false;
+
+    // -- events by type --
+    int64_t arrivals = 0;         // external arrivals admitted
+    int64_t routes = 0;           // jobs moved on to another server
+    int64_t departures = 0;       // jobs leaving the system
+    int64_t rejections = 0;       // external or routed jobs turned away
+    int64_t level_crossings = 0;  // server events finishing no job (FB)
+
+    // -- phases --
+    int64_t warmup_events = 0;       // calendar or arrival events processed
+    int64_t measurement_events = 0;
+    double warmup_seconds = 0.0;     // wall-clock time in each phase
+    double measurement_seconds = 0.0;
+
+    int64_t rng_draws = 0;  // uniforms taken from every stream of the run
+
+    // -- storage at the end of the run --
+    size_t job_pool_capacity = 0;   // job records
+    size_t completed_capacity = 0;  // per-event completion scratch
+    size_t event_log_capacity = 0;  // events the in-memory log can hold
+    std::vector<ServerProfile> servers;
+
+    void reset(size_t n_servers) {
+        *this = RunProfile();
+        enabled = true;
+        servers.assign(n_servers, ServerProfile());
+    }
+};
+
+// The event loop's side of RunProfile.  Constructed with a null target,
+// or in a build without PROFILING, every method is empty and the calls
+// vanish from the loop.
+class Profiler {
+public:
+    explicit Profiler(RunProfile* out) : out(PROFILING ? out : nullptr) {}
+
+    void start(size_t n_servers) {
+        if constexpr (PROFILING) {
+            if (!out) return;
+            out->reset(n_servers);
+            phase_start = Clock::now();
+        }
+    }
+
+    // One calendar event fired; it finished no job if nothing completed.
+    template <class Completed>
+    void fired(const Completed& completed) {
+        if constexpr (PROFILING) {
+            if (!out) return;
+            events += 1;
+            if (completed.empty()) out->level_crossings += 1;
+        }
+    }
+
+    // External arrival: admitted to `s` (server `idx`) or rejected.
+    template <class Srv>
+    void arrival(const Srv& s, int idx) {
+        if constexpr (PROFILING) {
+            if (!out) return;
+            events += 1;
+            out->arrivals += 1;
+            peak(s, idx);
+        }
+    }
+
+    void rejectedArrival() {
+        if constexpr (PROFILING) {
+            if (!out) return;
+            events += 1;
+            out->rejections += 1;
+        }
+    }
+
+    template <class Srv>
+    void route(const Srv& s, int idx) {
+        if constexpr (PROFILING) {
+            if (!out) return;
+            out->routes += 1;
+            peak(s, idx);
+        }
+    }
+
+    void departure() {
+        if constexpr (PROFILING) {
+            if (out) out->departures += 1;
+        }
+    }
+
+    void rejection() {
+        if constexpr (PROFILING) {
+            if (out) out->rejections += 1;
+        }
+    }
+
+    void beginMeasurement() {
+        if constexpr (PROFILING) {
+            if (!out) return;
+            auto now = Clock::now();
+            out->warmup_seconds = seconds(now - phase_start);
+            out->warmup_events = events;
+            phase_start = now;
+        }
+    }
+
+    // Close the measurement phase and record the run's draws (from `rng`
+    // and any substreams) and storage: job pool, completion scratch, event
+    // log (or null) and servers.
+    template <class Rng, class Streams, class Pool, class Completed,
+              class Log, class Srvs>
+    void finish(const Rng& rng, const Streams* streams, const Pool& jobs,
+                const Completed& completed, const Log* event_log,
+                const Srvs& srvs) {
+        if constexpr (PROFILING) {
+            if (!out) return;
+            out->measurement_seconds = seconds(Clock::now() - phase_start);
+            out->measurement_events = events - out->warmup_events;
+            out->rng_draws = rng.draws();
+            if (streams) {
+                for (const auto& r : *streams) out->rng_draws += r.draws();
+            }
+            out->job_pool_capacity = jobs.capacity();
+            out->completed_capacity = completed.capacity();
+            out->event_log_capacity =
+                event_log ? event_log->times.capacity() : 0;
+            for (size_t i = 0; i < srvs.size(); ++i) {
+                out->servers[i].queue_capacity = srvs[i]->queueCapacity();
+            }
+        }
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    RunProfile* out;
+    int64_t events = 0;
+    Clock::time_point phase_start;
+
+    template <class Srv>
+    void peak(const Srv& s, int idx) {
+        int& p = out->servers[idx].peak_state;
+        p = std::max(p, s.state);
+    }
+
+    static double seconds(Clock::duration d) {
+        return std::chrono::duration<double>(d).count();
+    }
+};
+
+}  // namespace queue_sim
@@ -1,30 +1,87 @@
 #pragma once
 
 #include <algorithm>
+#include <functional>
 #include <limits>
+#include <memory>
+#include <queue>
+#include <string>
+#include <utility>
+#include <variant>
 #include <vector>
 
 #include "server.hpp"
 
 namespace queue_sim {
 
-class PS : public Server {
+template <class SizeDist>
+class BasicPS final : public Server {
 public:
-    std::vector<double> remaining;
-    std::vector<double> jobArrivals;
+    SizeDist sizeDist;
 
-    explicit PS(Distribution sizeDist, int num_servers = 1,
-                int buffer_capacity = -1)
-        : Server(std::move(sizeDist), num_servers, buffer_capacity) {}
+    // Virtual-time representation: every job present has received the
+    // same service since it arrived, so instead of decrementing each
+    // remaining size we advance one counter of attained virtual service
+    // and give each job a fixed finish tag (virtual time at arrival + size).
+    // The job with the smallest tag always finishes next.
+    using Entry = std::pair<double, JobId>;  // (finish_tag, job)
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> jobs;
+    double virtualTime = 0.0;
+
+    explicit BasicPS(SizeDist sizeDist, int num_servers = 1,
+                     int buffer_capacity = -1)
+        : Server(num_servers, buffer_capacity),
+          sizeDist(std::move(sizeDist)) {}
 
     std::shared_ptr<Server> clone() const override {
-        return std::make_shared<PS>(sizeDist, num_servers, buffer_capacity);
+        auto copy = std::make_shared<BasicPS>(sizeDist, num_servers,
+                                              buffer_capacity);
+        copy->class_size_dists = class_size_dists;
+        return copy;
+    }
+
+    std::shared_ptr<Server> cloneState() const override {
+        return std::make_shared<BasicPS>(*this);
+    }
+
+    void saveState(BinaryWriter& w) const override {
+        w.put(std::string("PS"));
+        Server::saveState(w);
+        queue_sim::saveState(w, sizeDist);
+        saveHeap(w, jobs);
+        w.put(virtualTime);
+    }
+
+    void loadState(BinaryReader& r) override {
+        expectPolicy(r, "PS");
+        Server::loadState(r);
+        queue_sim::loadState(r, sizeDist);
+        loadHeap(r, jobs);
+        virtualTime = r.get<double>();
+    }
+
+    bool consistent() const override {
+        return validCommon() && fifo.empty() &&
+               jobs.size() == static_cast<size_t>(state);
+    }
+
+    size_t queueCapacity() const override {
+        return Server::queueCapacity() + heapCapacity(jobs);
+    }
+
+    // Same configuration with the size distribution resolved to `D`.
+    template <class D>
+    BasicPS<D> specialize() const {
+        return BasicPS<D>(std::get<D>(sizeDist), num_servers,
+                          buffer_capacity);
     }
 
     void reset() override {
         Server::reset();
-        remaining.clear();
-        jobArrivals.clear();
+        rewind(sizeDist);
+        // Keep the heap's storage for the next run.
+        while (!jobs.empty()) jobs.pop();
+        virtualTime = 0.0;
     }
 
     double nextJob() override {
@@ -35,9 +92,9 @@ public:
         // PS computes response times directly in update(); no-op here.
     }
 
-    void arrival() override {
-        remaining.push_back(sample(sizeDist, *rng));
-        jobArrivals.push_back(clock);
+    void arrival(JobId job) override {
+        (*pool)[job].arrival = clock;
+        jobs.push({virtualTime + drawSize(sizeDist, job), job});
         state += 1;
         recalcTTNC();
     }
@@ -48,17 +105,17 @@ public:
         if (state == 0) return false;
 
         // rate_per_job = min(k, n) / n  where k = num_servers, n = state
-        double work = dt * std::min(num_servers, state) / state;
-        for (auto &r : remaining) r -= work;
+        virtualTime += dt * std::min(num_servers, state) / state;
 
         if (TTNC <= 0.0) {
-            auto it = std::min_element(remaining.begin(), remaining.end());
-            int idx = static_cast<int>(it - remaining.begin());
-            double response_time = clock - jobArrivals[idx];
+            JobId job = jobs.top().second;
+            double response_time = clock - (*pool)[job].arrival;
+            _last_job = job;
             _last_response_time = response_time;
-            remaining.erase(it);
-            jobArrivals.erase(jobArrivals.begin() + idx);
+            jobs.pop();
             state -= 1;
+            // Rebase when empty so tags stay small and precise.
+            if (state == 0) virtualTime = 0.0;
             num_completions += 1;
             double n = static_cast<double>(num_completions);
             T = T * (n - 1.0) / n + response_time / n;
@@ -70,15 +127,16 @@ public:
 
 private:
     void recalcTTNC() {
-        if (remaining.empty()) {
+        if (jobs.empty()) {
             TTNC = std::numeric_limits<double>::infinity();
             return;
         }
-        double min_rem =
-            *std::min_element(remaining.begin(), remaining.end());
+        double min_rem = jobs.top().first - virtualTime;
         // TTNC = min_rem / rate_per_job = min_rem * state / min(k, state)
         TTNC = min_rem * state / std::min(num_servers, state);
     }
 };
 
+using PS = BasicPS<Distribution>;
+
 }  // namespace queue_sim
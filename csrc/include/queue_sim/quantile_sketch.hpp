@@ -0,0 +1,188 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace queue_sim {
+
+// Mergeable streaming quantile sketch with bounded relative error
+// (DDSketch, Masson et al. 2019).  Positive values fall in logarithmic
+// buckets (gamma^(k-1), gamma^k] with gamma = (1 + a) / (1 - a), so every
+// quantile estimate is within a factor (1 +/- a) of a true sample of that
+// rank.  Memory depends only on the spread of the values (ln(max/min) /
+// ln(gamma) counters), not on how many are added, and two sketches with
+// the same accuracy merge exactly by adding counts.
+class QuantileSketch {
+public:
+    // Values at or below this are counted in a single zero bucket.
+    static constexpr double MIN_INDEXABLE = 1e-12;
+
+    explicit QuantileSketch(double relative_accuracy = 0.01)
+        : alpha(relative_accuracy) {
+        if (!(relative_accuracy > 0.0 && relative_accuracy < 1.0)) {
+            throw std::invalid_argument(
+                "relative_accuracy must be in (0, 1), got " +
+                std::to_string(relative_accuracy));
+        }
+        gamma = (1.0 + alpha) / (1.0 - alpha);
+        invLogGamma = 1.0 / std::log(gamma);
+    }
+
+    void add(double x) {
+        ++n;
+        sumV += x;
+        if (x < minV) minV = x;
+        if (x > maxV) maxV = x;
+        if (x <= MIN_INDEXABLE) {
+            ++zeroCount;
+            return;
+        }
+        ++bucket(key(x));
+    }
+
+    // Fold `other` into this sketch; both must use the same accuracy.
+    void merge(const QuantileSketch& other) {
+        if (other.alpha != alpha) {
+            throw std::invalid_argument(
+                "cannot merge sketches with different relative accuracy");
+        }
+        if (other.n == 0) return;
+        if (!other.bins.empty()) {
+            bucket(other.offset);
+            bucket(other.offset + static_cast<int32_t>(other.bins.size()) - 1);
+            for (size_t i = 0; i < other.bins.size(); ++i) {
+                bins[other.offset - offset + i] += other.bins[i];
+            }
+        }
+        zeroCount += other.zeroCount;
+        n += other.n;
+        sumV += other.sumV;
+        minV = std::min(minV, other.minV);
+        maxV = std::max(maxV, other.maxV);
+    }
+
+    // Value of rank q * (count - 1), for q in [0, 1]; NaN when empty.
+    double quantile(double q) const {
+        if (!(q >= 0.0 && q <= 1.0)) {
+            throw std::invalid_argument(
+                "quantile must be in [0, 1], got " + std::to_string(q));
+        }
+        if (n == 0) return std::numeric_limits<double>::quiet_NaN();
+        if (q == 0.0) return minV;
+        if (q == 1.0) return maxV;
+        double rank = q * static_cast<double>(n - 1);
+        double seen = static_cast<double>(zeroCount);
+        if (seen > rank) return std::max(minV, 0.0);
+        for (size_t i = 0; i < bins.size(); ++i) {
+            seen += static_cast<double>(bins[i]);
+            if (seen > rank) {
+                double v = 2.0 * std::pow(gamma, offset + static_cast<double>(i)) /
+                           (gamma + 1.0);
+                return std::min(std::max(v, minV), maxV);
+            }
+        }
+        return maxV;
+    }
+
+    uint64_t count() const { return n; }
+    double sum() const { return sumV; }
+    double mean() const {
+        return n ? sumV / static_cast<double>(n)
+                 : std::numeric_limits<double>::quiet_NaN();
+    }
+    double min() const {
+        return n ? minV : std::numeric_limits<double>::quiet_NaN();
+    }
+    double max() const {
+        return n ? maxV : std::numeric_limits<double>::quiet_NaN();
+    }
+    double relativeAccuracy() const { return alpha; }
+
+    // Histogram over the occupied range: counts[i] samples lie in
+    // (edges[i], edges[i + 1]].  Values in the zero bucket, if any, get a
+    // leading bin starting at 0 that runs up to the first log bucket.
+    void histogram(std::vector<double>& edges,
+                   std::vector<uint64_t>& counts) const {
+        edges.clear();
+        counts.clear();
+        if (zeroCount) {
+            edges.push_back(0.0);
+            counts.push_back(zeroCount);
+        }
+        if (bins.empty()) {
+            if (zeroCount) edges.push_back(MIN_INDEXABLE);
+            return;
+        }
+        edges.push_back(std::pow(gamma, offset - 1.0));
+        for (size_t i = 0; i < bins.size(); ++i) {
+            edges.push_back(std::pow(gamma, offset + static_cast<double>(i)));
+            counts.push_back(bins[i]);
+        }
+    }
+
+private:
+    double alpha;
+    double gamma;
+    double invLogGamma;
+
+    // Dense counters for keys [offset, offset + bins.size()).
+    int32_t offset = 0;
+    std::vector<uint64_t> bins;
+    uint64_t zeroCount = 0;
+
+    uint64_t n = 0;
+    double sumV = 0.0;
+    double minV = std::numeric_limits<double>::infinity();
+    double maxV = -std::numeric_limits<double>::infinity();
+
+    int32_t key(double x) const {
+        return static_cast<int32_t>(std::ceil(std::log(x) * invLogGamma));
+    }
+
+    // Counter for key k, growing the dense range to cover it.
+    uint64_t& bucket(int32_t k) {
+        if (bins.empty()) {
+            offset = k;
+            bins.assign(1, 0);
+        } else if (k < offset) {
+            bins.insert(bins.begin(), static_cast<size_t>(offset - k), 0);
+            offset = k;
+        } else if (k >= offset + static_cast<int32_t>(bins.size())) {
+            bins.resize(static_cast<size_t>(k - offset) + 1, 0);
+        }
+        return bins[static_cast<size_t>(k - offset)];
+    }
+};
+
+// Streaming response-time summaries for one run: every measurement-phase
+// completion at server i feeds per_server[i] (time spent at that station),
+// and every departure from the system feeds end_to_end (its sojourn since
+// entering the network).
+struct ResponseTimeSketch {
+    QuantileSketch end_to_end;
+    std::vector<QuantileSketch> per_server;
+
+    explicit ResponseTimeSketch(double relative_accuracy = 0.01,
+                                int n_servers = 0)
+        : end_to_end(relative_accuracy),
+          per_server(static_cast<size_t>(std::max(0, n_servers)),
+                     QuantileSketch(relative_accuracy)) {}
+
+    void merge(const ResponseTimeSketch& other) {
+        if (per_server.size() != other.per_server.size()) {
+            throw std::invalid_argument(
+                "cannot merge sketches of systems with different server counts");
+        }
+        end_to_end.merge(other.end_to_end);
+        for (size_t i = 0; i < per_server.size(); ++i) {
+            per_server[i].merge(other.per_server[i]);
+        }
+    }
+};
+
+}  // namespace queue_sim
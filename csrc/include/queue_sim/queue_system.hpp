@@ -1,6 +1,7 @@
 #pragma once
 
 #include <algorithm>
+#include <atomic>
 #include <cmath>
 #include <cstdint>
 #include <limits>
@@ -8,50 +9,120 @@
 #include <random>
 #include <stdexcept>
 #include <string>
-#include <thread>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
+#include "batch_means.hpp"
 #include "distributions.hpp"
+#include "engine.hpp"
 #include "event_log.hpp"
+#include "event_log_file.hpp"
+#include "fb.hpp"
+#include "fcfs.hpp"
+#include "lockstep.hpp"
+#include "ps.hpp"
+#include "quantile_sketch.hpp"
+#include "queue_system_t.hpp"
+#include "response_times.hpp"
+#include "rng.hpp"
+#include "routing.hpp"
 #include "server.hpp"
+#include "snapshot.hpp"
+#include "splitting.hpp"
+#include "srpt.hpp"
+#include "system_state.hpp"
+#include "traffic.hpp"
 
 namespace queue_sim {
 
-struct ReplicationRawResult {
-    std::vector<double> raw_N;
-    std::vector<double> raw_T;
+// One (system, replication) run of QueueSystem::sweep().
+struct SweepRow {
+    int32_t config;       // index into the swept systems
+    int32_t replication;
+    uint64_t seed;        // seed the run was started from
+    double mean_N;
+    double mean_T;
 };
 
-// SplitMix64 one-round (Steele / Vigna) — matches Python _splitmix64.
-inline uint64_t splitmix64(uint64_t x) {
-    static constexpr uint64_t PHI = 0x9E3779B97F4A7C15ULL;
-    x = (x + PHI);
-    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
-    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
-    return x ^ (x >> 31);
-}
+struct SweepResult {
+    std::vector<SweepRow> rows;  // by config, then replication
+    bool cancelled = false;      // stopped early; rows hold finished runs
+};
 
-inline uint64_t derive_seed(uint64_t base_seed, uint64_t index) {
-    static constexpr uint64_t PHI = 0x9E3779B97F4A7C15ULL;
-    return splitmix64(base_seed + index * PHI);
-}
+// Result of QueueSystem::compare(): per-configuration mean response times
+// and, for every configuration, the paired difference to configuration 0
+// over the replications all configurations finished.  Half-widths are NaN
+// when fewer than two replications are available.
+struct PairedComparison {
+    std::vector<SweepRow> rows;        // by config, then replication
+    std::vector<double> mean_T;        // per config
+    std::vector<double> half_width;    // unpaired CI of mean_T
+    std::vector<double> diff_mean;     // mean of T[c] - T[0]
+    std::vector<double> diff_half_width;
+    int n_paired = 0;                  // replications in the differences
+    double confidence = 0.95;
+    bool cancelled = false;
+};
 
 class QueueSystem {
 public:
     std::vector<std::shared_ptr<Server>> servers;
     Distribution arrivalDist;
     std::vector<std::vector<double>> transitionMatrix;
+    // Traffic classes; when non-empty they replace arrivalDist as the
+    // external arrival streams (see TrafficClass).
+    std::vector<TrafficClass> classes;
     double T = 0.0;
-    std::vector<double> response_times;
-    EventLog event_log;
+    // Per-class results of the last sim(); empty for single-class systems.
+    std::vector<ClassStats> class_stats;
+    // Replaced by each sim(); shares storage with any exported views.
+    ResponseTimes response_times;
+    // Replaced (not cleared) by each sim(), so arrays exported from an
+    // earlier run stay valid.
+    std::shared_ptr<EventLog> event_log = std::make_shared<EventLog>();
+    // Streaming response-time quantiles from the last sim() run with
+    // sketch_response_times; constant memory in num_events.
+    ResponseTimeSketch sketch;
+    double sketch_accuracy = 0.01;
+    // Per-batch means from the last sim() run with n_batches.
+    BatchMeans batch_means;
+    // With a non-zero capacity, track_events keeps only a sliding window
+    // of recent events plus triggered snapshots (event_log->snapshots).
+    EventWindow event_window;
+    // Event calendar and job-record arena reused by every sim(), so
+    // repeated runs keep their storage instead of regrowing it.
+    RunScratch scratch;
+    // Events per chunk when sim() streams its event log to a file.
+    static constexpr size_t EVENT_LOG_CHUNK = size_t(1) << 16;
+    // Run homogeneous networks on the devirtualized QueueSystemT engine.
+    // Results are identical either way; this exists for benchmarking and
+    // testing the fallback.
+    bool use_specialized = true;
+    // Generator behind every draw.  MT19937_64 keeps seeded results
+    // identical to earlier releases; the others are faster.
+    RngKind rng_kind = RngKind::MT19937_64;
+    // Draw arrivals, each server's sizes and each server's routing from
+    // separate substreams (see RngConfig), so systems that differ only in
+    // policy see identical traffic.  Off keeps seeded results unchanged.
+    bool common_random_numbers = false;
+    // Record each tracked response time's visit count (ResponseTimes::
+    // visits); off, tracking stores only the times.
+    bool track_visits = false;
+    // Progress and cancellation of the replicate() call in flight.
+    ReplicationControl control;
+    // Hot-path counters and phase timings of the last sim(); filled only
+    // in builds with QUEUE_SIM_PROFILE (profile.enabled says which).
+    RunProfile profile;
 
     QueueSystem(std::vector<std::shared_ptr<Server>> servers,
                 Distribution arrivalDist,
-                std::vector<std::vector<double>> transitionMatrix = {})
+                std::vector<std::vector<double>> transitionMatrix = {},
+                RngKind rng_kind = RngKind::MT19937_64)
         : servers(std::move(servers)),
           arrivalDist(std::move(arrivalDist)),
-          transitionMatrix(std::move(transitionMatrix)) {}
+          transitionMatrix(std::move(transitionMatrix)),
+          rng_kind(rng_kind) {}
 
     void addServer(std::shared_ptr<Server> server) {
         servers.push_back(std::move(server));
@@ -65,301 +136,729 @@ public:
                                   int seed = -1,
                                   int warmup = 0,
                                   bool track_response_times = false,
-                                  bool track_events = false) {
+                                  bool track_events = false,
+                                  ResponseTimes response_buffer = {},
+                                  bool sketch_response_times = false,
+                                  const std::string& event_log_path = "",
+                                  int n_batches = 0) {
         verifyTransitionMatrix();
-        uint64_t resolved_seed;
-        if (seed >= 0) {
-            resolved_seed = static_cast<uint64_t>(seed);
-        } else {
-            std::random_device rd;
-            resolved_seed = static_cast<uint64_t>(rd()) |
-                            (static_cast<uint64_t>(rd()) << 32);
-        }
-        response_times.clear();
-        std::vector<double>* rt_ptr = nullptr;
-        if (track_response_times) {
-            response_times.reserve(num_events);
+        if (n_batches != 0 && (n_batches < 2 || n_batches > num_events)) {
+            throw std::invalid_argument(
+                "n_batches must be 0 or in [2, num_events], got " +
+                std::to_string(n_batches));
+        }
+        RoutingTable routing(transitionMatrix);
+        uint64_t resolved_seed = resolveSeed(seed);
+        // A caller-supplied buffer (capacity >= num_events) implies
+        // tracking and is filled in place.
+        response_times = ResponseTimes();
+        ResponseTimes* rt_ptr = nullptr;
+        if (response_buffer.data) {
+            if (response_buffer.capacity < static_cast<size_t>(num_events)) {
+                throw std::invalid_argument(
+                    "response time buffer must hold at least num_events (" +
+                    std::to_string(num_events) + ") values, got " +
+                    std::to_string(response_buffer.capacity));
+            }
+            response_times = std::move(response_buffer);
+            response_times.size = 0;
+            if (track_visits) response_times.trackVisits();
+            rt_ptr = &response_times;
+        } else if (track_response_times) {
+            response_times = ResponseTimes::allocate(num_events, track_visits);
             rt_ptr = &response_times;
         }
-        event_log.clear();
+        // With a path, events are streamed to that file in chunks and
+        // event_log is left empty; otherwise the whole trace stays in RAM.
+        event_log = std::make_shared<EventLog>();
         EventLog* el_ptr = nullptr;
-        if (track_events) {
-            event_log.reserve(num_events * 2);
-            el_ptr = &event_log;
-        }
-        auto [mean_n, mean_t] = sim_internal(
-            servers, arrivalDist, transitionMatrix, num_events,
-            resolved_seed, warmup, rt_ptr, el_ptr);
-        T = mean_t;
-        return {mean_n, mean_t};
+        std::shared_ptr<EventLogWriter> writer;
+        if (!event_log_path.empty()) {
+            writer = std::make_shared<EventLogWriter>(event_log_path);
+            event_log->streamTo(
+                [writer](const EventLog& chunk) { writer->write(chunk); },
+                EVENT_LOG_CHUNK);
+            el_ptr = event_log.get();
+        } else if (track_events) {
+            if (event_window.capacity) {
+                event_log->keepLast(event_window);
+            } else {
+                event_log->reserve(static_cast<size_t>(num_events) * 2);
+            }
+            el_ptr = event_log.get();
+        }
+        ResponseTimeSketch* sk_ptr = nullptr;
+        if (sketch_response_times) {
+            sketch = ResponseTimeSketch(sketch_accuracy,
+                                        static_cast<int>(servers.size()));
+            sk_ptr = &sketch;
+        } else {
+            sketch = ResponseTimeSketch();
+        }
+        batch_means = BatchMeans(n_batches);
+        BatchMeans* bm_ptr = n_batches ? &batch_means : nullptr;
+        std::pair<double, double> result;
+        class_stats.clear();
+        bool specialized = withSpecialized(routing, [&](auto& fast) {
+            result = fast.sim(scratch, num_events, resolved_seed, warmup,
+                              rt_ptr, el_ptr, sk_ptr, bm_ptr, nullptr,
+                              &profile);
+            // Publish the final per-server counters (num_rejected, T, ...)
+            // and the end-of-run state and clock, as the generic path
+            // leaves them, onto the caller's objects.  Their queues and
+            // run pointers (rng, pool) are left alone: those of `fast`
+            // die with it.
+            for (size_t i = 0; i < servers.size(); ++i) {
+                Server& mine = *servers[i];
+                const Server& theirs = fast.servers[i];
+                publishCounters(mine, theirs, theirs.stats);
+                mine.state = theirs.state;
+                mine.clock = theirs.clock;
+            }
+        });
+        if (!specialized && !classes.empty()) {
+            auto srvs = SimEngine::handles(servers);
+            auto routings = classRoutings();
+            MultiClassTraffic traffic(classes, routings);
+            result = SimEngine::simLoop(
+                scratch, srvs, traffic, num_events, resolved_seed, warmup,
+                rngConfig(), rt_ptr, el_ptr, sk_ptr, bm_ptr, nullptr,
+                &profile);
+            class_stats = *traffic.classStats();
+        } else if (!specialized) {
+            auto srvs = SimEngine::handles(servers);
+            result = SimEngine::sim_internal(
+                scratch, srvs, arrivalDist, routing, num_events,
+                resolved_seed, warmup, rngConfig(), rt_ptr, el_ptr, sk_ptr,
+                bm_ptr, nullptr, &profile);
+        }
+        if (writer) {
+            event_log->flush();
+            event_log->streamTo(nullptr, 0);
+            writer->close();
+        }
+        event_log->finishWindow();
+        T = result.second;
+        return result;
     }
 
     ReplicationRawResult replicate(int n_replications = 30,
                                    int num_events = 1000000,
                                    int seed = -1,
                                    int warmup = 0,
-                                   int n_threads = 0) {
-        uint64_t base_seed;
-        if (seed >= 0) {
-            base_seed = static_cast<uint64_t>(seed);
-        } else {
-            std::random_device rd;
-            base_seed = static_cast<uint64_t>(rd()) |
-                        (static_cast<uint64_t>(rd()) << 32);
-        }
+                                   int n_threads = 0,
+                                   bool track_response_times = false,
+                                   bool track_events = false,
+                                   bool sketch_response_times = false,
+                                   const StoppingRule* stopping = nullptr,
+                                   const ProgressFn& progress = ProgressFn(),
+                                   bool vectorized = false) {
+        uint64_t base_seed = resolveSeed(seed);
 
         verifyTransitionMatrix();
+        RoutingTable routing(transitionMatrix);
+        // The lockstep engine gives the same results, so `vectorized` only
+        // picks the engine; runs it cannot do (traces, other systems) fall
+        // through to the event loop.
+        if (vectorized && !track_response_times && !track_events &&
+            !sketch_response_times) {
+            ReplicationRawResult result;
+            bool ran = withLockstep(routing, [&](const auto& batch) {
+                result = batch.replicate(n_replications, num_events, base_seed,
+                                         warmup, n_threads, stopping, &control,
+                                         progress);
+            });
+            if (ran) return result;
+        }
+        const ResponseTimeSketch prototype =
+            sketch_response_times
+                ? ResponseTimeSketch(sketch_accuracy,
+                                     static_cast<int>(servers.size()))
+                : ResponseTimeSketch();
+        const ResponseTimeSketch* proto_ptr =
+            sketch_response_times ? &prototype : nullptr;
 
-        int actual_threads = n_threads;
-        if (actual_threads <= 0) {
-            actual_threads = static_cast<int>(
-                std::thread::hardware_concurrency());
-            if (actual_threads <= 0) actual_threads = 1;
+        ReplicationRawResult result;
+        bool specialized = withSpecialized(routing, [&](auto& fast) {
+            result = fast.replicate(n_replications, num_events, base_seed,
+                                    warmup, n_threads, track_response_times,
+                                    track_visits, track_events, proto_ptr,
+                                    event_window, stopping, &control,
+                                    progress);
+        });
+        if (specialized) return result;
+
+        auto run = [&](const auto& traffic) {
+            return SimEngine::replicate(
+                [this] { return cloneServers(); }, traffic, n_replications,
+                num_events, base_seed, warmup, n_threads, rngConfig(),
+                track_response_times, track_visits, track_events, proto_ptr,
+                event_window, stopping, &control, progress);
+        };
+        if (!classes.empty()) {
+            auto routings = classRoutings();
+            return run(MultiClassTraffic(classes, routings));
         }
-        actual_threads = std::min(actual_threads, n_replications);
+        return run(SingleClassTraffic<Distribution>(arrivalDist, routing));
+    }
+
+    // -- Snapshots --
+    //
+    // A Snapshot is a resumable run (see snapshot.hpp).  warmUp() starts
+    // one from an empty system; simFrom() measures it further, and
+    // replicateFrom() forks independent replications off it.  Snapshots
+    // need a single-class system and a single random stream.
+
+    // Start a run from `seed` and take it through `warmup` departures.
+    Snapshot warmUp(int warmup = 0, int seed = -1) const {
+        RoutingTable routing = snapshotRouting();
+        Snapshot snap(servers, arrivalDist, resolveSeed(seed), rng_kind);
+        snap.warmUp(routing, warmup);
+        return snap;
+    }
+
+    // Rebuild a snapshot saved by Snapshot::save() for this system.
+    Snapshot loadSnapshot(const std::string& bytes) const {
+        snapshotRouting();
+        Snapshot snap(servers, arrivalDist, 0, rng_kind);
+        snap.load(bytes);
+        return snap;
+    }
+
+    // Continue `snap` until it has measured `num_events` departures in
+    // total and return its cumulative (mean N, mean T); warmUp(w, s)
+    // then simFrom(n) equals sim(n, s, w).  The servers' counters and
+    // statistics are published onto this system as after sim().
+    std::pair<double, double> simFrom(Snapshot& snap, int num_events) {
+        RoutingTable routing = snapshotRouting();
+        checkSnapshot(snap);
+        auto result = snap.run(routing, num_events);
+        std::vector<ServerStats> stats = snap.serverStats();
+        for (size_t i = 0; i < servers.size(); ++i) {
+            publishCounters(*servers[i], *snap.system.servers[i], stats[i]);
+        }
+        T = result.second;
+        return result;
+    }
+
+    // n_replications independent continuations of `snap`, each measuring
+    // num_events departures from the snapshot's point on, with replication
+    // r drawing from derive_seed(seed, r).  The warmup is paid once, in
+    // the snapshot, instead of per replication.
+    ReplicationRawResult replicateFrom(const Snapshot& snap,
+                                       int n_replications = 30,
+                                       int num_events = 1000000,
+                                       int seed = -1,
+                                       int n_threads = 0,
+                                       const ProgressFn& progress = ProgressFn()) {
+        RoutingTable routing = snapshotRouting();
+        checkSnapshot(snap);
+        uint64_t base_seed = resolveSeed(seed);
+        int n = std::max(0, n_replications);
+        std::vector<double> raw_N(n), raw_T(n);
+        std::vector<std::vector<ServerStats>> stats(n);
+        control.cancel.store(false);
+        control.done.store(0);
+        control.total.store(n);
+        std::vector<char> finished = SimEngine::runTasks(
+            n, n_threads, control, progress, [&] {
+                return [&](int r) {
+                    Snapshot fork = snap;
+                    fork.rng.seed(derive_seed(base_seed, static_cast<uint64_t>(r)),
+                                  rng_kind);
+                    fork.beginMeasurement();
+                    auto [N, t] = fork.run(routing, num_events, &control.cancel);
+                    if (control.cancel.load()) return false;
+                    raw_N[r] = N;
+                    raw_T[r] = t;
+                    stats[r] = fork.serverStats();
+                    return true;
+                };
+            });
 
         ReplicationRawResult result;
-        result.raw_N.resize(n_replications);
-        result.raw_T.resize(n_replications);
+        for (int r = 0; r < n; ++r) {
+            if (!finished[r]) continue;
+            result.raw_N.push_back(raw_N[r]);
+            result.raw_T.push_back(raw_T[r]);
+            result.server_stats.push_back(std::move(stats[r]));
+        }
+        result.cancelled = static_cast<int>(result.raw_T.size()) < n;
+        return result;
+    }
 
-        auto worker = [&](int start, int end) {
-            // Clone servers once for this thread
-            std::vector<std::shared_ptr<Server>> local_servers;
-            local_servers.reserve(servers.size());
+    // Steady-state loss probability by multilevel splitting (see
+    // Splitting): n_runs independent estimates, run in parallel from
+    // derive_seed(seed, r) and reported with their confidence interval.
+    // Progress, cancellation and `control` work as in replicate(), in
+    // finished runs.  Single-class systems only.
+    SplittingResult estimateLoss(const SplittingRule& rule = SplittingRule(),
+                                 int n_runs = 10,
+                                 int seed = -1,
+                                 int n_threads = 0,
+                                 double confidence = 0.95,
+                                 const ProgressFn& progress = ProgressFn()) {
+        if (!classes.empty()) {
+            throw std::invalid_argument(
+                "estimateLoss supports single-class systems only");
+        }
+        if (servers.empty()) {
+            throw std::invalid_argument("estimateLoss needs at least one server");
+        }
+        if (n_runs < 1) {
+            throw std::invalid_argument(
+                "n_runs must be >= 1, got " + std::to_string(n_runs));
+        }
+        if (!(confidence > 0.0 && confidence < 1.0)) {
+            throw std::invalid_argument("confidence must be in (0, 1)");
+        }
+        rule.validate();
+        verifyTransitionMatrix();
+        uint64_t base_seed = resolveSeed(seed);
+
+        SplittingResult result;
+        result.confidence = confidence;
+        result.levels = rule.levels;
+        if (result.levels.empty()) {
+            int capacity = 0;
             for (const auto& s : servers) {
-                local_servers.push_back(s->clone());
+                if (s->buffer_capacity < 0) {
+                    throw std::invalid_argument(
+                        "estimateLoss needs explicit levels unless every "
+                        "server has a finite buffer_capacity");
+                }
+                capacity += s->buffer_capacity;
             }
+            for (int l = 2; l <= capacity; ++l) result.levels.push_back(l);
+        }
 
-            for (int i = start; i < end; ++i) {
-                uint64_t rep_seed =
-                    derive_seed(base_seed, static_cast<uint64_t>(i));
-                auto [n, t] = sim_internal(
-                    local_servers, arrivalDist, transitionMatrix,
-                    num_events, rep_seed, warmup);
-                result.raw_N[i] = n;
-                result.raw_T[i] = t;
+        RoutingTable routing(transitionMatrix);
+        const SystemState empty(servers, arrivalDist);
+        std::vector<double> raw(n_runs), arrivals(n_runs);
+        std::vector<std::vector<double>> p(n_runs);
+        std::vector<int64_t> events(n_runs, 0);
+        control.cancel.store(false);
+        control.done.store(0);
+        control.total.store(n_runs);
+        std::vector<char> finished = SimEngine::runTasks(
+            n_runs, n_threads, control, progress, [&] {
+                return [&](int r) {
+                    raw[r] = Splitting::run(
+                        empty, routing, rule, result.levels,
+                        derive_seed(base_seed, static_cast<uint64_t>(r)),
+                        rng_kind, p[r], arrivals[r], events[r],
+                        &control.cancel);
+                    return !control.cancel.load();
+                };
+            });
+
+        size_t m = result.levels.size();
+        result.level_probabilities.assign(m, 0.0);
+        for (int r = 0; r < n_runs; ++r) {
+            if (!finished[r]) continue;
+            result.raw.push_back(raw[r]);
+            result.arrivals_per_cycle += arrivals[r];
+            for (size_t i = 0; i < m; ++i) {
+                result.level_probabilities[i] += p[r][i];
             }
-        };
+        }
+        for (int64_t e : events) result.events += e;
+        result.cancelled = static_cast<int>(result.raw.size()) < n_runs;
+        if (result.raw.empty()) return result;
+
+        double n = static_cast<double>(result.raw.size());
+        result.arrivals_per_cycle /= n;
+        for (double& v : result.level_probabilities) v /= n;
+        result.loss_probability = sampleMean(result.raw);
+        if (result.raw.size() >= 2) {
+            result.half_width = ciHalfWidth(result.raw, confidence);
+        }
+        return result;
+    }
 
-        if (actual_threads == 1) {
-            worker(0, n_replications);
-        } else {
-            std::vector<std::thread> threads;
-            threads.reserve(actual_threads);
-            int chunk = n_replications / actual_threads;
-            int remainder = n_replications % actual_threads;
-            int start = 0;
-            for (int t = 0; t < actual_threads; ++t) {
-                int end = start + chunk + (t < remainder ? 1 : 0);
-                threads.emplace_back(worker, start, end);
-                start = end;
-            }
-            for (auto& th : threads) {
-                th.join();
-            }
+    // Whether replicate(..., vectorized=true) can use the lockstep engine
+    // (lockstep.hpp): one single-channel FCFS or SRPT server with no
+    // feedback, a single class, and exponential, uniform or bounded
+    // Pareto arrivals and sizes.
+    bool vectorizable() const {
+        if (!transitionMatrix.empty()) verifyTransitionMatrix();
+        RoutingTable routing(transitionMatrix);
+        return withLockstep(routing, [](const auto&) {});
+    }
+
+    // Ask a running replicate() (on another thread) to stop; it returns
+    // the replications finished so far with `cancelled` set.
+    void cancel() { control.cancel.store(true); }
+
+    // (finished, requested) replications of the current or last replicate().
+    std::pair<int, int> progress() const {
+        return {control.done.load(), control.total.load()};
+    }
+
+    // Run n_replications replications of every system in `systems` (a
+    // grid of load levels, size distributions, policies, ...) in one pass
+    // over the shared thread pool.  Each (system, replication) pair is an
+    // independent task pulled from one counter, so cheap configurations
+    // never sit behind expensive ones, and each runs on private copies of
+    // the servers: the systems themselves are not modified.  Replication
+    // r of every system starts from derive_seed(seed, r), so its row
+    // equals that system's own replicate() with the same arguments and
+    // the systems share seeds; set common_random_numbers on them (or use
+    // compare()) to also share the draws themselves.
+    //
+    // Progress is reported in finished runs out of
+    // systems.size() * n_replications; cancellation (via `control` or a
+    // throwing `progress`) works as in replicate().
+    static SweepResult sweep(const std::vector<const QueueSystem*>& systems,
+                             int n_replications = 30,
+                             int num_events = 1000000,
+                             int seed = -1,
+                             int warmup = 0,
+                             int n_threads = 0,
+                             ReplicationControl* control = nullptr,
+                             const ProgressFn& progress = ProgressFn()) {
+        return runSweep(systems, n_replications, num_events, seed, warmup,
+                        n_threads, false, control, progress);
+    }
+
+    // Paired comparison of several configurations (typically one network
+    // under different policies): a sweep in which every system runs with
+    // common random numbers, reduced to the confidence interval of each
+    // configuration's mean response time minus configuration 0's.  Pairing
+    // replication r across configurations cancels the traffic they share,
+    // so the difference interval is usually far narrower than the two
+    // independent intervals suggest.
+    static PairedComparison compare(
+            const std::vector<const QueueSystem*>& systems,
+            int n_replications = 30,
+            int num_events = 1000000,
+            int seed = -1,
+            int warmup = 0,
+            int n_threads = 0,
+            double confidence = 0.95,
+            ReplicationControl* control = nullptr,
+            const ProgressFn& progress = ProgressFn()) {
+        if (!(confidence > 0.0 && confidence < 1.0)) {
+            throw std::invalid_argument("confidence must be in (0, 1)");
+        }
+        SweepResult sweep = runSweep(systems, n_replications, num_events,
+                                     seed, warmup, n_threads, true, control,
+                                     progress);
+        PairedComparison result;
+        result.confidence = confidence;
+        result.cancelled = sweep.cancelled;
+        result.rows = std::move(sweep.rows);
+
+        int n_configs = static_cast<int>(systems.size());
+        int n_reps = std::max(0, n_replications);
+        const double nan = std::numeric_limits<double>::quiet_NaN();
+        std::vector<std::vector<double>> T(
+            n_configs, std::vector<double>(n_reps, nan));
+        std::vector<int> finished_in(n_reps, 0);
+        for (const SweepRow& row : result.rows) {
+            T[row.config][row.replication] = row.mean_T;
+            finished_in[row.replication] += 1;
         }
 
+        auto halfWidth = [&](const std::vector<double>& v) {
+            return v.size() >= 2 ? ciHalfWidth(v, confidence) : nan;
+        };
+        for (int c = 0; c < n_configs; ++c) {
+            std::vector<double> own, diff;
+            for (int r = 0; r < n_reps; ++r) {
+                if (!std::isnan(T[c][r])) own.push_back(T[c][r]);
+                if (finished_in[r] == n_configs) {
+                    diff.push_back(T[c][r] - T[0][r]);
+                }
+            }
+            result.mean_T.push_back(own.empty() ? nan : sampleMean(own));
+            result.half_width.push_back(halfWidth(own));
+            result.diff_mean.push_back(diff.empty() ? nan : sampleMean(diff));
+            result.diff_half_width.push_back(halfWidth(diff));
+        }
+        result.n_paired = static_cast<int>(
+            std::count(finished_in.begin(), finished_in.end(), n_configs));
         return result;
     }
 
 private:
-    void verifyTransitionMatrix() const {
-        if (transitionMatrix.empty()) return;
-
-        int n_servers = static_cast<int>(servers.size());
-        int n_rows = static_cast<int>(transitionMatrix.size());
-        if (n_rows != n_servers) {
-            throw std::invalid_argument(
-                "Transition matrix must have " + std::to_string(n_servers) +
-                " rows, got " + std::to_string(n_rows));
+    // sweep(), with `force_crn` running every system under common random
+    // numbers whatever its own setting.
+    static SweepResult runSweep(const std::vector<const QueueSystem*>& systems,
+                                int n_replications, int num_events, int seed,
+                                int warmup, int n_threads, bool force_crn,
+                                ReplicationControl* control,
+                                const ProgressFn& progress) {
+        uint64_t base_seed = resolveSeed(seed);
+        std::vector<RoutingTable> routings;
+        routings.reserve(systems.size());
+        for (const QueueSystem* system : systems) {
+            if (!system) throw std::invalid_argument("sweep: null system");
+            system->verifyTransitionMatrix();
+            routings.emplace_back(system->transitionMatrix);
         }
-        for (int i = 0; i < n_rows; ++i) {
-            if (static_cast<int>(transitionMatrix[i].size()) != n_servers + 1) {
-                throw std::invalid_argument(
-                    "Transition matrix row " + std::to_string(i) +
-                    " must have " + std::to_string(n_servers + 1) +
-                    " columns, got " +
-                    std::to_string(transitionMatrix[i].size()));
-            }
-            double row_sum = 0.0;
-            for (double v : transitionMatrix[i]) row_sum += v;
-            if (std::abs(row_sum - 1.0) > 1e-9) {
-                throw std::invalid_argument(
-                    "Transition matrix row " + std::to_string(i) +
-                    " sums to " + std::to_string(row_sum) + ", expected 1.0");
-            }
+
+        int n_reps = std::max(0, n_replications);
+        int n_tasks = static_cast<int>(systems.size()) * n_reps;
+        ReplicationControl local_control;
+        ReplicationControl& ctl = control ? *control : local_control;
+        ctl.cancel.store(false);
+        ctl.done.store(0);
+        ctl.total.store(n_tasks);
+
+        SweepResult result;
+        if (n_tasks == 0) return result;
+        std::vector<SweepRow> rows(n_tasks);
+        std::vector<char> finished = SimEngine::runTasks(
+            n_tasks, n_threads, ctl, progress, [&] {
+                return [&, scratch = RunScratch()](int task) mutable {
+                    int c = task / n_reps;
+                    int r = task % n_reps;
+                    uint64_t rep_seed =
+                        derive_seed(base_seed, static_cast<uint64_t>(r));
+                    auto [n, t] = systems[c]->simDetached(
+                        scratch, routings[c], num_events, rep_seed, warmup,
+                        force_crn || systems[c]->common_random_numbers,
+                        &ctl.cancel);
+                    if (ctl.cancel.load()) return false;
+                    rows[task] = {c, r, rep_seed, n, t};
+                    return true;
+                };
+            });
+
+        result.rows.reserve(n_tasks);
+        for (int i = 0; i < n_tasks; ++i) {
+            if (finished[i]) result.rows.push_back(rows[i]);
         }
+        result.cancelled = static_cast<int>(result.rows.size()) < n_tasks;
+        return result;
     }
 
-    static double minTTNC(
-            const std::vector<std::shared_ptr<Server>>& srvs) {
-        double m = std::numeric_limits<double>::infinity();
-        for (const auto &s : srvs) {
-            m = std::min(m, s->queryTTNC());
+    // Copy a finished run's counters onto one of this system's servers.
+    static void publishCounters(Server& mine, const Server& theirs,
+                                const ServerStats& stats) {
+        mine.T = theirs.T;
+        mine.num_completions = theirs.num_completions;
+        mine.num_rejected = theirs.num_rejected;
+        mine.num_arrivals = theirs.num_arrivals;
+        mine.stats = stats;
+    }
+
+    static uint64_t resolveSeed(int seed) {
+        if (seed >= 0) return static_cast<uint64_t>(seed);
+        std::random_device rd;
+        return static_cast<uint64_t>(rd()) |
+               (static_cast<uint64_t>(rd()) << 32);
+    }
+
+    std::vector<std::shared_ptr<Server>> cloneServers() const {
+        std::vector<std::shared_ptr<Server>> local;
+        local.reserve(servers.size());
+        for (const auto& s : servers) local.push_back(s->clone());
+        return local;
+    }
+
+    // One run on private copies of the servers, leaving this system
+    // untouched, so concurrent calls are safe.
+    std::pair<double, double> simDetached(RunScratch& scratch,
+                                          const RoutingTable& routing,
+                                          int num_events, uint64_t seed,
+                                          int warmup, bool crn,
+                                          const std::atomic<bool>* stop) const {
+        RngConfig rng(rng_kind, crn);
+        std::pair<double, double> result;
+        bool specialized = withSpecialized(routing, [&](auto& fast) {
+            fast.rngConfig = rng;
+            result = fast.sim(scratch, num_events, seed, warmup,
+                              nullptr, nullptr, nullptr, nullptr, stop);
+        });
+        if (specialized) return result;
+        auto local = cloneServers();
+        auto srvs = SimEngine::handles(local);
+        if (!classes.empty()) {
+            auto routings = classRoutings();
+            MultiClassTraffic traffic(classes, routings);
+            return SimEngine::simLoop(
+                scratch, srvs, traffic, num_events, seed, warmup, rng,
+                nullptr, nullptr, nullptr, nullptr, stop);
         }
-        return m;
+        return SimEngine::sim_internal(
+            scratch, srvs, arrivalDist, routing, num_events, seed, warmup,
+            rng, nullptr, nullptr, nullptr, nullptr, stop);
     }
 
-    static int routeJob(int server_idx, std::mt19937_64 &rng,
-                         const std::vector<std::vector<double>>& tm,
-                         int n_servers) {
-        if (tm.empty()) {
-            return server_idx + 1;
-        }
-        std::uniform_real_distribution<double> u(0.0, 1.0);
-        double r = u(rng);
-        double acc = 0.0;
-        const auto &row = tm[server_idx];
-        for (int i = 0; i < static_cast<int>(row.size()); ++i) {
-            acc += row[i];
-            if (r < acc) return i;
-        }
-        // Numerical safety: fall through -> exit
-        return n_servers;
+    RngConfig rngConfig() const {
+        return RngConfig(rng_kind, common_random_numbers);
     }
 
-    static std::pair<double, double> sim_internal(
-            std::vector<std::shared_ptr<Server>>& srvs,
-            Distribution arrival_dist,
-            const std::vector<std::vector<double>>& tm,
-            int num_events,
-            uint64_t seed,
-            int warmup,
-            std::vector<double>* response_times = nullptr,
-            EventLog* event_log = nullptr) {
-        std::mt19937_64 rng(seed);
-        int n_servers = static_cast<int>(srvs.size());
-
-        for (auto &s : srvs) {
-            s->setRNG(&rng);
-            s->reset();
-        }
-
-        int num_completions = 0;
-        double ttna = sample(arrival_dist, rng);
-        int state = 0;
-
-        // -- warmup phase (no accumulation) ----------------------------------
-        if (warmup > 0) {
-            int warmup_done = 0;
-            while (warmup_done < warmup) {
-                double ttnc = minTTNC(srvs);
-                double ttne = std::min(ttnc, ttna);
-                std::vector<int> completed;
-                for (int i = 0; i < n_servers; ++i) {
-                    if (srvs[i]->update(ttne)) {
-                        completed.push_back(i);
-                    }
-                }
-                for (int idx : completed) {
-                    int dest = routeJob(idx, rng, tm, n_servers);
-                    if (dest >= n_servers) {
-                        warmup_done += 1;
-                        state -= 1;
-                    } else {
-                        srvs[dest]->num_arrivals += 1;
-                        if (srvs[dest]->is_full()) {
-                            srvs[dest]->num_rejected += 1;
-                            warmup_done += 1;
-                            state -= 1;
-                        } else {
-                            srvs[dest]->arrival();
-                        }
-                    }
-                }
-                if (ttna <= ttnc) {
-                    srvs[0]->num_arrivals += 1;
-                    if (srvs[0]->is_full()) {
-                        srvs[0]->num_rejected += 1;
-                    } else {
-                        state += 1;
-                        srvs[0]->arrival();
-                    }
-                    ttna = sample(arrival_dist, rng);
-                } else {
-                    ttna -= ttne;
-                }
-            }
+    RoutingTable snapshotRouting() const {
+        if (!classes.empty()) {
+            throw std::invalid_argument(
+                "snapshots support single-class systems only");
+        }
+        if (common_random_numbers) {
+            throw std::invalid_argument(
+                "snapshots do not support common_random_numbers");
         }
+        verifyTransitionMatrix();
+        return RoutingTable(transitionMatrix);
+    }
 
-        // Clear per-server rejection counters so measurement reflects
-        // only the measurement phase.
-        for (auto &s : srvs) {
-            s->num_rejected = 0;
-            s->num_arrivals = 0;
+    void checkSnapshot(const Snapshot& snap) const {
+        if (snap.system.servers.size() != servers.size()) {
+            throw std::invalid_argument(
+                "snapshot has " + std::to_string(snap.system.servers.size()) +
+                " servers, this system has " + std::to_string(servers.size()));
         }
+    }
 
-        // -- measurement phase -----------------------------------------------
-        double area_n = 0.0;
-        double clock = 0.0;
+    // One routing table per traffic class.
+    std::vector<RoutingTable> classRoutings() const {
+        std::vector<RoutingTable> routings;
+        routings.reserve(classes.size());
+        for (const auto& c : classes) {
+            routings.emplace_back(c.transitionMatrix.empty()
+                                      ? transitionMatrix
+                                      : c.transitionMatrix);
+        }
+        return routings;
+    }
 
-        while (num_completions < num_events) {
-            double ttnc = minTTNC(srvs);
-            double ttne = std::min(ttnc, ttna);
+    // Call fn(LockstepBatch&) for a system vectorizable() accepts.
+    // Returns false otherwise.
+    template <class Fn>
+    bool withLockstep(const RoutingTable& routing, Fn&& fn) const {
+        if (servers.size() != 1 || !classes.empty()) return false;
+        const Server& server = *servers.front();
+        if (!server.class_size_dists.empty()) return false;
+        if (!transitionMatrix.empty() && transitionMatrix[0][0] != 0.0)
+            return false;
+        if (auto* fcfs = dynamic_cast<const FCFS*>(&server)) {
+            if (fcfs->num_servers != 1) return false;
+            return tryLockstep<false>(fcfs->sizeDist, routing, fn);
+        }
+        if (auto* srpt = dynamic_cast<const SRPT*>(&server)) {
+            return tryLockstep<true>(srpt->sizeDist, routing, fn);
+        }
+        return false;
+    }
 
-            clock += ttne;
-            area_n += static_cast<double>(state) * ttne;
+    template <bool IsSRPT, class Fn>
+    bool tryLockstep(const Distribution& sizeDist, const RoutingTable& routing,
+                     Fn& fn) const {
+        bool ran = false;
+        visitCommon(arrivalDist, [&](const auto& arrival) {
+            ran = visitCommon(sizeDist, [&](const auto& size) {
+                using A = std::decay_t<decltype(arrival)>;
+                using S = std::decay_t<decltype(size)>;
+                LockstepBatch<IsSRPT, A, S> batch(
+                    arrival, size, servers.front()->buffer_capacity, routing,
+                    rngConfig());
+                fn(batch);
+            });
+        });
+        return ran;
+    }
 
-            std::vector<int> completed;
-            for (int i = 0; i < n_servers; ++i) {
-                if (srvs[i]->update(ttne)) {
-                    completed.push_back(i);
-                }
-            }
+    // Call fn(QueueSystemT&) on a devirtualized copy of this system if all
+    // servers share one policy and one size family, and both families are
+    // ones QueueSystemT is instantiated for.  Returns false otherwise, and
+    // for multi-class systems, which QueueSystemT does not model.
+    template <class Fn>
+    bool withSpecialized(const RoutingTable& routing, Fn&& fn) const {
+        if (!use_specialized || servers.empty() || !classes.empty())
+            return false;
+        for (const auto& s : servers) {
+            if (!s->class_size_dists.empty()) return false;
+        }
+        return trySpecialize<BasicFCFS>(routing, fn) ||
+               trySpecialize<BasicSRPT>(routing, fn) ||
+               trySpecialize<BasicPS>(routing, fn) ||
+               trySpecialize<BasicFB>(routing, fn);
+    }
 
-            for (int idx : completed) {
-                int dest = routeJob(idx, rng, tm, n_servers);
-                if (dest >= n_servers) {
-                    num_completions += 1;
-                    state -= 1;
-                    if (response_times) {
-                        response_times->push_back(
-                            srvs[idx]->_last_response_time);
-                    }
-                    if (event_log) {
-                        event_log->push(clock, EventLog::DEPARTURE, idx, EventLog::SYSTEM_EXIT, state);
-                    }
-                } else {
-                    srvs[dest]->num_arrivals += 1;
-                    if (srvs[dest]->is_full()) {
-                        srvs[dest]->num_rejected += 1;
-                        num_completions += 1;
-                        state -= 1;
-                        if (event_log) {
-                            event_log->push(clock, EventLog::REJECTION, idx, dest, state);
-                        }
-                    } else {
-                        srvs[dest]->arrival();
-                        if (event_log) {
-                            event_log->push(clock, EventLog::ROUTE, idx, dest, state);
-                        }
-                    }
+    template <template <class> class Policy, class Fn>
+    bool trySpecialize(const RoutingTable& routing, Fn& fn) const {
+        std::vector<const Policy<Distribution>*> generic;
+        generic.reserve(servers.size());
+        for (const auto& s : servers) {
+            auto* g = dynamic_cast<const Policy<Distribution>*>(s.get());
+            if (!g) return false;
+            if (!generic.empty() &&
+                g->sizeDist.index() != generic.front()->sizeDist.index())
+                return false;
+            generic.push_back(g);
+        }
+        bool ran = false;
+        visitCommon(arrivalDist, [&](const auto& arrival) {
+            ran = visitCommon(generic.front()->sizeDist, [&](const auto& size) {
+                using A = std::decay_t<decltype(arrival)>;
+                using S = std::decay_t<decltype(size)>;
+                std::vector<Policy<S>> fast;
+                fast.reserve(generic.size());
+                for (const auto* g : generic) {
+                    fast.push_back(g->template specialize<S>());
                 }
-            }
+                QueueSystemT<Policy, A, S> sys(std::move(fast), arrival,
+                                               routing, rngConfig());
+                fn(sys);
+            });
+        });
+        return ran;
+    }
 
-            if (ttna <= ttnc) {
-                srvs[0]->num_arrivals += 1;
-                if (srvs[0]->is_full()) {
-                    srvs[0]->num_rejected += 1;
-                    if (event_log) {
-                        event_log->push(clock, EventLog::REJECTION, EventLog::EXTERNAL, 0, state);
-                    }
-                } else {
-                    state += 1;
-                    srvs[0]->arrival();
-                    if (event_log) {
-                        event_log->push(clock, EventLog::ARRIVAL, EventLog::EXTERNAL, 0, state);
-                    }
-                }
-                ttna = sample(arrival_dist, rng);
-            } else {
-                ttna -= ttne;
+    // Checks the system's matrix and every traffic class (entry server,
+    // own matrix).
+    void verifyTransitionMatrix() const {
+        verifyMatrix(transitionMatrix, "Transition matrix");
+
+        int n_servers = static_cast<int>(servers.size());
+        if (classes.size() > static_cast<size_t>(INT16_MAX) + 1) {
+            throw std::invalid_argument(
+                "At most " + std::to_string(INT16_MAX + 1) +
+                " traffic classes are supported, got " +
+                std::to_string(classes.size()));
+        }
+        for (size_t c = 0; c < classes.size(); ++c) {
+            int entry = classes[c].entry_server;
+            if (entry < 0 || entry >= n_servers) {
+                throw std::invalid_argument(
+                    "Class " + std::to_string(c) + " entry_server " +
+                    std::to_string(entry) + " is out of range for " +
+                    std::to_string(n_servers) + " servers");
             }
+            verifyMatrix(classes[c].transitionMatrix,
+                         "Class " + std::to_string(c) + " transition matrix");
         }
+    }
 
-        double mean_n = area_n / clock;
-        double mean_t = area_n / std::max(1, num_completions);
-        return {mean_n, mean_t};
+    void verifyMatrix(const std::vector<std::vector<double>>& matrix,
+                      const std::string& what) const {
+        if (matrix.empty()) return;
+
+        int n_servers = static_cast<int>(servers.size());
+        int n_rows = static_cast<int>(matrix.size());
+        if (n_rows != n_servers) {
+            throw std::invalid_argument(
+                what + " must have " + std::to_string(n_servers) +
+                " rows, got " + std::to_string(n_rows));
+        }
+        for (int i = 0; i < n_rows; ++i) {
+            if (static_cast<int>(matrix[i].size()) != n_servers + 1) {
+                throw std::invalid_argument(
+                    what + " row " + std::to_string(i) +
+                    " must have " + std::to_string(n_servers + 1) +
+                    " columns, got " +
+                    std::to_string(matrix[i].size()));
+            }
+            double row_sum = 0.0;
+            for (double v : matrix[i]) row_sum += v;
+            if (std::abs(row_sum - 1.0) > 1e-9) {
+                throw std::invalid_argument(
+                    what + " row " + std::to_string(i) +
+                    " sums to " + std::to_string(row_sum) + ", expected 1.0");
+            }
+        }
     }
 };
 
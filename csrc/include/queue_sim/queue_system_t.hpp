@@ -0,0 +1,78 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "batch_means.hpp"
+#include "engine.hpp"
+#include "event_log.hpp"
+#include "profile.hpp"
+#include "quantile_sketch.hpp"
+#include "response_times.hpp"
+#include "rng.hpp"
+#include "routing.hpp"
+
+namespace queue_sim {
+
+// Devirtualized counterpart of QueueSystem for homogeneous networks: every
+// server runs Policy<SizeDist> and arrivals come from ArrivalDist.  Servers
+// are held by value as a `final` class, so the shared event loop inlines
+// policy and sampling code instead of going through virtual calls and
+// std::visit.  QueueSystem builds one automatically when a system
+// qualifies; it is not meant to outlive that call.
+template <template <class> class Policy, class ArrivalDist, class SizeDist>
+class QueueSystemT {
+public:
+    using ServerType = Policy<SizeDist>;
+
+    std::vector<ServerType> servers;
+    ArrivalDist arrivalDist;
+    const RoutingTable& routing;
+    RngConfig rngConfig;
+
+    QueueSystemT(std::vector<ServerType> servers, ArrivalDist arrivalDist,
+                 const RoutingTable& routing,
+                 RngConfig rngConfig = RngConfig())
+        : servers(std::move(servers)),
+          arrivalDist(std::move(arrivalDist)),
+          routing(routing),
+          rngConfig(rngConfig) {}
+
+    std::pair<double, double> sim(RunScratch& scratch, int num_events,
+                                  uint64_t seed, int warmup,
+                                  ResponseTimes* response_times,
+                                  EventLog* event_log,
+                                  ResponseTimeSketch* sketch = nullptr,
+                                  BatchMeans* batches = nullptr,
+                                  const std::atomic<bool>* stop = nullptr,
+                                  RunProfile* profile = nullptr) {
+        auto srvs = SimEngine::handles(servers);
+        return SimEngine::sim_internal(
+            scratch, srvs, arrivalDist, routing, num_events, seed,
+            warmup, rngConfig, response_times, event_log, sketch, batches,
+            stop, profile);
+    }
+
+    ReplicationRawResult replicate(int n_replications, int num_events,
+                                   uint64_t base_seed, int warmup,
+                                   int n_threads,
+                                   bool track_response_times = false,
+                                   bool track_visits = false,
+                                   bool track_events = false,
+                                   const ResponseTimeSketch* sketch_prototype = nullptr,
+                                   const EventWindow& event_window = EventWindow(),
+                                   const StoppingRule* stopping = nullptr,
+                                   ReplicationControl* control = nullptr,
+                                   const ProgressFn& progress = ProgressFn()) {
+        return SimEngine::replicate(
+            [this] { return servers; },
+            SingleClassTraffic<ArrivalDist>(arrivalDist, routing),
+            n_replications, num_events, base_seed, warmup, n_threads,
+            rngConfig, track_response_times, track_visits, track_events,
+            sketch_prototype, event_window, stopping, control, progress);
+    }
+};
+
+}  // namespace queue_sim
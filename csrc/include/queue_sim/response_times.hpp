@@ -0,0 +1,67 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+namespace queue_sim {
+
+// Per-job response times recorded by one run: `size` doubles at `data`,
+// each a job's end-to-end sojourn through the network, and, if asked for,
+// alongside them the number of stations it visited.
+//
+// The response-time storage is reached through a type-erased `owner` — an array
+// allocated here, or a caller-supplied buffer such as a NumPy array the
+// bindings keep a reference to — so results can be shared without a copy
+// and stay valid for as long as anyone holds them.
+struct ResponseTimes {
+    std::shared_ptr<void> owner;
+    double* data = nullptr;
+    size_t size = 0;
+    size_t capacity = 0;
+    // Null unless visit counts are tracked; then allocated here,
+    // `capacity` entries parallel to `data`.
+    std::shared_ptr<int32_t[]> visits;
+
+    // Fresh (uninitialized) storage for up to `capacity` samples, with
+    // visit counts if `with_visits`.
+    static ResponseTimes allocate(size_t capacity, bool with_visits = false) {
+        std::shared_ptr<double[]> buf(new double[capacity > 0 ? capacity : 1]);
+        ResponseTimes rt;
+        rt.data = buf.get();
+        rt.owner = std::move(buf);
+        rt.capacity = capacity;
+        if (with_visits) rt.trackVisits();
+        return rt;
+    }
+
+    // Record into `capacity` doubles of caller-owned memory; `owner`
+    // keeps that memory alive.  No visit counts unless trackVisits().
+    static ResponseTimes wrap(double* buffer, size_t capacity,
+                              std::shared_ptr<void> owner) {
+        ResponseTimes rt;
+        rt.data = buffer;
+        rt.owner = std::move(owner);
+        rt.capacity = capacity;
+        return rt;
+    }
+
+    void trackVisits() {
+        visits = std::shared_ptr<int32_t[]>(
+            new int32_t[capacity > 0 ? capacity : 1]);
+    }
+
+    // The engine sizes every sink for num_events samples up front and
+    // records at most one per measured completion, so this never checks.
+    void push(double t, int32_t n_visits) {
+        if (visits) visits[size] = n_visits;
+        data[size++] = t;
+    }
+
+    bool empty() const { return size == 0; }
+    double operator[](size_t i) const { return data[i]; }
+    const double* begin() const { return data; }
+    const double* end() const { return data + size; }
+};
+
+}  // namespace queue_sim
@@ -0,0 +1,349 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "profile.hpp"
+#include "serialize.hpp"
+
+namespace queue_sim {
+
+// SplitMix64 one-round (Steele / Vigna) — matches Python _splitmix64.
+inline uint64_t splitmix64(uint64_t x) {
+    static constexpr uint64_t PHI = 0x9E3779B97F4A7C15ULL;
+    x = (x + PHI);
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+inline uint64_t derive_seed(uint64_t base_seed, uint64_t index) {
+    static constexpr uint64_t PHI = 0x9E3779B97F4A7C15ULL;
+    return splitmix64(base_seed + index * PHI);
+}
+
+enum class RngKind : uint8_t {
+    MT19937_64,    // default; reproduces pre-Rng results bit for bit
+    XOSHIRO256PP,  // xoshiro256++ (Blackman / Vigna)
+    PCG64,         // PCG XSL-RR 128/64, the NumPy default bit generator
+};
+
+// How a run draws its random numbers: the generator family, and whether
+// draws are split into common-random-number substreams.  Without `crn` a
+// single generator serves every draw.  With it, arrivals, each server's
+// job sizes and each server's routing decisions have their own generator,
+// seeded derive_seed(seed, k) for k = 0 (arrivals), 1 + 2i (sizes at
+// server i) and 2 + 2i (routing out of server i), so systems that differ
+// only in policy see the same arrival times and the same n-th size and
+// route at every server, whatever order their events happen in.
+struct RngConfig {
+    RngKind kind;
+    bool crn;
+    RngConfig(RngKind kind = RngKind::MT19937_64, bool crn = false)
+        : kind(kind), crn(crn) {}
+
+    static uint64_t arrivalSeed(uint64_t seed) { return derive_seed(seed, 0); }
+    static uint64_t sizeSeed(uint64_t seed, int server) {
+        return derive_seed(seed, 1 + 2 * static_cast<uint64_t>(server));
+    }
+    static uint64_t routingSeed(uint64_t seed, int server) {
+        return derive_seed(seed, 2 + 2 * static_cast<uint64_t>(server));
+    }
+};
+
+// The simulation's random source: one generator, consumed through a
+// block of pre-drawn uniforms in [0, 1).
+//
+// Draws are taken strictly in stream order, so the block is invisible to
+// results; it only moves generator work out of the event loop into a
+// tight refill loop.  exponential() returns -log(1 - u) for the same
+// stream position uniform() would have returned, transforming the rest of
+// the block in one pass the first time it is asked for — with
+// MT19937_64 the variates are identical to std::uniform_real_distribution
+// followed by std::log.  boundedPareto() batches its inverse CDF the
+// same way on streams it has to itself.
+class Rng {
+public:
+    static constexpr int BLOCK = 256;
+
+    explicit Rng(uint64_t seed = 5489, RngKind kind = RngKind::MT19937_64) {
+        this->seed(seed, kind);
+    }
+
+    void seed(uint64_t seed, RngKind kind) {
+        kind_ = kind;
+        switch (kind_) {
+        case RngKind::MT19937_64:
+            mt.seed(seed);
+            break;
+        case RngKind::XOSHIRO256PP:
+            for (int i = 0; i < 4; ++i) xs[i] = derive_seed(seed, i);
+            break;
+        case RngKind::PCG64: {
+            // pcg_setseq_128_srandom_r: state and stream both from seed.
+            U128 init{derive_seed(seed, 0), derive_seed(seed, 1)};
+            inc = U128{derive_seed(seed, 2), derive_seed(seed, 3) | 1};
+            pcgState = U128{0, 0};
+            pcgStep();
+            pcgState = add(pcgState, init);
+            pcgStep();
+            break;
+        }
+        }
+        pos = BLOCK;
+        expFrom = BLOCK;
+        bpFrom = BLOCK;
+        bpBatch = false;
+        bpDraws = 0;
+        blocks = 0;
+    }
+
+    RngKind kind() const { return kind_; }
+
+    // Uniforms handed out since seeding (exponentials included).  Counted
+    // per block, and only in profiling builds; zero otherwise.
+    int64_t draws() const {
+        return blocks ? blocks * BLOCK - (BLOCK - pos) : 0;
+    }
+
+    // Exact generator state, including the unread part of the block, so a
+    // restored Rng continues the stream where this one stands.
+    void save(BinaryWriter& w) const {
+        w.put(kind_);
+        switch (kind_) {
+        case RngKind::MT19937_64: {
+            // The standard only exposes the Mersenne Twister state as
+            // text of decimal words; store the words.
+            std::stringstream mt_state;
+            mt_state << mt;
+            std::vector<uint64_t> words;
+            for (uint64_t x; mt_state >> x;) words.push_back(x);
+            w.put(words);
+            break;
+        }
+        case RngKind::XOSHIRO256PP:
+            w.put(xs, 4);
+            break;
+        case RngKind::PCG64:
+            w.put(pcgState);
+            w.put(inc);
+            break;
+        }
+        w.put(pos);
+        w.put(expFrom);
+        w.put(u + pos, BLOCK - pos);
+        int e_from = std::max(pos, expFrom);
+        w.put(e + e_from, BLOCK - e_from);
+    }
+
+    void load(BinaryReader& r) {
+        kind_ = r.get<RngKind>();
+        switch (kind_) {
+        case RngKind::MT19937_64: {
+            std::stringstream mt_state;
+            for (uint64_t x : r.getVector<uint64_t>()) mt_state << x << ' ';
+            mt_state >> mt;
+            if (!mt_state) BinaryReader::corrupt();
+            break;
+        }
+        case RngKind::XOSHIRO256PP:
+            r.getInto(xs, 4);
+            break;
+        case RngKind::PCG64:
+            pcgState = r.get<U128>();
+            inc = r.get<U128>();
+            break;
+        default:
+            BinaryReader::corrupt();
+        }
+        pos = r.get<int>();
+        expFrom = r.get<int>();
+        if (pos < 0 || pos > BLOCK || expFrom < 0 || expFrom > BLOCK)
+            BinaryReader::corrupt();
+        r.getInto(u + pos, BLOCK - pos);
+        int e_from = std::max(pos, expFrom);
+        r.getInto(e + e_from, BLOCK - e_from);
+        for (int i = pos; i < BLOCK; ++i) {
+            if (!(u[i] >= 0.0 && u[i] < 1.0)) BinaryReader::corrupt();
+        }
+        // -log(1 - u) of a double u < 1 is below 37.
+        for (int i = e_from; i < BLOCK; ++i) {
+            if (!(e[i] >= 0.0 && e[i] < 40.0)) BinaryReader::corrupt();
+        }
+        // The Pareto tail is a pure function of u, so it is not saved.
+        bpFrom = BLOCK;
+        bpBatch = false;
+        bpDraws = 0;
+        blocks = 0;
+    }
+
+    // Uniform on [0, 1).
+    double uniform() {
+        if (pos == BLOCK) refill();
+        return u[pos++];
+    }
+
+    // Standard exponential, -log(1 - U).
+    double exponential() {
+        if (pos == BLOCK) refill();
+        if (pos < expFrom) transformBlock();
+        return e[pos++];
+    }
+
+    // Bounded Pareto by inverse CDF, pow(-u / C + k^-alpha, -1/alpha), for
+    // the same stream position uniform() would have returned.  pow costs
+    // the same per slot batched or not, so a wasted slot costs more than
+    // batching saves: the rest of a block is only transformed when the
+    // previous block's draws took nearly every slot from the first one
+    // on (a stream of its own, e.g. sizes under common random numbers).
+    double boundedPareto(double C, double kNegAlpha, double negInvAlpha) {
+        if (pos == BLOCK) refill();
+        if (C != bpC || kNegAlpha != bpKNegAlpha ||
+            negInvAlpha != bpNegInvAlpha) {
+            // Another parameter set on this stream: count the block as
+            // shared and stop batching it.
+            bpC = C;
+            bpKNegAlpha = kNegAlpha;
+            bpNegInvAlpha = negInvAlpha;
+            bpFrom = BLOCK;
+            bpBatch = false;
+            bpDraws = 0;
+            bpStart = 0;
+        } else if (bpDraws == 0) {
+            bpStart = pos;
+        }
+        ++bpDraws;
+        if (pos < bpFrom) {
+            if (!bpBatch) {
+                return std::pow(-u[pos++] / C + kNegAlpha, negInvAlpha);
+            }
+            transformParetoBlock(C, kNegAlpha, negInvAlpha);
+        }
+        return bp[pos++];
+    }
+
+private:
+    RngKind kind_ = RngKind::MT19937_64;
+    std::mt19937_64 mt;
+    uint64_t xs[4] = {};
+
+    struct U128 { uint64_t hi, lo; };
+    U128 pcgState{0, 0};
+    U128 inc{0, 1};
+
+    alignas(64) double u[BLOCK];
+    alignas(64) double e[BLOCK];
+    alignas(64) double bp[BLOCK];
+    int pos = BLOCK;      // next unread slot
+    int expFrom = BLOCK;  // e[expFrom, BLOCK) is valid
+    int bpFrom = BLOCK;   // bp[bpFrom, BLOCK) is valid for the bp* constants
+    double bpC = 0.0, bpKNegAlpha = 0.0, bpNegInvAlpha = 0.0;
+    bool bpBatch = false; // transform this block's Pareto draws in one pass
+    int bpDraws = 0;      // Pareto draws in this block, from slot bpStart on
+    int bpStart = 0;
+    int64_t blocks = 0;   // refills since seeding (profiling builds only)
+
+    void refill() {
+        switch (kind_) {
+        case RngKind::MT19937_64:
+            // Exactly what uniform_real_distribution<double>(0, 1) does.
+            for (int i = 0; i < BLOCK; ++i) {
+                u[i] = std::generate_canonical<
+                    double, std::numeric_limits<double>::digits>(mt);
+            }
+            break;
+        case RngKind::XOSHIRO256PP:
+            for (int i = 0; i < BLOCK; ++i) u[i] = toUnit(xoshiroNext());
+            break;
+        case RngKind::PCG64:
+            for (int i = 0; i < BLOCK; ++i) u[i] = toUnit(pcgNext());
+            break;
+        }
+        pos = 0;
+        expFrom = BLOCK;
+        if (bpDraws > 0) bpBatch = bpDraws * 8 >= (BLOCK - bpStart) * 7;
+        bpDraws = 0;
+        bpFrom = BLOCK;
+        if constexpr (PROFILING) blocks += 1;
+    }
+
+    // Branch-free over the unread tail so the compiler can vectorize it
+    // (and use a vector log where the math library provides one).
+    void transformBlock() {
+        for (int i = pos; i < BLOCK; ++i) e[i] = -std::log(1.0 - u[i]);
+        expFrom = pos;
+    }
+
+    // Scalar pow, but still one branch-free pass over the unread tail.
+    void transformParetoBlock(double C, double kNegAlpha, double negInvAlpha) {
+        for (int i = pos; i < BLOCK; ++i) {
+            bp[i] = std::pow(-u[i] / C + kNegAlpha, negInvAlpha);
+        }
+        bpFrom = pos;
+    }
+
+    static double toUnit(uint64_t x) {
+        return static_cast<double>(x >> 11) * 0x1.0p-53;
+    }
+
+    static uint64_t rotl(uint64_t x, int k) {
+        return (x << k) | (x >> (64 - k));
+    }
+
+    uint64_t xoshiroNext() {
+        uint64_t result = rotl(xs[0] + xs[3], 23) + xs[0];
+        uint64_t t = xs[1] << 17;
+        xs[2] ^= xs[0];
+        xs[3] ^= xs[1];
+        xs[1] ^= xs[2];
+        xs[0] ^= xs[3];
+        xs[2] ^= t;
+        xs[3] = rotl(xs[3], 45);
+        return result;
+    }
+
+    // -- 128-bit arithmetic for PCG64 ------------------------------------
+
+    static U128 add(U128 a, U128 b) {
+        uint64_t lo = a.lo + b.lo;
+        return U128{a.hi + b.hi + (lo < a.lo ? 1 : 0), lo};
+    }
+
+    static U128 mul(U128 a, U128 b) {
+#if defined(__SIZEOF_INT128__)
+        unsigned __int128 p = static_cast<unsigned __int128>(a.lo) * b.lo;
+        uint64_t hi = static_cast<uint64_t>(p >> 64);
+        uint64_t lo = static_cast<uint64_t>(p);
+#else
+        uint64_t a0 = a.lo & 0xFFFFFFFFULL, a1 = a.lo >> 32;
+        uint64_t b0 = b.lo & 0xFFFFFFFFULL, b1 = b.lo >> 32;
+        uint64_t p00 = a0 * b0, p01 = a0 * b1, p10 = a1 * b0, p11 = a1 * b1;
+        uint64_t mid = (p00 >> 32) + (p01 & 0xFFFFFFFFULL) +
+                       (p10 & 0xFFFFFFFFULL);
+        uint64_t hi = p11 + (p01 >> 32) + (p10 >> 32) + (mid >> 32);
+        uint64_t lo = (mid << 32) | (p00 & 0xFFFFFFFFULL);
+#endif
+        return U128{hi + a.hi * b.lo + a.lo * b.hi, lo};
+    }
+
+    void pcgStep() {
+        static constexpr U128 MULT{0x2360ED051FC65DA4ULL,
+                                   0x4385DF649FCCF645ULL};
+        pcgState = add(mul(pcgState, MULT), inc);
+    }
+
+    uint64_t pcgNext() {
+        pcgStep();
+        uint64_t x = pcgState.hi ^ pcgState.lo;
+        int rot = static_cast<int>(pcgState.hi >> 58);
+        return (x >> rot) | (x << ((64 - rot) & 63));
+    }
+};
+
+}  // namespace queue_sim
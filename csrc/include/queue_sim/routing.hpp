@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "rng.hpp"
+
+namespace queue_sim {
+
+// Per-row Walker alias tables for a transition matrix, flattened into one
+// contiguous array.  Row i has n_servers + 1 columns (the last is system
+// exit); route() costs one uniform and one table entry regardless of how
+// many destinations a row has.
+//
+// A default-constructed (empty) table is a tandem line: server i always
+// routes to i + 1.
+class RoutingTable {
+public:
+    RoutingTable() = default;
+
+    // `tm` must already be validated (QueueSystem::verifyTransitionMatrix);
+    // rows are renormalized so their sums need only be close to 1.
+    explicit RoutingTable(const std::vector<std::vector<double>>& tm) {
+        if (tm.empty()) return;
+        cols = static_cast<int>(tm[0].size());
+        table.resize(tm.size() * static_cast<size_t>(cols));
+
+        std::vector<double> q(cols);
+        std::vector<int> small, large;
+        small.reserve(cols);
+        large.reserve(cols);
+        for (size_t i = 0; i < tm.size(); ++i) {
+            Entry* row = &table[i * cols];
+            double sum = 0.0;
+            for (double p : tm[i]) sum += p;
+
+            // Vose's construction: split columns into under- and
+            // over-full buckets of mass 1, then pair them off.
+            small.clear();
+            large.clear();
+            for (int j = 0; j < cols; ++j) {
+                q[j] = tm[i][j] / sum * cols;
+                (q[j] < 1.0 ? small : large).push_back(j);
+            }
+            while (!small.empty() && !large.empty()) {
+                int s = small.back();
+                small.pop_back();
+                int l = large.back();
+                row[s] = Entry{q[s], l};
+                q[l] = (q[l] + q[s]) - 1.0;
+                if (q[l] < 1.0) {
+                    large.pop_back();
+                    small.push_back(l);
+                }
+            }
+            // Whatever is left is full up to rounding error.
+            for (int j : large) row[j] = Entry{1.0, j};
+            for (int j : small) row[j] = Entry{1.0, j};
+        }
+    }
+
+    bool tandem() const { return cols == 0; }
+
+    int route(int from, Rng& rng) const {
+        if (cols == 0) return from + 1;
+        double x = rng.uniform() * cols;
+        int j = static_cast<int>(x);
+        // u * cols can round up to cols when u is within an ulp of 1.
+        if (j >= cols) j = cols - 1;
+        const Entry& e = table[static_cast<size_t>(from) * cols + j];
+        return (x - j) < e.threshold ? j : e.alias;
+    }
+
+private:
+    // Stay in column j with probability `threshold`, else go to `alias`.
+    // Kept together so a route touches a single cache line.
+    struct Entry {
+        double threshold;
+        int32_t alias;
+    };
+
+    int cols = 0;
+    std::vector<Entry> table;
+};
+
+}  // namespace queue_sim
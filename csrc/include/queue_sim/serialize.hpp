@@ -0,0 +1,116 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace queue_sim {
+
+// Minimal binary encoding for snapshots: values are written as their raw
+// bytes and vectors and strings are length-prefixed.  The encoding is the
+// platform's native one; snapshots carry a byte-order mark (see
+// Snapshot) and are meant to be restored by the same build on the same
+// kind of machine, e.g. after preemption on a batch cluster.
+class BinaryWriter {
+public:
+    template <class T>
+    void put(const T& value) {
+        static_assert(std::is_trivially_copyable<T>::value,
+                      "put() needs a trivially copyable type");
+        bytes.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    template <class T>
+    void put(const T* values, size_t n) {
+        static_assert(std::is_trivially_copyable<T>::value,
+                      "put() needs a trivially copyable type");
+        put<uint64_t>(n);
+        bytes.append(reinterpret_cast<const char*>(values), n * sizeof(T));
+    }
+
+    template <class T>
+    void put(const std::vector<T>& values) {
+        put(values.data(), values.size());
+    }
+
+    void put(const std::string& s) { put(s.data(), s.size()); }
+
+    const std::string& str() const { return bytes; }
+    std::string release() { return std::move(bytes); }
+
+private:
+    std::string bytes;
+};
+
+class BinaryReader {
+public:
+    explicit BinaryReader(const std::string& bytes)
+        : p(bytes.data()), end(bytes.data() + bytes.size()) {}
+
+    template <class T>
+    T get() {
+        static_assert(std::is_trivially_copyable<T>::value,
+                      "get() needs a trivially copyable type");
+        if constexpr (std::is_same<T, bool>::value) {
+            // Only 0 and 1 are bools; copying any other byte into one is
+            // undefined.
+            uint8_t byte = get<uint8_t>();
+            if (byte > 1) corrupt();
+            return byte == 1;
+        } else {
+            T value;
+            take(&value, sizeof(T));
+            return value;
+        }
+    }
+
+    template <class T>
+    std::vector<T> getVector() {
+        std::vector<T> values(count(sizeof(T)));
+        take(values.data(), values.size() * sizeof(T));
+        return values;
+    }
+
+    // Read a length-prefixed array into `out`, which must hold exactly
+    // `expected` elements.
+    template <class T>
+    void getInto(T* out, size_t expected) {
+        if (count(sizeof(T)) != expected) corrupt();
+        take(out, expected * sizeof(T));
+    }
+
+    std::string getString() {
+        std::string s(count(1), '\0');
+        take(&s[0], s.size());
+        return s;
+    }
+
+    bool done() const { return p == end; }
+
+    [[noreturn]] static void corrupt() {
+        throw std::invalid_argument("snapshot is truncated or corrupt");
+    }
+
+private:
+    const char* p;
+    const char* end;
+
+    size_t count(size_t element_size) {
+        uint64_t n = get<uint64_t>();
+        if (element_size && n > static_cast<uint64_t>(end - p) / element_size)
+            corrupt();
+        return static_cast<size_t>(n);
+    }
+
+    void take(void* out, size_t n) {
+        if (static_cast<size_t>(end - p) < n) corrupt();
+        if (n) std::memcpy(out, p, n);
+        p += n;
+    }
+};
+
+}  // namespace queue_sim
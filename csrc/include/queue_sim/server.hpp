@@ -1,45 +1,90 @@
 #pragma once
 
+#include <algorithm>
 #include <cmath>
-#include <deque>
+#include <cstdint>
 #include <limits>
-#include <random>
+#include <memory>
 #include <stdexcept>
+#include <string>
+#include <vector>
 
 #include "distributions.hpp"
+#include "job_pool.hpp"
+#include "rng.hpp"
+#include "serialize.hpp"
 
 namespace queue_sim {
 
+// Per-server measurement-phase statistics, accumulated by the event loop
+// whenever it touches the server (its state is constant in between), so
+// per-node metrics need no event log.
+struct ServerStats {
+    double area = 0.0;          // integral of state (jobs present) dt
+    double busy_time = 0.0;     // integral of busy channels dt
+    double duration = 0.0;      // measurement time, set when the run ends
+    int max_state = 0;
+    int num_servers = 1;
+    int64_t completions = 0;    // jobs finished here (including routed on)
+    double response_sum = 0.0;  // their time spent at this server
+
+    double meanState() const { return duration > 0.0 ? area / duration : 0.0; }
+    double utilization() const {
+        return duration > 0.0 ? busy_time / (duration * num_servers) : 0.0;
+    }
+    double meanResponseTime() const {
+        return completions ? response_sum / static_cast<double>(completions)
+                           : 0.0;
+    }
+};
+
+// Policies derive from Server and are class templates over their size
+// distribution: Basic<Policy><Distribution> is the generic, variant-backed
+// type exposed to Python, while e.g. BasicFCFS<ExponentialDist> is the
+// concrete type the specialized engine (QueueSystemT) runs.
+//
+// Jobs live in the run's JobPool; a server is handed a JobId on
+// arrival() and reports the one it finished in `_last_job`.
 class Server {
 public:
-    Distribution sizeDist;
-    std::mt19937_64 *rng = nullptr;
+    Rng *rng = nullptr;
+    JobPool *pool = nullptr;
 
     double clock = 0.0;
     double TTNC = std::numeric_limits<double>::infinity();
     double T = 0.0;
     int num_completions = 0;
     int state = 0;
-    std::deque<double> arrivalTimes;
+    JobQueue fifo;  // jobs present, in arrival order (single-channel FCFS)
 
     int num_servers;
     int buffer_capacity;
     int num_rejected = 0;
     int num_arrivals = 0;
     double _last_response_time = 0.0;
+    JobId _last_job = NO_JOB;
+    ServerStats stats;
+    // Job sizes per traffic class (indexed by Job::job_class); classes past
+    // the end, and every job when this is empty, draw from the policy's
+    // own size distribution.
+    std::vector<Distribution> class_size_dists;
 
-    explicit Server(Distribution sizeDist, int num_servers = 1,
-                    int buffer_capacity = -1)
-        : sizeDist(std::move(sizeDist)), num_servers(num_servers),
-          buffer_capacity(buffer_capacity) {
+    explicit Server(int num_servers = 1, int buffer_capacity = -1)
+        : num_servers(num_servers), buffer_capacity(buffer_capacity) {
         if (buffer_capacity == 0)
             throw std::invalid_argument(
                 "buffer_capacity must be >= 1 or -1 (unlimited)");
     }
     virtual ~Server() = default;
+    // A fresh server with this one's configuration.
     virtual std::shared_ptr<Server> clone() const = 0;
+    // An exact copy, dynamic state included (clock, jobs present, queues,
+    // counters), for forking a run mid-flight.  The copy still points at
+    // this server's rng and pool until it is given its own.
+    virtual std::shared_ptr<Server> cloneState() const = 0;
 
-    void setRNG(std::mt19937_64 *r) { rng = r; }
+    void setRNG(Rng *r) { rng = r; }
+    void setJobPool(JobPool *p) { pool = p; }
 
     bool is_full() const {
         return buffer_capacity >= 0 && state >= buffer_capacity;
@@ -54,38 +99,216 @@ public:
         num_rejected = 0;
         num_arrivals = 0;
         _last_response_time = 0.0;
-        arrivalTimes.clear();
+        _last_job = NO_JOB;
+        fifo.clear();
+        stats = ServerStats();
+        for (auto& d : class_size_dists) rewind(d);
+    }
+
+    // -- Snapshots --
+
+    // Dynamic state only: a snapshot is restored into a server with the
+    // same configuration, which loadState() checks.  Policies extend
+    // both, leading with their name.
+    virtual void saveState(BinaryWriter& w) const {
+        w.put(num_servers);
+        w.put(buffer_capacity);
+        w.put(clock);
+        w.put(TTNC);
+        w.put(T);
+        w.put(num_completions);
+        w.put(state);
+        fifo.save(w);
+        w.put(num_rejected);
+        w.put(num_arrivals);
+        w.put(_last_response_time);
+        w.put(_last_job);
+        w.put(stats);
+        w.put<uint64_t>(class_size_dists.size());
+        for (const auto& d : class_size_dists) queue_sim::saveState(w, d);
+    }
+
+    virtual void loadState(BinaryReader& r) {
+        if (r.get<int>() != num_servers || r.get<int>() != buffer_capacity) {
+            throw std::invalid_argument(
+                "snapshot server configuration does not match this system");
+        }
+        clock = r.get<double>();
+        TTNC = r.get<double>();
+        T = r.get<double>();
+        num_completions = r.get<int>();
+        state = r.get<int>();
+        fifo.load(r, *pool);
+        num_rejected = r.get<int>();
+        num_arrivals = r.get<int>();
+        _last_response_time = r.get<double>();
+        _last_job = loadJob(r, true);
+        stats = r.get<ServerStats>();
+        if (r.get<uint64_t>() != class_size_dists.size()) {
+            throw std::invalid_argument(
+                "snapshot class_size_dists do not match this system");
+        }
+        for (auto& d : class_size_dists) queue_sim::loadState(r, d);
+    }
+
+    // -- Statistics (driven by the event loop) --
+
+    // Credit the interval the server is about to be advanced over.
+    void accumulate(double dt) {
+        stats.area += state * dt;
+        stats.busy_time += std::min(state, num_servers) * dt;
+    }
+
+    // Start measuring at time t.  The server may last have been touched
+    // before t; its pending interval is pre-credited negatively, so only
+    // the part after t counts once it is next advanced.
+    void beginStats(double t) {
+        stats = ServerStats();
+        stats.num_servers = num_servers;
+        stats.max_state = state;
+        accumulate(clock - t);
+    }
+
+    // Close the books at time t, after `duration` of measurement.
+    void finishStats(double t, double duration) {
+        stats = statsAt(t, duration);
+    }
+
+    // What finishStats(t, duration) would leave in `stats`, without
+    // touching the server (for reading a run that continues).
+    ServerStats statsAt(double t, double duration) const {
+        ServerStats out = stats;
+        double dt = t - clock;
+        out.area += state * dt;
+        out.busy_time += std::min(state, num_servers) * dt;
+        out.duration = duration;
+        return out;
+    }
+
+    // Size of a job starting service: from its class's distribution if
+    // one is set, else from `own` (the policy's sizeDist).
+    template <class SizeDist>
+    double drawSize(SizeDist& own, JobId job) {
+        if (!class_size_dists.empty()) {
+            size_t c = static_cast<size_t>((*pool)[job].job_class);
+            if (c < class_size_dists.size()) {
+                return sample(class_size_dists[c], *rng);
+            }
+        }
+        return sample(own, *rng);
     }
 
     virtual double nextJob() = 0;
 
     virtual void updateET() {
-        double t = clock - arrivalTimes.front();
-        arrivalTimes.pop_front();
+        JobId job = fifo.pop();
+        double t = clock - (*pool)[job].arrival;
+        _last_job = job;
         _last_response_time = t;
         double n = static_cast<double>(num_completions);
         T = T * (n - 1.0) / n + t / n;
     }
 
-    virtual void arrival() {
-        arrivalTimes.push_back(clock);
+    virtual void arrival(JobId job) {
+        (*pool)[job].arrival = clock;
+        fifo.push(job);
         if (state == 0) {
             TTNC = nextJob();
         }
         state += 1;
     }
 
+    // Whether the state loadState() restored is one the policy can run
+    // from: `state` counts exactly the jobs its queues hold, and an idle
+    // server has no pending event.  SystemState::load rejects snapshots
+    // that fail this, which could otherwise make a later event pop an
+    // empty queue.
+    virtual bool consistent() const {
+        return validCommon() && static_cast<size_t>(state) == fifo.size();
+    }
+
+    // Check that a snapshot's next server is `name`.
+    static void expectPolicy(BinaryReader& r, const char* name) {
+        std::string got = r.getString();
+        if (got != name) {
+            throw std::invalid_argument("snapshot has a " + got +
+                                        " server where this system has " +
+                                        name);
+        }
+    }
+
+    // Heaps of (key, job) pairs, saved in pop order: the order is total
+    // (job ids are distinct), so a reloaded heap pops identically.
+    template <class Heap>
+    static void saveHeap(BinaryWriter& w, Heap heap) {
+        w.put<uint64_t>(heap.size());
+        for (; !heap.empty(); heap.pop()) {
+            w.put(heap.top().first);
+            w.put(heap.top().second);
+        }
+    }
+
+    template <class Heap>
+    void loadHeap(BinaryReader& r, Heap& heap) const {
+        while (!heap.empty()) heap.pop();
+        auto n = r.get<uint64_t>();
+        for (uint64_t i = 0; i < n; ++i) {
+            double key = r.get<double>();
+            heap.push({key, loadJob(r)});
+        }
+    }
+
+    // A JobId read from a snapshot: a slot of the pool, or NO_JOB where
+    // `none_ok`.
+    JobId loadJob(BinaryReader& r, bool none_ok = false) const {
+        JobId id = r.get<JobId>();
+        if (!(none_ok && id == NO_JOB) && !pool->contains(id))
+            BinaryReader::corrupt();
+        return id;
+    }
+
+    // consistent()'s common part: a finite clock, a non-negative count,
+    // and no pending event while idle.
+    bool validCommon() const {
+        if (!std::isfinite(clock) || std::isnan(TTNC)) return false;
+        return state > 0 ||
+               (state == 0 && TTNC == std::numeric_limits<double>::infinity());
+    }
+
+    // -- Profiling --
+
+    // Entries allocated by this server's queues (see RunProfile).
+    // Policies add their own containers.
+    virtual size_t queueCapacity() const { return fifo.capacity(); }
+
+    // Slots allocated by a priority_queue's underlying container, which
+    // the standard only exposes to derived classes.
+    template <class Heap>
+    static size_t heapCapacity(const Heap& heap) {
+        struct Access : Heap {
+            static size_t of(const Heap& h) {
+                return (h.*&Access::c).capacity();
+            }
+        };
+        return Access::of(heap);
+    }
+
     double queryTTNC() const { return TTNC; }
 
+    // Absolute time of this server's next scheduled event (+inf if idle).
+    double nextEventTime() const { return clock + TTNC; }
+
     virtual bool update(double time_elapsed) {
         TTNC -= time_elapsed;
         clock += time_elapsed;
         if (TTNC <= 0.0) {
+            // updateET() pops the finished job first, so nextJob() sees
+            // the one starting service at the head of the queue.
             state -= 1;
-            TTNC = (state > 0) ? nextJob()
-                               : std::numeric_limits<double>::infinity();
             num_completions += 1;
             updateET();
+            TTNC = (state > 0) ? nextJob()
+                               : std::numeric_limits<double>::infinity();
             return true;
         }
         return false;
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "distributions.hpp"
+#include "engine.hpp"
+#include "rng.hpp"
+#include "routing.hpp"
+#include "serialize.hpp"
+#include "server.hpp"
+#include "system_state.hpp"
+
+namespace queue_sim {
+
+// A resumable run of a single-class system: its SystemState, the random
+// stream driving it, and how far the warmup and measurement phases have
+// got.  Advancing a snapshot follows SimEngine::simLoop event for event,
+// so warmUp(w) followed by run(n) gives exactly sim(n, seed, w), and a run
+// split into several run() calls (with a save() / load() in between)
+// gives exactly the uninterrupted one.
+//
+// Copies are independent, so a warmed-up snapshot can be forked into
+// many replications (QueueSystem::replicateFrom).
+class Snapshot {
+public:
+    SystemState system;
+    Rng rng;
+    int warmup_done = 0;
+    bool measuring = false;
+    double start = 0.0;      // when measurement began
+    double area = 0.0;       // integral of jobs in system since `start`
+    int completions = 0;     // measured departures
+
+    Snapshot(const std::vector<std::shared_ptr<Server>>& servers,
+             Distribution arrivalDist, uint64_t seed, RngKind rng_kind)
+        : system(servers, std::move(arrivalDist)), rng(seed, rng_kind) {
+        system.reset(rng);
+    }
+
+    // Run the warmup phase until `warmup` jobs have left in total.
+    void warmUp(const RoutingTable& routing, int warmup,
+                const std::atomic<bool>* stop = nullptr) {
+        if (measuring) {
+            throw std::invalid_argument(
+                "cannot warm up a snapshot that is already measuring");
+        }
+        unsigned polls = 0;
+        while (warmup_done < warmup && !SimEngine::stopRequested(stop, polls)) {
+            warmup_done += system.step(routing, rng, completed).departures;
+        }
+    }
+
+    // Start measuring now: clear the accumulators and every server's
+    // counters, as simLoop does when warmup ends.
+    void beginMeasurement() {
+        measuring = true;
+        start = system.now;
+        area = 0.0;
+        completions = 0;
+        for (auto& s : system.servers) {
+            s->num_rejected = 0;
+            s->num_arrivals = 0;
+            s->beginStats(system.now);
+        }
+    }
+
+    // Measure until `num_events` departures have been measured in total
+    // (across every run() of this snapshot), beginning measurement first
+    // if needed.  Returns the cumulative (mean N, mean T).
+    std::pair<double, double> run(const RoutingTable& routing, int num_events,
+                                  const std::atomic<bool>* stop = nullptr) {
+        if (!measuring) beginMeasurement();
+        unsigned polls = 0;
+        while (completions < num_events) {
+            if (SimEngine::stopRequested(stop, polls)) break;
+            double t_next = system.nextTime();
+            area += static_cast<double>(system.state) * (t_next - system.now);
+            completions += system.step(routing, rng, completed).departures;
+        }
+        return result();
+    }
+
+    std::pair<double, double> result() const {
+        double clock = system.now - start;
+        return {area / clock, area / std::max(1, completions)};
+    }
+
+    // Per-server statistics as of now, without disturbing the run.
+    std::vector<ServerStats> serverStats() const {
+        std::vector<ServerStats> out;
+        out.reserve(system.servers.size());
+        double clock = system.now - start;
+        for (const auto& s : system.servers) {
+            out.push_back(s->statsAt(system.now, clock));
+        }
+        return out;
+    }
+
+    // -- Serialization --
+
+    static constexpr char MAGIC[8] = {'Q', 'S', 'I', 'M', 'S', 'N', 'A', 'P'};
+    static constexpr uint32_t VERSION = 1;
+    static constexpr uint32_t ENDIAN_MARK = 0x01020304;
+
+    std::string save() const {
+        BinaryWriter w;
+        for (char c : MAGIC) w.put(c);
+        w.put(VERSION);
+        w.put(ENDIAN_MARK);
+        rng.save(w);
+        w.put(warmup_done);
+        w.put(measuring);
+        w.put(start);
+        w.put(area);
+        w.put(completions);
+        system.save(w);
+        return w.release();
+    }
+
+    // Replace this snapshot's state with a saved one.  The snapshot must
+    // have been built for the same system (servers, policies and
+    // distribution families); mismatches throw std::invalid_argument.
+    void load(const std::string& bytes) {
+        BinaryReader r(bytes);
+        char magic[sizeof(MAGIC)];
+        for (char& c : magic) c = r.get<char>();
+        if (std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0) {
+            throw std::invalid_argument("not a queue_sim snapshot");
+        }
+        if (r.get<uint32_t>() != VERSION || r.get<uint32_t>() != ENDIAN_MARK) {
+            throw std::invalid_argument(
+                "snapshot was written by an incompatible version or platform");
+        }
+        rng.load(r);
+        warmup_done = r.get<int>();
+        measuring = r.get<bool>();
+        start = r.get<double>();
+        area = r.get<double>();
+        completions = r.get<int>();
+        system.load(r);
+        if (!r.done()) BinaryReader::corrupt();
+    }
+
+private:
+    std::vector<Completion> completed;
+};
+
+}  // namespace queue_sim
@@ -0,0 +1,174 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "distributions.hpp"
+#include "engine.hpp"
+#include "rng.hpp"
+#include "routing.hpp"
+#include "server.hpp"
+#include "stats.hpp"
+#include "system_state.hpp"
+
+namespace queue_sim {
+
+// Rare-event estimation of the steady-state loss probability (jobs
+// rejected by full buffers per external arrival) by fixed-effort
+// multilevel splitting on the total number of jobs in the system.
+//
+// The system regenerates whenever an arrival finds it empty, so
+//
+//   P(loss) = E[losses per cycle] / E[arrivals per cycle].
+//
+// Stage 0 simulates `n_cycles` whole cycles directly, giving the
+// denominator, the losses seen before the first level L_1 is reached and
+// the fraction p_1 of cycles that reach it; the states at those moments
+// are kept (a uniform sample of at most `effort` of them).  Stage i then
+// restarts `effort` trajectories from the level-L_i states, each running
+// until the system reaches L_{i+1} or empties, which gives p_{i+1}, the
+// losses c_i on the way and the next set of starting states; the last
+// stage runs to the end of the cycle.  Then
+//
+//   E[losses per cycle] = c_0 + p_1 (c_1 + p_2 (c_2 + ... + p_m c_m)).
+//
+// Each factor is estimated from an ordinary number of trajectories, so a
+// probability of 1e-9 costs about as much as one of 1e-3 would crude.
+struct SplittingRule {
+    // Strictly increasing thresholds on jobs in the system; empty means
+    // every integer from 2 to the total buffer capacity.
+    std::vector<int> levels;
+    int n_cycles = 10000;  // stage-0 regenerative cycles
+    int effort = 1000;     // trajectories per later stage
+
+    void validate() const {
+        if (n_cycles < 1) {
+            throw std::invalid_argument(
+                "n_cycles must be >= 1, got " + std::to_string(n_cycles));
+        }
+        if (effort < 1) {
+            throw std::invalid_argument(
+                "effort must be >= 1, got " + std::to_string(effort));
+        }
+        for (size_t i = 0; i < levels.size(); ++i) {
+            if (levels[i] < 1 || (i > 0 && levels[i] <= levels[i - 1])) {
+                throw std::invalid_argument(
+                    "levels must be strictly increasing and >= 1");
+            }
+        }
+    }
+};
+
+struct SplittingResult {
+    double loss_probability = std::numeric_limits<double>::quiet_NaN();
+    // CI half-width over the independent runs (NaN for fewer than two).
+    double half_width = std::numeric_limits<double>::quiet_NaN();
+    std::vector<double> raw;  // per-run estimates
+    std::vector<int> levels;
+    // Mean over runs of p_i, the chance of reaching levels[i] from
+    // levels[i - 1] (from the start of a cycle for i = 0).
+    std::vector<double> level_probabilities;
+    double arrivals_per_cycle = 0.0;
+    int64_t events = 0;  // simulated over all runs
+    double confidence = 0.95;
+    bool cancelled = false;
+};
+
+struct Splitting {
+    // One independent splitting estimate.  `p` and `arrivals` receive the
+    // run's level probabilities and arrivals per cycle.
+    static double run(const SystemState& empty, const RoutingTable& routing,
+                      const SplittingRule& rule, const std::vector<int>& levels,
+                      uint64_t seed, RngKind rng_kind,
+                      std::vector<double>& p, double& arrivals,
+                      int64_t& events, const std::atomic<bool>* stop) {
+        Rng rng(seed, rng_kind);
+        std::vector<Completion> completed;
+        unsigned polls = 0;
+        int m = static_cast<int>(levels.size());
+        p.assign(m, 0.0);
+
+        // Uniform sample of at most `effort` states offered at one level.
+        struct Reservoir {
+            std::vector<SystemState> states;
+            int64_t seen = 0;
+            void offer(const SystemState& s, int cap, Rng& rng) {
+                seen += 1;
+                if (static_cast<int>(states.size()) < cap) {
+                    states.push_back(s);
+                    return;
+                }
+                auto j = static_cast<int64_t>(rng.uniform() * seen);
+                if (j < cap) states[j] = s;
+            }
+        };
+
+        // -- stage 0: whole cycles from an empty system ----------------------
+        SystemState sys = empty;
+        sys.reset(rng);
+        Reservoir hits;
+        int64_t n_arrivals = 0;
+        double losses = 0.0;
+        // Without levels stage 0 is the last stage: it counts every loss.
+        bool reached = false;
+        int cycles = 0;
+        while (cycles < rule.n_cycles) {
+            if (SimEngine::stopRequested(stop, polls)) return 0.0;
+            int before = sys.state;
+            auto out = sys.step(routing, rng, completed);
+            events += 1;
+            n_arrivals += out.arrival;
+            if (!reached || m == 0) {
+                losses += out.losses;
+                if (m > 0 && sys.state >= levels[0]) {
+                    reached = true;
+                    hits.offer(sys, rule.effort, rng);
+                }
+            }
+            if (before > 0 && sys.state == 0) {
+                cycles += 1;
+                reached = false;
+            }
+        }
+        arrivals = static_cast<double>(n_arrivals) / rule.n_cycles;
+        std::vector<double> c(m + 1, 0.0);
+        c[0] = losses / rule.n_cycles;
+        if (m > 0) p[0] = static_cast<double>(hits.seen) / rule.n_cycles;
+
+        // -- stages 1..m: restart from the states at each level --------------
+        for (int i = 1; i <= m && !hits.states.empty(); ++i) {
+            bool last = i == m;
+            Reservoir next;
+            losses = 0.0;
+            for (int j = 0; j < rule.effort; ++j) {
+                sys = hits.states[j % hits.states.size()];
+                while (true) {
+                    if (SimEngine::stopRequested(stop, polls)) return 0.0;
+                    auto out = sys.step(routing, rng, completed);
+                    events += 1;
+                    losses += out.losses;
+                    if (sys.state == 0) break;
+                    if (!last && sys.state >= levels[i]) {
+                        next.offer(sys, rule.effort, rng);
+                        break;
+                    }
+                }
+            }
+            c[i] = losses / rule.effort;
+            if (!last) p[i] = static_cast<double>(next.seen) / rule.effort;
+            hits = std::move(next);
+        }
+
+        double tail = 0.0;
+        for (int i = m; i >= 1; --i) tail = p[i - 1] * (c[i] + tail);
+        return (c[0] + tail) / arrivals;
+    }
+};
+
+}  // namespace queue_sim
@@ -3,62 +3,134 @@
 #include <algorithm>
 #include <functional>
 #include <limits>
+#include <memory>
 #include <queue>
+#include <string>
+#include <tuple>
 #include <utility>
+#include <variant>
 #include <vector>
 
 #include "server.hpp"
 
 namespace queue_sim {
 
-class SRPT : public Server {
+template <class SizeDist>
+class BasicSRPT final : public Server {
 public:
-    // min-heap: (remaining, arrival_time) — sorted by remaining first
-    using Job = std::pair<double, double>;
-    std::priority_queue<Job, std::vector<Job>, std::greater<Job>> jobs;
-    double _running_arrival_time = 0.0;
+    SizeDist sizeDist;
 
-    explicit SRPT(Distribution sizeDist, int buffer_capacity = -1)
-        : Server(std::move(sizeDist), 1, buffer_capacity) {}
+    // min-heap of preempted/waiting jobs, ordered by remaining size, then
+    // by arrival here (equal sizes are served first-come first-served),
+    // then by id.
+    struct Entry {
+        double remaining;
+        double arrival;
+        JobId job;
+
+        bool operator>(const Entry& o) const {
+            return std::tie(remaining, arrival, job) >
+                   std::tie(o.remaining, o.arrival, o.job);
+        }
+    };
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> jobs;
+    JobId _running_job = NO_JOB;
+
+    explicit BasicSRPT(SizeDist sizeDist, int buffer_capacity = -1)
+        : Server(1, buffer_capacity), sizeDist(std::move(sizeDist)) {}
 
     std::shared_ptr<Server> clone() const override {
-        return std::make_shared<SRPT>(sizeDist, buffer_capacity);
+        auto copy = std::make_shared<BasicSRPT>(sizeDist, buffer_capacity);
+        copy->class_size_dists = class_size_dists;
+        return copy;
+    }
+
+    std::shared_ptr<Server> cloneState() const override {
+        return std::make_shared<BasicSRPT>(*this);
+    }
+
+    void saveState(BinaryWriter& w) const override {
+        w.put(std::string("SRPT"));
+        Server::saveState(w);
+        queue_sim::saveState(w, sizeDist);
+        w.put<uint64_t>(jobs.size());
+        for (auto heap = jobs; !heap.empty(); heap.pop()) {
+            w.put(heap.top().remaining);
+            w.put(heap.top().arrival);
+            w.put(heap.top().job);
+        }
+        w.put(_running_job);
+    }
+
+    void loadState(BinaryReader& r) override {
+        expectPolicy(r, "SRPT");
+        Server::loadState(r);
+        queue_sim::loadState(r, sizeDist);
+        while (!jobs.empty()) jobs.pop();
+        auto n = r.get<uint64_t>();
+        for (uint64_t i = 0; i < n; ++i) {
+            Entry e;
+            e.remaining = r.get<double>();
+            e.arrival = r.get<double>();
+            e.job = loadJob(r);
+            jobs.push(e);
+        }
+        _running_job = loadJob(r, true);
+    }
+
+    // The job in service plus the waiting ones.
+    bool consistent() const override {
+        if (!validCommon() || !fifo.empty()) return false;
+        if (state == 0) return jobs.empty();
+        return _running_job != NO_JOB &&
+               jobs.size() == static_cast<size_t>(state) - 1;
+    }
+
+    size_t queueCapacity() const override {
+        return Server::queueCapacity() + heapCapacity(jobs);
+    }
+
+    // Same configuration with the size distribution resolved to `D`.
+    template <class D>
+    BasicSRPT<D> specialize() const {
+        return BasicSRPT<D>(std::get<D>(sizeDist), buffer_capacity);
     }
 
     void reset() override {
         Server::reset();
-        jobs = {};
-        _running_arrival_time = 0.0;
+        rewind(sizeDist);
+        // Keep the heap's storage for the next run.
+        while (!jobs.empty()) jobs.pop();
+        _running_job = NO_JOB;
     }
 
     double nextJob() override {
-        auto [remaining, arr] = jobs.top();
+        Entry next = jobs.top();
         jobs.pop();
-        _running_arrival_time = arr;
-        return remaining;
+        _running_job = next.job;
+        return next.remaining;
     }
 
     void updateET() override {
-        double t = clock - _running_arrival_time;
+        double t = clock - (*pool)[_running_job].arrival;
+        _last_job = _running_job;
         _last_response_time = t;
         double n = static_cast<double>(num_completions);
         T = T * (n - 1.0) / n + t / n;
     }
 
-    void arrival() override {
+    void arrival(JobId job) override {
+        (*pool)[job].arrival = clock;
         if (state > 0) {
-            jobs.push({TTNC, _running_arrival_time});
+            jobs.push({TTNC, (*pool)[_running_job].arrival, _running_job});
         }
-        jobs.push({sample(sizeDist, *rng), clock});
-        auto [remaining, arr] = jobs.top();
-        jobs.pop();
-        TTNC = remaining;
-        _running_arrival_time = arr;
+        jobs.push({drawSize(sizeDist, job), clock, job});
+        TTNC = nextJob();
         state += 1;
     }
 
     // Critical: updateET() BEFORE nextJob() so we read the
-    // completing job's arrival time, not the next job's.
+    // completing job, not the next one.
     bool update(double time_elapsed) override {
         TTNC -= time_elapsed;
         clock += time_elapsed;
@@ -74,4 +146,6 @@ public:
     }
 };
 
+using SRPT = BasicSRPT<Distribution>;
+
 }  // namespace queue_sim
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace queue_sim {
+
+// Return t such that P(T <= t) = p for Student's t with df degrees of
+// freedom.  Same Hill (1970) approximation as results._t_inv_cdf, so the
+// two backends agree on every confidence interval; accurate to ~1e-5.
+inline double tInvCdf(double p, int df) {
+    if (!(p > 0.0 && p < 1.0)) {
+        throw std::invalid_argument("p must be in (0, 1), got " +
+                                    std::to_string(p));
+    }
+    if (df < 1) {
+        throw std::invalid_argument("df must be >= 1, got " +
+                                    std::to_string(df));
+    }
+
+    // Use symmetry so we only need the upper tail
+    if (p < 0.5) return -tInvCdf(1.0 - p, df);
+
+    // Normal quantile via Abramowitz & Stegun 26.2.23 (rational approx)
+    double a = std::sqrt(-2.0 * std::log(1.0 - p));
+    double zp = a - (2.515517 + 0.802853 * a + 0.010328 * a * a) /
+                        (1.0 + 1.432788 * a + 0.189269 * a * a +
+                         0.001308 * a * a * a);
+
+    // Hill's correction from normal to t
+    double z2 = zp * zp;
+    double z3 = z2 * zp, z5 = z3 * z2, z7 = z5 * z2, z9 = z7 * z2;
+    double g1 = (z3 + zp) / 4.0;
+    double g2 = (5 * z5 + 16 * z3 + 3 * zp) / 96.0;
+    double g3 = (3 * z7 + 19 * z5 + 17 * z3 - 15 * zp) / 384.0;
+    double g4 = (79 * z9 + 776 * z7 + 1482 * z5 - 1920 * z3 - 945 * zp) /
+                92160.0;
+
+    double d = static_cast<double>(df);
+    return zp + g1 / d + g2 / (d * d) + g3 / (d * d * d) +
+           g4 / (d * d * d * d);
+}
+
+inline double sampleMean(const std::vector<double>& values) {
+    double sum = 0.0;
+    for (double x : values) sum += x;
+    return sum / static_cast<double>(values.size());
+}
+
+// Half-width of a `confidence`-level t interval for the mean of
+// `values` (results._ci_half_width).
+inline double ciHalfWidth(const std::vector<double>& values,
+                          double confidence) {
+    size_t n = values.size();
+    if (n < 2) throw std::invalid_argument("Need at least 2 values for a CI");
+    double x_bar = sampleMean(values);
+    double s2 = 0.0;
+    for (double x : values) s2 += (x - x_bar) * (x - x_bar);
+    s2 /= static_cast<double>(n - 1);
+    double alpha = 1.0 - confidence;
+    double t_crit = tInvCdf(1.0 - alpha / 2.0, static_cast<int>(n) - 1);
+    return t_crit * std::sqrt(s2) / std::sqrt(static_cast<double>(n));
+}
+
+}  // namespace queue_sim
@@ -0,0 +1,230 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "distributions.hpp"
+#include "engine.hpp"
+#include "event_calendar.hpp"
+#include "job_pool.hpp"
+#include "rng.hpp"
+#include "routing.hpp"
+#include "serialize.hpp"
+#include "server.hpp"
+
+namespace queue_sim {
+
+// Complete dynamic state of a running single-class system — servers with
+// their queues and clocks, job records, the event calendar and the pending
+// external arrival — as one value.  Copies are deep and independent, so a
+// run can be forked at any event and each copy resumed on its own; the
+// random stream is not part of the state and is passed to step().
+class SystemState {
+public:
+    std::vector<std::shared_ptr<Server>> servers;
+    Distribution arrivalDist;
+    JobPool jobs;
+    EventCalendar calendar;
+    double now = 0.0;
+    double next_arrival = 0.0;
+    int state = 0;  // jobs in the system
+
+    // What one step() did, for callers tracking levels or cycles.
+    struct Step {
+        bool arrival = false;  // an external arrival (admitted or not)
+        int losses = 0;        // jobs rejected by a full buffer
+        int departures = 0;    // jobs that left the system, incl. rejected
+                               // while being routed
+    };
+
+    // An empty system built from fresh copies of `servers`' configuration.
+    SystemState(const std::vector<std::shared_ptr<Server>>& servers,
+                Distribution arrivalDist)
+        : arrivalDist(std::move(arrivalDist)) {
+        this->servers.reserve(servers.size());
+        for (const auto& s : servers) this->servers.push_back(s->clone());
+        bind();
+    }
+
+    SystemState(const SystemState& other)
+        : arrivalDist(other.arrivalDist),
+          jobs(other.jobs),
+          calendar(other.calendar),
+          now(other.now),
+          next_arrival(other.next_arrival),
+          state(other.state) {
+        copyServers(other);
+    }
+
+    SystemState& operator=(const SystemState& other) {
+        if (this == &other) return *this;
+        arrivalDist = other.arrivalDist;
+        jobs = other.jobs;
+        calendar = other.calendar;
+        now = other.now;
+        next_arrival = other.next_arrival;
+        state = other.state;
+        copyServers(other);
+        return *this;
+    }
+
+    // Moving relocates `jobs`, so the servers are re-pointed at it.
+    SystemState(SystemState&& other) noexcept
+        : servers(std::move(other.servers)),
+          arrivalDist(std::move(other.arrivalDist)),
+          jobs(std::move(other.jobs)),
+          calendar(std::move(other.calendar)),
+          now(other.now),
+          next_arrival(other.next_arrival),
+          state(other.state) {
+        bind();
+    }
+
+    SystemState& operator=(SystemState&& other) noexcept {
+        servers = std::move(other.servers);
+        arrivalDist = std::move(other.arrivalDist);
+        jobs = std::move(other.jobs);
+        calendar = std::move(other.calendar);
+        now = other.now;
+        next_arrival = other.next_arrival;
+        state = other.state;
+        bind();
+        return *this;
+    }
+
+    // Empty the system at time 0 and draw the first arrival from `rng`.
+    void reset(Rng& rng) {
+        int n = static_cast<int>(servers.size());
+        calendar.reset(n);
+        jobs.reset();
+        useRng(rng);
+        for (auto& s : servers) s->reset();
+        rewind(arrivalDist);
+        now = 0.0;
+        state = 0;
+        next_arrival = sample(arrivalDist, rng);
+    }
+
+    // Time of the next event.
+    double nextTime() const {
+        return std::min(calendar.topTime(), next_arrival);
+    }
+
+    // Process the next event (the earliest server event or the next
+    // external arrival, which enters server 0) and route everything it
+    // finished, exactly as the measurement loop of SimEngine::simLoop
+    // does.  `completed` is caller-owned scratch.
+    Step step(const RoutingTable& routing, Rng& rng,
+              std::vector<Completion>& completed) {
+        useRng(rng);
+        int n_servers = static_cast<int>(srvs.size());
+        Step out;
+
+        completed.clear();
+        if (calendar.topTime() <= next_arrival) {
+            now = calendar.topTime();
+            SimEngine::fireNext(srvs, calendar, completed);
+        } else {
+            now = next_arrival;
+            out.arrival = true;
+            if (SimEngine::admit(srvs, calendar, 0, now, jobs.acquire(now),
+                                 completed)) {
+                state += 1;
+            } else {
+                out.losses += 1;
+            }
+            next_arrival = now + sample(arrivalDist, rng);
+        }
+
+        for (size_t c = 0; c < completed.size(); ++c) {
+            auto [idx, job] = completed[c];
+            int dest = routing.route(idx, rng);
+            ServerStats& st = srvs[idx]->stats;
+            st.completions += 1;
+            st.response_sum += srvs[idx]->_last_response_time;
+            if (dest >= n_servers) {
+                state -= 1;
+                out.departures += 1;
+                jobs.release(job);
+            } else if (!SimEngine::admit(srvs, calendar, dest, now, job,
+                                         completed)) {
+                state -= 1;
+                out.departures += 1;
+                out.losses += 1;
+            }
+        }
+        return out;
+    }
+
+    // -- Snapshots --
+
+    // Everything above except the configuration, which load() expects to
+    // find already in place (a state built from the same servers).  The
+    // calendar is rebuilt from the servers' next event times.
+    void save(BinaryWriter& w) const {
+        w.put<uint64_t>(servers.size());
+        jobs.save(w);
+        w.put(now);
+        w.put(next_arrival);
+        w.put(state);
+        queue_sim::saveState(w, arrivalDist);
+        for (const auto& s : servers) s->saveState(w);
+    }
+
+    void load(BinaryReader& r) {
+        if (r.get<uint64_t>() != servers.size()) {
+            throw std::invalid_argument(
+                "snapshot has a different number of servers");
+        }
+        jobs.load(r);
+        now = r.get<double>();
+        next_arrival = r.get<double>();
+        state = r.get<int>();
+        if (!std::isfinite(now) || std::isnan(next_arrival))
+            BinaryReader::corrupt();
+        queue_sim::loadState(r, arrivalDist);
+        calendar.reset(static_cast<int>(servers.size()));
+        // Every job in the pool is at exactly one server.
+        size_t held = 0;
+        for (size_t i = 0; i < servers.size(); ++i) {
+            servers[i]->loadState(r);
+            if (!servers[i]->consistent()) BinaryReader::corrupt();
+            held += static_cast<size_t>(servers[i]->state);
+            calendar.update(static_cast<int>(i), servers[i]->nextEventTime());
+        }
+        if (state < 0 || static_cast<size_t>(state) != jobs.size() ||
+            held != jobs.size())
+            BinaryReader::corrupt();
+    }
+
+private:
+    void copyServers(const SystemState& other) {
+        servers.clear();
+        servers.reserve(other.servers.size());
+        for (const auto& s : other.servers) servers.push_back(s->cloneState());
+        bind();
+    }
+
+    // Point the servers at this state's own job records.
+    void bind() {
+        srvs = SimEngine::handles(servers);
+        for (Server* s : srvs) s->setJobPool(&jobs);
+        boundRng = nullptr;
+    }
+
+    void useRng(Rng& rng) {
+        if (boundRng == &rng) return;
+        for (Server* s : srvs) s->setRNG(&rng);
+        boundRng = &rng;
+    }
+
+    std::vector<Server*> srvs;  // raw handles for the SimEngine helpers
+    Rng* boundRng = nullptr;
+};
+
+}  // namespace queue_sim
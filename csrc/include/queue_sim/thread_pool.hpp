@@ -0,0 +1,105 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace queue_sim {
+
+// Process-wide pool of worker threads, created on first use and reused
+// by every replicate() call so short runs don't pay for thread start-up.
+// The pool only grows: submitting more work than there are idle workers
+// spawns the difference.
+//
+// Tasks must not block waiting on other pool tasks.  The task queue is
+// FIFO and a waiting task would hold a worker, so callers coordinate from
+// their own thread.
+class ThreadPool {
+public:
+    static ThreadPool& instance() {
+        // Leaked on purpose: joining workers during static destruction of
+        // an extension module can deadlock (e.g. under the Windows loader
+        // lock), and idle workers hold no resources worth releasing.
+        static ThreadPool* pool = new ThreadPool();
+        return *pool;
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lk(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& t : workers) t.join();
+    }
+
+    // Number of threads to use for `n_tasks` tasks when the caller asked
+    // for `requested` (<= 0 means one per hardware thread).
+    static int resolveThreads(int requested, int n_tasks) {
+        int n = requested;
+        if (n <= 0) {
+            n = static_cast<int>(std::thread::hardware_concurrency());
+            if (n <= 0) n = 1;
+        }
+        return std::max(1, std::min(n, n_tasks));
+    }
+
+    // Queue `copies` invocations of `task`.  Workers are spawned until
+    // every queued task has an idle thread, so the copies run concurrently
+    // rather than behind another caller's work.
+    void submit(int copies, const std::function<void()>& task) {
+        {
+            std::lock_guard<std::mutex> lk(mutex);
+            for (int i = 0; i < copies; ++i) tasks.push_back(task);
+            while (idle < static_cast<int>(tasks.size())) {
+                workers.emplace_back([this] { workerLoop(); });
+                ++idle;
+            }
+        }
+        if (copies == 1) {
+            wake.notify_one();
+        } else {
+            wake.notify_all();
+        }
+    }
+
+    int size() {
+        std::lock_guard<std::mutex> lk(mutex);
+        return static_cast<int>(workers.size());
+    }
+
+private:
+    ThreadPool() = default;
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<std::function<void()>> tasks;
+    std::vector<std::thread> workers;
+    int idle = 0;  // workers not currently running a task
+    bool stopping = false;
+
+    void workerLoop() {
+        std::unique_lock<std::mutex> lk(mutex);
+        while (true) {
+            wake.wait(lk, [this] { return stopping || !tasks.empty(); });
+            if (tasks.empty()) return;  // stopping
+            std::function<void()> task = std::move(tasks.front());
+            tasks.pop_front();
+            --idle;
+            lk.unlock();
+            task();
+            lk.lock();
+            ++idle;
+        }
+    }
+};
+
+}  // namespace queue_sim
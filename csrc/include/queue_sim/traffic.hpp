@@ -0,0 +1,174 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "distributions.hpp"
+#include "event_calendar.hpp"
+#include "rng.hpp"
+#include "routing.hpp"
+
+namespace queue_sim {
+
+// External traffic drives the event loop through a small interface:
+//
+//   start(rng)                 draw the first arrival time(s)
+//   nextTime(), nextClass()    time and class of the next external arrival
+//   entry(c)                   server a class-c job enters at
+//   redraw(c, now, rng)        schedule the next class-c arrival
+//   route(c, from, rng)        next hop of a class-c job leaving `from`
+//   arrive / leave / reject    per-class bookkeeping (see MultiClassTraffic)
+//   begin(now), finish(now, duration)
+//                              bracket the measurement phase
+//   classStats()               per-class results, or nullptr
+//
+// SingleClassTraffic is the classic system (one stream into server 0,
+// one routing table) and compiles down to the original scalar loop;
+// MultiClassTraffic adds per-class streams, routes and accounting.
+
+// One traffic class of a multi-class system: its own external arrival
+// process, entry server and routing.  Per-class job sizes are set on the
+// servers (Server::class_size_dists).
+struct TrafficClass {
+    Distribution arrivalDist;
+    int entry_server = 0;
+    // Empty: use the system's transitionMatrix.
+    std::vector<std::vector<double>> transitionMatrix;
+};
+
+// Measurement-phase results for one traffic class.  `area` integrates
+// the number of class jobs in the system, so mean_N / mean_T use the
+// same estimators as the system-wide results and sum to them.
+struct ClassStats {
+    double area = 0.0;
+    double duration = 0.0;
+    int64_t arrivals = 0;     // external arrivals admitted
+    int64_t completions = 0;  // jobs that left (including routed rejections)
+    int64_t rejections = 0;   // external and routed rejections
+    int state = 0;            // class jobs in the system
+    double last = 0.0;        // time `area` was last brought up to date
+
+    double meanN() const { return duration > 0.0 ? area / duration : 0.0; }
+    double meanT() const {
+        return area / static_cast<double>(completions > 0 ? completions : 1);
+    }
+
+    void change(double now, int delta) {
+        area += state * (now - last);
+        last = now;
+        state += delta;
+    }
+};
+
+template <class ArrivalDist>
+struct SingleClassTraffic {
+    ArrivalDist arrivalDist;
+    const RoutingTable& routing;
+    double next = std::numeric_limits<double>::infinity();
+
+    SingleClassTraffic(ArrivalDist arrivalDist, const RoutingTable& routing)
+        : arrivalDist(std::move(arrivalDist)), routing(routing) {}
+
+    void start(Rng& rng) {
+        rewind(arrivalDist);
+        next = sample(arrivalDist, rng);
+    }
+    double nextTime() const { return next; }
+    int nextClass() const { return 0; }
+    int entry(int) const { return 0; }
+    void redraw(int, double now, Rng& rng) {
+        next = now + sample(arrivalDist, rng);
+    }
+    int route(int, int from, Rng& rng) const {
+        return routing.route(from, rng);
+    }
+
+    void arrive(int, double) {}
+    void leave(int, double) {}
+    void reject(int) {}
+    void begin(double) {}
+    void finish(double, double) {}
+    const std::vector<ClassStats>* classStats() const { return nullptr; }
+};
+
+// Several external arrival streams, merged in a small calendar of their
+// next arrival times, each routed by its own table.  Class counts change
+// only when a class job enters or leaves, so `area` is updated lazily at
+// those moments rather than on every event.
+class MultiClassTraffic {
+public:
+    // `routings[c]` must outlive the traffic object.
+    MultiClassTraffic(const std::vector<TrafficClass>& classes,
+                      const std::vector<RoutingTable>& routings)
+        : routings(&routings) {
+        arrivalDists.reserve(classes.size());
+        entries.reserve(classes.size());
+        for (const auto& c : classes) {
+            arrivalDists.push_back(c.arrivalDist);
+            entries.push_back(c.entry_server);
+        }
+    }
+
+    int size() const { return static_cast<int>(arrivalDists.size()); }
+
+    void start(Rng& rng) {
+        int n = size();
+        calendar.reset(n);
+        stats.assign(n, ClassStats());
+        for (int c = 0; c < n; ++c) {
+            rewind(arrivalDists[c]);
+            calendar.update(c, sample(arrivalDists[c], rng));
+        }
+    }
+
+    double nextTime() const { return calendar.topTime(); }
+    int nextClass() const { return calendar.top(); }
+    int entry(int c) const { return entries[c]; }
+    void redraw(int c, double now, Rng& rng) {
+        calendar.update(c, now + sample(arrivalDists[c], rng));
+    }
+    int route(int c, int from, Rng& rng) const {
+        return (*routings)[c].route(from, rng);
+    }
+
+    void arrive(int c, double now) {
+        stats[c].change(now, +1);
+        stats[c].arrivals += 1;
+    }
+    void leave(int c, double now) {
+        stats[c].change(now, -1);
+        stats[c].completions += 1;
+    }
+    void reject(int c) { stats[c].rejections += 1; }
+
+    // Keep the class counts (jobs present carry over from warmup) but
+    // restart every accumulator at `now`.
+    void begin(double now) {
+        for (auto& s : stats) {
+            int present = s.state;
+            s = ClassStats();
+            s.state = present;
+            s.last = now;
+        }
+    }
+
+    void finish(double now, double duration) {
+        for (auto& s : stats) {
+            s.change(now, 0);
+            s.duration = duration;
+        }
+    }
+
+    const std::vector<ClassStats>* classStats() const { return &stats; }
+
+private:
+    std::vector<Distribution> arrivalDists;
+    std::vector<int> entries;
+    const std::vector<RoutingTable>* routings;
+    EventCalendar calendar;
+    std::vector<ClassStats> stats;
+};
+
+}  // namespace queue_sim
@@ -1,21 +1,132 @@
+#include <pybind11/numpy.h>
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 
+#include <optional>
+
+#include "queue_sim/batch_means.hpp"
 #include "queue_sim/distributions.hpp"
 #include "queue_sim/event_log.hpp"
 #include "queue_sim/fcfs.hpp"
+#include "queue_sim/profile.hpp"
+#include "queue_sim/quantile_sketch.hpp"
 #include "queue_sim/queue_system.hpp"
+#include "queue_sim/response_times.hpp"
+#include "queue_sim/rng.hpp"
 #include "queue_sim/server.hpp"
+#include "queue_sim/snapshot.hpp"
+#include "queue_sim/splitting.hpp"
+#include "queue_sim/stats.hpp"
 #include "queue_sim/srpt.hpp"
+#include "queue_sim/traffic.hpp"
 #include "queue_sim/ps.hpp"
 #include "queue_sim/fb.hpp"
 
 namespace py = pybind11;
 using namespace queue_sim;
 
+namespace {
+
+// Read-only NumPy view of a C++-owned vector.  `owner` (the Python object
+// holding the storage) becomes the array's base, so the memory outlives
+// every view of it.
+template <class T>
+py::array_t<T> column(const std::vector<T>& v, py::handle owner) {
+    py::array_t<T> arr({static_cast<py::ssize_t>(v.size())},
+                       {static_cast<py::ssize_t>(sizeof(T))},
+                       v.data(), owner);
+    arr.attr("flags").attr("writeable") = false;
+    return arr;
+}
+
+// Read-only NumPy view of recorded response times.  The capsule base holds
+// a reference to the storage, so the array stays valid after the system
+// runs again or is destroyed.
+py::array_t<double> responseTimesArray(const ResponseTimes& rt) {
+    auto* keep = new std::shared_ptr<void>(rt.owner);
+    py::capsule base(keep, [](void* p) {
+        delete static_cast<std::shared_ptr<void>*>(p);
+    });
+    py::array_t<double> arr({static_cast<py::ssize_t>(rt.size)},
+                            {static_cast<py::ssize_t>(sizeof(double))},
+                            rt.data, base);
+    arr.attr("flags").attr("writeable") = false;
+    return arr;
+}
+
+// Read-only NumPy view of the visit counts recorded with response times,
+// or None when they were not tracked.
+py::object visitCountsArray(const ResponseTimes& rt) {
+    if (!rt.visits) return py::none();
+    auto* keep = new std::shared_ptr<int32_t[]>(rt.visits);
+    py::capsule base(keep, [](void* p) {
+        delete static_cast<std::shared_ptr<int32_t[]>*>(p);
+    });
+    py::array_t<int32_t> arr({static_cast<py::ssize_t>(rt.size)},
+                             {static_cast<py::ssize_t>(sizeof(int32_t))},
+                             rt.visits.get(), base);
+    arr.attr("flags").attr("writeable") = false;
+    return arr;
+}
+
+// A Python distribution object as the C++ variant, and back.  Every
+// constructor taking a distribution goes through here; the candidates are
+// the variant's alternatives, so a new family needs no code here.
+template <size_t I = 0>
+Distribution toDistribution(const py::object& dist) {
+    if constexpr (I == std::variant_size_v<Distribution>) {
+        throw py::type_error(
+            "Expected a queue_sim distribution (ExponentialDist, "
+            "ErlangDist, ...), got " +
+            py::str(py::type::of(dist).attr("__name__")).cast<std::string>());
+    } else {
+        using D = std::variant_alternative_t<I, Distribution>;
+        if (py::isinstance<D>(dist)) return dist.cast<D>();
+        return toDistribution<I + 1>(dist);
+    }
+}
+
+py::object fromDistribution(const Distribution& dist) {
+    return std::visit([](const auto& d) { return py::cast(d); }, dist);
+}
+
+// Wrap a caller's NumPy array as a response-time sink, filled in place.
+// The array must be a writable, C-contiguous float64 vector; the sink
+// holds a reference to it, released under the GIL.
+ResponseTimes responseTimesBuffer(const py::object& obj) {
+    if (!py::isinstance<py::array>(obj))
+        throw py::type_error("response_times_out must be a numpy.ndarray");
+    auto arr = py::reinterpret_borrow<py::array>(obj);
+    if (!arr.dtype().is(py::dtype::of<double>()))
+        throw py::value_error("response_times_out must have dtype float64");
+    if (arr.ndim() != 1 ||
+        !(arr.flags() & py::array::c_style))
+        throw py::value_error(
+            "response_times_out must be a 1-D C-contiguous array");
+    if (!arr.writeable())
+        throw py::value_error("response_times_out must be writable");
+    auto* ref = new py::object(arr);
+    std::shared_ptr<void> owner(ref, [](void* p) {
+        py::gil_scoped_acquire gil;
+        delete static_cast<py::object*>(p);
+    });
+    return ResponseTimes::wrap(static_cast<double*>(arr.mutable_data()),
+                               static_cast<size_t>(arr.size()),
+                               std::move(owner));
+}
+
+}  // namespace
+
 PYBIND11_MODULE(_queue_sim_cpp, m) {
     m.doc() = "C++ backend for queue_sim — hot-path event loop";
 
+    // -- Random number generators --------------------------------------------
+
+    py::enum_<RngKind>(m, "RngKind")
+        .value("MT19937_64", RngKind::MT19937_64)
+        .value("XOSHIRO256PP", RngKind::XOSHIRO256PP)
+        .value("PCG64", RngKind::PCG64);
+
     // -- Distributions -------------------------------------------------------
 
     py::class_<ExponentialDist>(m, "ExponentialDist")
@@ -28,8 +139,103 @@ PYBIND11_MODULE(_queue_sim_cpp, m) {
         .def(py::init<double, double, double>(),
              py::arg("k"), py::arg("p"), py::arg("alpha"));
 
+    py::class_<HyperExponentialDist>(m, "HyperExponentialDist")
+        .def(py::init<double, double, double>(),
+             py::arg("p"), py::arg("mu1"), py::arg("mu2"))
+        .def_readonly("mean", &HyperExponentialDist::mean);
+
+    py::class_<ErlangDist>(m, "ErlangDist")
+        .def(py::init<int, double>(), py::arg("k"), py::arg("mu"))
+        .def_readonly("mean", &ErlangDist::mean);
+
+    py::class_<LognormalDist>(m, "LognormalDist")
+        .def(py::init<double, double>(), py::arg("mu"), py::arg("sigma"))
+        .def_readonly("mean", &LognormalDist::mean);
+
+    py::class_<WeibullDist>(m, "WeibullDist")
+        .def(py::init<double, double>(), py::arg("shape"),
+             py::arg("scale") = 1.0)
+        .def_readonly("mean", &WeibullDist::mean);
+
+    py::class_<DeterministicDist>(m, "DeterministicDist")
+        .def(py::init<double>(), py::arg("value"))
+        .def_readonly("mean", &DeterministicDist::mean);
+
+    // A sorted float64 array is used in place (and must not be modified
+    // afterwards); anything else is copied and sorted once.
+    py::class_<EmpiricalDist>(m, "EmpiricalDist")
+        .def(py::init([](py::array_t<double, py::array::c_style |
+                                                py::array::forcecast> values,
+                         bool interpolate) {
+            if (values.ndim() != 1)
+                throw py::value_error("values must be a 1-D array");
+            const double* data = values.data();
+            size_t n = static_cast<size_t>(values.size());
+            if (!EmpiricalDist::isSorted(data, n))
+                return EmpiricalDist(data, n, interpolate);
+            auto* ref = new py::object(values);
+            std::shared_ptr<const void> owner(ref, [](const void* p) {
+                py::gil_scoped_acquire gil;
+                delete static_cast<const py::object*>(p);
+            });
+            return EmpiricalDist::wrapSorted(data, n, std::move(owner),
+                                             interpolate);
+        }), py::arg("values"), py::arg("interpolate") = false)
+        .def_readonly("mean", &EmpiricalDist::mean)
+        .def_readonly("interpolate", &EmpiricalDist::interpolate)
+        .def("__len__", [](const EmpiricalDist& d) { return d.n; });
+
+    py::class_<TraceDist>(m, "TraceDist")
+        .def(py::init([](py::object path, int column, int n_columns,
+                         size_t offset) {
+            auto p = py::module_::import("os").attr("fspath")(path)
+                         .cast<std::string>();
+            return TraceDist(p, column, n_columns, offset);
+        }),
+             py::arg("path"), py::arg("column") = 0, py::arg("n_columns") = 1,
+             py::arg("offset") = 0)
+        .def_readonly("n_columns", &TraceDist::stride)
+        .def("__len__", [](const TraceDist& d) { return d.n; });
+
+    // -- Profiling (builds with QUEUE_SIM_PROFILE) ----------------------------
+
+    m.attr("PROFILING") = PROFILING;
+
+    py::class_<ServerProfile>(m, "ServerProfile")
+        .def_readonly("peak_state", &ServerProfile::peak_state)
+        .def_readonly("queue_capacity", &ServerProfile::queue_capacity);
+
+    py::class_<RunProfile>(m, "RunProfile")
+        .def_readonly("enabled", &RunProfile::enabled)
+        .def_readonly("arrivals", &RunProfile::arrivals)
+        .def_readonly("routes", &RunProfile::routes)
+        .def_readonly("departures", &RunProfile::departures)
+        .def_readonly("rejections", &RunProfile::rejections)
+        .def_readonly("level_crossings", &RunProfile::level_crossings)
+        .def_readonly("warmup_events", &RunProfile::warmup_events)
+        .def_readonly("measurement_events", &RunProfile::measurement_events)
+        .def_readonly("warmup_seconds", &RunProfile::warmup_seconds)
+        .def_readonly("measurement_seconds", &RunProfile::measurement_seconds)
+        .def_readonly("rng_draws", &RunProfile::rng_draws)
+        .def_readonly("job_pool_capacity", &RunProfile::job_pool_capacity)
+        .def_readonly("completed_capacity", &RunProfile::completed_capacity)
+        .def_readonly("event_log_capacity", &RunProfile::event_log_capacity)
+        .def_readonly("servers", &RunProfile::servers);
+
     // -- Server (abstract — not directly constructible) ----------------------
 
+    py::class_<ServerStats>(m, "ServerStats")
+        .def_readonly("area", &ServerStats::area)
+        .def_readonly("busy_time", &ServerStats::busy_time)
+        .def_readonly("duration", &ServerStats::duration)
+        .def_readonly("max_state", &ServerStats::max_state)
+        .def_readonly("completions", &ServerStats::completions)
+        .def_readonly("response_sum", &ServerStats::response_sum)
+        .def_property_readonly("mean_state", &ServerStats::meanState)
+        .def_property_readonly("utilization", &ServerStats::utilization)
+        .def_property_readonly("mean_response_time",
+                               &ServerStats::meanResponseTime);
+
     py::class_<Server, std::shared_ptr<Server>>(m, "Server")
         .def_readonly("T", &Server::T)
         .def_readonly("num_completions", &Server::num_completions)
@@ -39,6 +245,19 @@ PYBIND11_MODULE(_queue_sim_cpp, m) {
         .def_readonly("buffer_capacity", &Server::buffer_capacity)
         .def_readonly("num_rejected", &Server::num_rejected)
         .def_readonly("num_arrivals", &Server::num_arrivals)
+        .def_readonly("stats", &Server::stats)
+        .def_property("class_size_dists",
+            [](const Server& self) {
+                py::list out;
+                for (const auto& d : self.class_size_dists)
+                    out.append(fromDistribution(d));
+                return out;
+            },
+            [](Server& self, const std::vector<py::object>& dists) {
+                std::vector<Distribution> converted;
+                for (const auto& d : dists) converted.push_back(toDistribution(d));
+                self.class_size_dists = std::move(converted);
+            })
         .def("is_full", &Server::is_full)
         .def("queryTTNC", &Server::queryTTNC);
 
@@ -46,131 +265,504 @@ PYBIND11_MODULE(_queue_sim_cpp, m) {
 
     py::class_<FCFS, Server, std::shared_ptr<FCFS>>(m, "FCFS")
         .def(py::init([](py::object dist, int num_servers,
-                         int buffer_capacity) -> FCFS {
-            if (py::isinstance<ExponentialDist>(dist))
-                return FCFS(dist.cast<ExponentialDist>(), num_servers,
-                            buffer_capacity);
-            if (py::isinstance<UniformDist>(dist))
-                return FCFS(dist.cast<UniformDist>(), num_servers,
-                            buffer_capacity);
-            if (py::isinstance<BoundedParetoDist>(dist))
-                return FCFS(dist.cast<BoundedParetoDist>(), num_servers,
-                            buffer_capacity);
-            throw py::type_error(
-                "Expected ExponentialDist, UniformDist, or BoundedParetoDist");
+                         int buffer_capacity) {
+            return FCFS(toDistribution(dist), num_servers, buffer_capacity);
         }), py::arg("sizefn"), py::arg("num_servers") = 1,
             py::arg("buffer_capacity") = -1);
 
     // -- SRPT ----------------------------------------------------------------
 
     py::class_<SRPT, Server, std::shared_ptr<SRPT>>(m, "SRPT")
-        .def(py::init([](py::object dist, int buffer_capacity) -> SRPT {
-            if (py::isinstance<ExponentialDist>(dist))
-                return SRPT(dist.cast<ExponentialDist>(), buffer_capacity);
-            if (py::isinstance<UniformDist>(dist))
-                return SRPT(dist.cast<UniformDist>(), buffer_capacity);
-            if (py::isinstance<BoundedParetoDist>(dist))
-                return SRPT(dist.cast<BoundedParetoDist>(), buffer_capacity);
-            throw py::type_error(
-                "Expected ExponentialDist, UniformDist, or BoundedParetoDist");
+        .def(py::init([](py::object dist, int buffer_capacity) {
+            return SRPT(toDistribution(dist), buffer_capacity);
         }), py::arg("sizefn"), py::arg("buffer_capacity") = -1);
 
     // -- PS ------------------------------------------------------------------
 
     py::class_<PS, Server, std::shared_ptr<PS>>(m, "PS")
         .def(py::init([](py::object dist, int num_servers,
-                         int buffer_capacity) -> PS {
-            if (py::isinstance<ExponentialDist>(dist))
-                return PS(dist.cast<ExponentialDist>(), num_servers,
-                          buffer_capacity);
-            if (py::isinstance<UniformDist>(dist))
-                return PS(dist.cast<UniformDist>(), num_servers,
-                          buffer_capacity);
-            if (py::isinstance<BoundedParetoDist>(dist))
-                return PS(dist.cast<BoundedParetoDist>(), num_servers,
-                          buffer_capacity);
-            throw py::type_error(
-                "Expected ExponentialDist, UniformDist, or BoundedParetoDist");
+                         int buffer_capacity) {
+            return PS(toDistribution(dist), num_servers, buffer_capacity);
         }), py::arg("sizefn"), py::arg("num_servers") = 1,
             py::arg("buffer_capacity") = -1);
 
     // -- FB ------------------------------------------------------------------
 
     py::class_<FB, Server, std::shared_ptr<FB>>(m, "FB")
-        .def(py::init([](py::object dist, int buffer_capacity) -> FB {
-            if (py::isinstance<ExponentialDist>(dist))
-                return FB(dist.cast<ExponentialDist>(), buffer_capacity);
-            if (py::isinstance<UniformDist>(dist))
-                return FB(dist.cast<UniformDist>(), buffer_capacity);
-            if (py::isinstance<BoundedParetoDist>(dist))
-                return FB(dist.cast<BoundedParetoDist>(), buffer_capacity);
-            throw py::type_error(
-                "Expected ExponentialDist, UniformDist, or BoundedParetoDist");
+        .def(py::init([](py::object dist, int buffer_capacity) {
+            return FB(toDistribution(dist), buffer_capacity);
         }), py::arg("sizefn"), py::arg("buffer_capacity") = -1);
 
     // -- EventLog ------------------------------------------------------------
 
-    py::class_<EventLog>(m, "EventLog")
-        .def_readonly("times", &EventLog::times)
-        .def_readonly("kinds", &EventLog::kinds)
-        .def_readonly("from_servers", &EventLog::from_servers)
-        .def_readonly("to_servers", &EventLog::to_servers)
-        .def_readonly("states", &EventLog::states)
+    // Columns are zero-copy, read-only NumPy views; each array keeps the
+    // log alive.  A log is never modified once its run has returned.
+    py::class_<EventLog, std::shared_ptr<EventLog>>(m, "EventLog")
+        .def_property_readonly("times", [](py::object self) {
+            return column(self.cast<const EventLog&>().times, self);
+        })
+        .def_property_readonly("kinds", [](py::object self) {
+            return column(self.cast<const EventLog&>().kinds, self);
+        })
+        .def_property_readonly("from_servers", [](py::object self) {
+            return column(self.cast<const EventLog&>().from_servers, self);
+        })
+        .def_property_readonly("to_servers", [](py::object self) {
+            return column(self.cast<const EventLog&>().to_servers, self);
+        })
+        .def_property_readonly("states", [](py::object self) {
+            return column(self.cast<const EventLog&>().states, self);
+        })
         .def("__len__", &EventLog::size)
-        .def_property_readonly_static("ARRIVAL", [](py::object) { return EventLog::ARRIVAL; })
-        .def_property_readonly_static("DEPARTURE", [](py::object) { return EventLog::DEPARTURE; })
-        .def_property_readonly_static("ROUTE", [](py::object) { return EventLog::ROUTE; })
-        .def_property_readonly_static("REJECTION", [](py::object) { return EventLog::REJECTION; })
+        .def_property_readonly_static("ARRIVAL", [](py::object) { return static_cast<int>(EventLog::ARRIVAL); })
+        .def_property_readonly_static("DEPARTURE", [](py::object) { return static_cast<int>(EventLog::DEPARTURE); })
+        .def_property_readonly_static("ROUTE", [](py::object) { return static_cast<int>(EventLog::ROUTE); })
+        .def_property_readonly_static("REJECTION", [](py::object) { return static_cast<int>(EventLog::REJECTION); })
+        .def_property_readonly_static("KIND_NAMES", [](py::object) {
+            return py::make_tuple(EventLog::KIND_NAMES[0], EventLog::KIND_NAMES[1],
+                                  EventLog::KIND_NAMES[2], EventLog::KIND_NAMES[3]);
+        })
         .def_property_readonly_static("EXTERNAL", [](py::object) { return EventLog::EXTERNAL; })
-        .def_property_readonly_static("SYSTEM_EXIT", [](py::object) { return EventLog::SYSTEM_EXIT; });
+        .def_property_readonly_static("SYSTEM_EXIT", [](py::object) { return EventLog::SYSTEM_EXIT; })
+        .def_readonly("snapshots", &EventLog::snapshots);
+
+    py::class_<EventLog::Snapshot>(m, "EventLogSnapshot")
+        .def_readonly("trigger_time", &EventLog::Snapshot::trigger_time)
+        .def_readonly("trigger_index", &EventLog::Snapshot::trigger_index)
+        .def_readonly("events", &EventLog::Snapshot::events);
+
+    py::class_<EventWindow>(m, "EventWindow")
+        .def(py::init([](size_t capacity, int32_t trigger_state,
+                         bool trigger_on_rejection, size_t post_trigger_events,
+                         size_t max_snapshots) {
+            EventWindow w;
+            w.capacity = capacity;
+            w.trigger_state = trigger_state;
+            w.trigger_on_rejection = trigger_on_rejection;
+            w.post_trigger_events = post_trigger_events;
+            w.max_snapshots = max_snapshots;
+            return w;
+        }),
+             py::arg("capacity") = 0,
+             py::arg("trigger_state") = -1,
+             py::arg("trigger_on_rejection") = false,
+             py::arg("post_trigger_events") = 0,
+             py::arg("max_snapshots") = 16)
+        .def_readwrite("capacity", &EventWindow::capacity)
+        .def_readwrite("trigger_state", &EventWindow::trigger_state)
+        .def_readwrite("trigger_on_rejection", &EventWindow::trigger_on_rejection)
+        .def_readwrite("post_trigger_events", &EventWindow::post_trigger_events)
+        .def_readwrite("max_snapshots", &EventWindow::max_snapshots);
+
+    // -- Quantile sketches ---------------------------------------------------
+
+    py::class_<QuantileSketch>(m, "QuantileSketch")
+        .def(py::init<double>(), py::arg("relative_accuracy") = 0.01)
+        .def("add", &QuantileSketch::add, py::arg("x"))
+        .def("merge", &QuantileSketch::merge, py::arg("other"))
+        .def("quantile", &QuantileSketch::quantile, py::arg("q"))
+        .def("quantiles", [](const QuantileSketch& self, const std::vector<double>& qs) {
+            std::vector<double> out;
+            out.reserve(qs.size());
+            for (double q : qs) out.push_back(self.quantile(q));
+            return out;
+        }, py::arg("qs"))
+        .def("histogram", [](const QuantileSketch& self) {
+            std::vector<double> edges;
+            std::vector<uint64_t> counts;
+            self.histogram(edges, counts);
+            return py::make_tuple(py::array_t<double>(edges.size(), edges.data()),
+                                  py::array_t<uint64_t>(counts.size(), counts.data()));
+        })
+        .def_property_readonly("count", &QuantileSketch::count)
+        .def_property_readonly("sum", &QuantileSketch::sum)
+        .def_property_readonly("mean", &QuantileSketch::mean)
+        .def_property_readonly("min", &QuantileSketch::min)
+        .def_property_readonly("max", &QuantileSketch::max)
+        .def_property_readonly("relative_accuracy", &QuantileSketch::relativeAccuracy)
+        .def("__len__", &QuantileSketch::count);
+
+    py::class_<ResponseTimeSketch>(m, "ResponseTimeSketch")
+        .def_readonly("end_to_end", &ResponseTimeSketch::end_to_end)
+        .def_readonly("per_server", &ResponseTimeSketch::per_server)
+        .def("merge", &ResponseTimeSketch::merge, py::arg("other"));
 
     // -- ReplicationRawResult ------------------------------------------------
 
     py::class_<ReplicationRawResult>(m, "ReplicationRawResult")
         .def_readonly("raw_N", &ReplicationRawResult::raw_N)
-        .def_readonly("raw_T", &ReplicationRawResult::raw_T);
+        .def_readonly("raw_T", &ReplicationRawResult::raw_T)
+        .def_readonly("server_stats", &ReplicationRawResult::server_stats)
+        .def_readonly("class_stats", &ReplicationRawResult::class_stats)
+        .def_property_readonly("response_times", [](const ReplicationRawResult& r) {
+            py::list out;
+            for (const auto& rt : r.response_times)
+                out.append(responseTimesArray(rt));
+            return out;
+        })
+        .def_property_readonly("visit_counts", [](const ReplicationRawResult& r) {
+            py::list out;
+            for (const auto& rt : r.response_times)
+                out.append(visitCountsArray(rt));
+            return out;
+        })
+        .def_readonly("event_logs", &ReplicationRawResult::event_logs)
+        .def_readonly("sketches", &ReplicationRawResult::sketches)
+        .def_readonly("merged_sketch", &ReplicationRawResult::merged_sketch)
+        .def_readonly("cancelled", &ReplicationRawResult::cancelled)
+        .def_readonly("converged", &ReplicationRawResult::converged);
+
+    py::class_<StoppingRule>(m, "StoppingRule")
+        .def(py::init([](double rel_half_width, double confidence,
+                         int min_replications, int wave_size) {
+            StoppingRule rule;
+            rule.rel_half_width = rel_half_width;
+            rule.confidence = confidence;
+            rule.min_replications = min_replications;
+            rule.wave_size = wave_size;
+            rule.validate();
+            return rule;
+        }),
+             py::arg("rel_half_width") = 0.05,
+             py::arg("confidence") = 0.95,
+             py::arg("min_replications") = 10,
+             py::arg("wave_size") = 10)
+        .def_readwrite("rel_half_width", &StoppingRule::rel_half_width)
+        .def_readwrite("confidence", &StoppingRule::confidence)
+        .def_readwrite("min_replications", &StoppingRule::min_replications)
+        .def_readwrite("wave_size", &StoppingRule::wave_size);
+
+    // -- Snapshots ---------------------------------------------------------------
+
+    py::class_<Snapshot>(m, "Snapshot")
+        .def("to_bytes", [](const Snapshot& self) {
+            return py::bytes(self.save());
+        })
+        .def("__copy__", [](const Snapshot& self) { return Snapshot(self); })
+        .def_property_readonly("now", [](const Snapshot& self) {
+            return self.system.now;
+        })
+        .def_property_readonly("jobs_in_system", [](const Snapshot& self) {
+            return self.system.state;
+        })
+        .def_readonly("warmup_done", &Snapshot::warmup_done)
+        .def_readonly("measuring", &Snapshot::measuring)
+        .def_readonly("completions", &Snapshot::completions)
+        .def_property_readonly("result", &Snapshot::result)
+        .def_property_readonly("server_stats", &Snapshot::serverStats);
+
+    // -- Rare-event splitting --------------------------------------------------
+
+    py::class_<SplittingRule>(m, "SplittingRule")
+        .def(py::init([](std::vector<int> levels, int n_cycles, int effort) {
+            SplittingRule rule;
+            rule.levels = std::move(levels);
+            rule.n_cycles = n_cycles;
+            rule.effort = effort;
+            rule.validate();
+            return rule;
+        }),
+             py::arg("levels") = std::vector<int>(),
+             py::arg("n_cycles") = 10000,
+             py::arg("effort") = 1000)
+        .def_readwrite("levels", &SplittingRule::levels)
+        .def_readwrite("n_cycles", &SplittingRule::n_cycles)
+        .def_readwrite("effort", &SplittingRule::effort);
+
+    py::class_<SplittingResult>(m, "SplittingResult")
+        .def_readonly("loss_probability", &SplittingResult::loss_probability)
+        .def_readonly("half_width", &SplittingResult::half_width)
+        .def_readonly("raw", &SplittingResult::raw)
+        .def_readonly("levels", &SplittingResult::levels)
+        .def_readonly("level_probabilities",
+                      &SplittingResult::level_probabilities)
+        .def_readonly("arrivals_per_cycle",
+                      &SplittingResult::arrivals_per_cycle)
+        .def_readonly("events", &SplittingResult::events)
+        .def_readonly("confidence", &SplittingResult::confidence)
+        .def_readonly("cancelled", &SplittingResult::cancelled);
+
+    // -- Statistics ----------------------------------------------------------
+
+    py::class_<BatchMeans>(m, "BatchMeans")
+        .def_readonly("n_batches", &BatchMeans::n_batches)
+        .def_readonly("batch_size", &BatchMeans::batch_size)
+        .def_readonly("batch_N", &BatchMeans::batch_N)
+        .def_readonly("batch_T", &BatchMeans::batch_T)
+        .def("ci_half_N", &BatchMeans::ciHalfN, py::arg("confidence") = 0.95)
+        .def("ci_half_T", &BatchMeans::ciHalfT, py::arg("confidence") = 0.95)
+        .def_property_readonly("lag1_T", &BatchMeans::lag1T)
+        .def("__len__", [](const BatchMeans& b) { return b.batch_T.size(); });
+
+    m.def("t_inv_cdf", &tInvCdf, py::arg("p"), py::arg("df"));
+    m.def("ci_half_width", &ciHalfWidth, py::arg("values"),
+          py::arg("confidence"));
+
+    // -- Traffic classes -----------------------------------------------------
+
+    py::class_<TrafficClass>(m, "TrafficClass")
+        .def(py::init([](py::object arrivalfn, int entry_server,
+                         std::vector<std::vector<double>> tm) {
+            return TrafficClass{toDistribution(arrivalfn), entry_server,
+                                std::move(tm)};
+        }),
+             py::arg("arrivalfn"),
+             py::arg("entry_server") = 0,
+             py::arg("transitionMatrix") = std::vector<std::vector<double>>{})
+        .def_property_readonly("arrivalfn", [](const TrafficClass& c) {
+            return fromDistribution(c.arrivalDist);
+        })
+        .def_readwrite("entry_server", &TrafficClass::entry_server)
+        .def_readwrite("transitionMatrix", &TrafficClass::transitionMatrix);
+
+    py::class_<ClassStats>(m, "ClassStats")
+        .def_readonly("area", &ClassStats::area)
+        .def_readonly("duration", &ClassStats::duration)
+        .def_readonly("arrivals", &ClassStats::arrivals)
+        .def_readonly("completions", &ClassStats::completions)
+        .def_readonly("rejections", &ClassStats::rejections)
+        .def_property_readonly("mean_N", &ClassStats::meanN)
+        .def_property_readonly("mean_T", &ClassStats::meanT);
 
     // -- QueueSystem ---------------------------------------------------------
 
     py::class_<QueueSystem>(m, "QueueSystem")
         .def(py::init([](std::vector<std::shared_ptr<Server>> servers,
                          py::object arrivalDist,
-                         std::vector<std::vector<double>> tm) -> QueueSystem {
-            if (py::isinstance<ExponentialDist>(arrivalDist))
-                return QueueSystem(std::move(servers),
-                                   arrivalDist.cast<ExponentialDist>(),
-                                   std::move(tm));
-            if (py::isinstance<UniformDist>(arrivalDist))
-                return QueueSystem(std::move(servers),
-                                   arrivalDist.cast<UniformDist>(),
-                                   std::move(tm));
-            if (py::isinstance<BoundedParetoDist>(arrivalDist))
-                return QueueSystem(std::move(servers),
-                                   arrivalDist.cast<BoundedParetoDist>(),
-                                   std::move(tm));
-            throw py::type_error(
-                "Expected ExponentialDist, UniformDist, or BoundedParetoDist");
+                         std::vector<std::vector<double>> tm,
+                         RngKind rng_kind) {
+            return QueueSystem(std::move(servers), toDistribution(arrivalDist),
+                               std::move(tm), rng_kind);
         }),
              py::arg("servers"),
              py::arg("arrivalfn"),
-             py::arg("transitionMatrix") = std::vector<std::vector<double>>{})
-        .def("sim", &QueueSystem::sim,
+             py::arg("transitionMatrix") = std::vector<std::vector<double>>{},
+             py::arg("rng_kind") = RngKind::MT19937_64)
+        .def("sim",
+             [](QueueSystem& self, int num_events, int seed, int warmup,
+                bool track_response_times, bool track_events,
+                py::object response_times_out, bool sketch_response_times,
+                py::object event_log_path, int n_batches) {
+                 ResponseTimes buffer;
+                 if (!response_times_out.is_none())
+                     buffer = responseTimesBuffer(response_times_out);
+                 std::string path;
+                 if (!event_log_path.is_none())
+                     path = py::module_::import("os").attr("fspath")(event_log_path)
+                                .cast<std::string>();
+                 py::gil_scoped_release release;
+                 return self.sim(num_events, seed, warmup,
+                                 track_response_times, track_events,
+                                 std::move(buffer), sketch_response_times,
+                                 path, n_batches);
+             },
              py::arg("num_events") = 1000000,
              py::arg("seed") = -1,
              py::arg("warmup") = 0,
              py::arg("track_response_times") = false,
              py::arg("track_events") = false,
-             py::call_guard<py::gil_scoped_release>())
-        .def("replicate", &QueueSystem::replicate,
+             py::arg("response_times_out") = py::none(),
+             py::arg("sketch_response_times") = false,
+             py::arg("event_log_path") = py::none(),
+             py::arg("n_batches") = 0)
+        .def("replicate",
+             [](QueueSystem& self, int n_replications, int num_events,
+                int seed, int warmup, int n_threads,
+                bool track_response_times, bool track_events,
+                bool sketch_response_times,
+                std::optional<StoppingRule> stopping_rule, py::object progress,
+                bool vectorized) {
+                 // Runs on the calling thread between replications, with
+                 // the GIL re-acquired; also lets Ctrl-C cancel the run.
+                 ProgressFn on_progress = [&progress](int done, int total) {
+                     py::gil_scoped_acquire gil;
+                     if (!progress.is_none()) progress(done, total);
+                     if (PyErr_CheckSignals() != 0)
+                         throw py::error_already_set();
+                 };
+                 py::gil_scoped_release release;
+                 return self.replicate(n_replications, num_events, seed,
+                                       warmup, n_threads,
+                                       track_response_times, track_events,
+                                       sketch_response_times,
+                                       stopping_rule ? &*stopping_rule : nullptr,
+                                       on_progress, vectorized);
+             },
              py::arg("n_replications") = 30,
              py::arg("num_events") = 1000000,
              py::arg("seed") = -1,
              py::arg("warmup") = 0,
              py::arg("n_threads") = 0,
-             py::call_guard<py::gil_scoped_release>())
+             py::arg("track_response_times") = false,
+             py::arg("track_events") = false,
+             py::arg("sketch_response_times") = false,
+             py::arg("stopping_rule") = py::none(),
+             py::arg("progress") = py::none(),
+             py::arg("vectorized") = false)
+        .def("vectorizable", &QueueSystem::vectorizable)
+        .def("estimate_loss",
+             [](QueueSystem& self, std::optional<SplittingRule> rule,
+                int n_runs, int seed, int n_threads, double confidence,
+                py::object progress) {
+                 ProgressFn on_progress = [&progress](int done, int total) {
+                     py::gil_scoped_acquire gil;
+                     if (!progress.is_none()) progress(done, total);
+                     if (PyErr_CheckSignals() != 0)
+                         throw py::error_already_set();
+                 };
+                 py::gil_scoped_release release;
+                 return self.estimateLoss(rule ? *rule : SplittingRule(),
+                                          n_runs, seed, n_threads,
+                                          confidence, on_progress);
+             },
+             py::arg("rule") = py::none(),
+             py::arg("n_runs") = 10,
+             py::arg("seed") = -1,
+             py::arg("n_threads") = 0,
+             py::arg("confidence") = 0.95,
+             py::arg("progress") = py::none())
+        .def("warm_up",
+             [](const QueueSystem& self, int warmup, int seed) {
+                 py::gil_scoped_release release;
+                 return self.warmUp(warmup, seed);
+             },
+             py::arg("warmup") = 0,
+             py::arg("seed") = -1)
+        .def("load_snapshot",
+             [](const QueueSystem& self, const py::bytes& data) {
+                 return self.loadSnapshot(std::string(data));
+             },
+             py::arg("data"))
+        .def("sim_from",
+             [](QueueSystem& self, Snapshot& snapshot, int num_events) {
+                 py::gil_scoped_release release;
+                 return self.simFrom(snapshot, num_events);
+             },
+             py::arg("snapshot"),
+             py::arg("num_events") = 1000000)
+        .def("replicate_from",
+             [](QueueSystem& self, const Snapshot& snapshot,
+                int n_replications, int num_events, int seed, int n_threads,
+                py::object progress) {
+                 ProgressFn on_progress = [&progress](int done, int total) {
+                     py::gil_scoped_acquire gil;
+                     if (!progress.is_none()) progress(done, total);
+                     if (PyErr_CheckSignals() != 0)
+                         throw py::error_already_set();
+                 };
+                 py::gil_scoped_release release;
+                 return self.replicateFrom(snapshot, n_replications,
+                                           num_events, seed, n_threads,
+                                           on_progress);
+             },
+             py::arg("snapshot"),
+             py::arg("n_replications") = 30,
+             py::arg("num_events") = 1000000,
+             py::arg("seed") = -1,
+             py::arg("n_threads") = 0,
+             py::arg("progress") = py::none())
+        .def("cancel", &QueueSystem::cancel)
+        .def_property_readonly("progress", &QueueSystem::progress)
         .def("addServer", &QueueSystem::addServer)
         .def("updateTransitionMatrix", &QueueSystem::updateTransitionMatrix)
+        .def_readwrite("use_specialized", &QueueSystem::use_specialized)
+        .def_readwrite("rng_kind", &QueueSystem::rng_kind)
+        .def_readwrite("common_random_numbers",
+                       &QueueSystem::common_random_numbers)
+        .def_readwrite("track_visits", &QueueSystem::track_visits)
+        .def_readwrite("sketch_accuracy", &QueueSystem::sketch_accuracy)
+        .def_readwrite("event_window", &QueueSystem::event_window)
+        .def_readwrite("classes", &QueueSystem::classes)
+        .def_readonly("class_stats", &QueueSystem::class_stats)
         .def_readonly("T", &QueueSystem::T)
-        .def_readonly("response_times", &QueueSystem::response_times)
-        .def_readonly("event_log", &QueueSystem::event_log);
+        .def_property_readonly("response_times", [](const QueueSystem& self) {
+            return responseTimesArray(self.response_times);
+        })
+        .def_property_readonly("visit_counts", [](const QueueSystem& self) {
+            return visitCountsArray(self.response_times);
+        })
+        .def_readonly("event_log", &QueueSystem::event_log)
+        .def_readonly("sketch", &QueueSystem::sketch)
+        .def_readonly("batch_means", &QueueSystem::batch_means)
+        .def_readonly("profile", &QueueSystem::profile);
+
+    // -- Parameter sweeps -----------------------------------------------------
+
+    PYBIND11_NUMPY_DTYPE(SweepRow, config, replication, seed, mean_N, mean_T);
+
+    m.def("sweep",
+          [](const std::vector<QueueSystem*>& systems, int n_replications,
+             int num_events, int seed, int warmup, int n_threads,
+             py::object progress) {
+              std::vector<const QueueSystem*> configs(systems.begin(),
+                                                      systems.end());
+              ProgressFn on_progress = [&progress](int done, int total) {
+                  py::gil_scoped_acquire gil;
+                  if (!progress.is_none()) progress(done, total);
+                  if (PyErr_CheckSignals() != 0)
+                      throw py::error_already_set();
+              };
+              // One row per (config, replication): config, replication,
+              // seed, mean_N, mean_T.
+              SweepResult result;
+              {
+                  py::gil_scoped_release release;
+                  result = QueueSystem::sweep(configs, n_replications,
+                                              num_events, seed, warmup,
+                                              n_threads, nullptr, on_progress);
+              }
+              py::array_t<SweepRow> rows(
+                  static_cast<py::ssize_t>(result.rows.size()));
+              std::copy(result.rows.begin(), result.rows.end(),
+                        rows.mutable_data());
+              return rows;
+          },
+          py::arg("systems"),
+          py::arg("n_replications") = 30,
+          py::arg("num_events") = 1000000,
+          py::arg("seed") = -1,
+          py::arg("warmup") = 0,
+          py::arg("n_threads") = 0,
+          py::arg("progress") = py::none());
+
+    py::class_<PairedComparison>(m, "PairedComparison")
+        .def_property_readonly("rows", [](const PairedComparison& r) {
+            py::array_t<SweepRow> rows(
+                static_cast<py::ssize_t>(r.rows.size()));
+            std::copy(r.rows.begin(), r.rows.end(), rows.mutable_data());
+            return rows;
+        })
+        .def_readonly("mean_T", &PairedComparison::mean_T)
+        .def_readonly("half_width", &PairedComparison::half_width)
+        .def_readonly("diff_mean", &PairedComparison::diff_mean)
+        .def_readonly("diff_half_width", &PairedComparison::diff_half_width)
+        .def_readonly("n_paired", &PairedComparison::n_paired)
+        .def_readonly("confidence", &PairedComparison::confidence)
+        .def_readonly("cancelled", &PairedComparison::cancelled);
+
+    m.def("compare",
+          [](const std::vector<QueueSystem*>& systems, int n_replications,
+             int num_events, int seed, int warmup, int n_threads,
+             double confidence, py::object progress) {
+              std::vector<const QueueSystem*> configs(systems.begin(),
+                                                      systems.end());
+              ProgressFn on_progress = [&progress](int done, int total) {
+                  py::gil_scoped_acquire gil;
+                  if (!progress.is_none()) progress(done, total);
+                  if (PyErr_CheckSignals() != 0)
+                      throw py::error_already_set();
+              };
+              py::gil_scoped_release release;
+              return QueueSystem::compare(configs, n_replications,
+                                          num_events, seed, warmup, n_threads,
+                                          confidence, nullptr, on_progress);
+          },
+          py::arg("systems"),
+          py::arg("n_replications") = 30,
+          py::arg("num_events") = 1000000,
+          py::arg("seed") = -1,
+          py::arg("warmup") = 0,
+          py::arg("n_threads") = 0,
+          py::arg("confidence") = 0.95,
+          py::arg("progress") = py::none());
 }
@@ -29,11 +29,14 @@ def _import_deps():
 
 def _infer_edges(log) -> set[tuple[int, int]]:
     """Infer directed edges from observed ROUTE events in the log."""
+    from .event_log import kind_names
+
     edges: set[tuple[int, int]] = set()
+    kinds = kind_names(log.kinds)
     for i in range(len(log)):
-        if log.kinds[i] == "route":
-            fr = log.from_servers[i]
-            to = log.to_servers[i]
+        if kinds[i] == "route":
+            fr = int(log.from_servers[i])
+            to = int(log.to_servers[i])
             if fr >= 0 and to >= 0:
                 edges.add((fr, to))
     return edges
@@ -116,7 +119,7 @@ def animate_network(
         ``matplotlib.animation.FuncAnimation`` — call ``.save()`` or display
         inline in Jupyter.
     """
-    from .event_log import _bin_step_function, per_server_states
+    from .event_log import _bin_step_function, kind_names, per_server_states
 
     plt, animation_mod = _import_deps()
 
@@ -182,9 +185,10 @@ def animate_network(
 
     # Draw departure arrows from exit servers
     exit_servers = set()
+    kinds = kind_names(log.kinds)
     for i in range(len(log)):
-        if log.kinds[i] == "departure":
-            fr = log.from_servers[i]
+        if kinds[i] == "departure":
+            fr = int(log.from_servers[i])
             if fr >= 0:
                 exit_servers.add(fr)
     for s in exit_servers:
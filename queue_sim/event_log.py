@@ -2,6 +2,9 @@
 
 from __future__ import annotations
 
+import os
+import struct
+
 
 class EventLog:
     """Record of simulation events with parallel-vector storage."""
@@ -38,13 +41,117 @@ class EventLog:
         return len(self.times)
 
 
+# The C++ backend stores kinds as uint8 codes indexing this tuple
+# (``_queue_sim_cpp.EventLog.KIND_NAMES``).
+KIND_NAMES: tuple[str, ...] = (
+    EventLog.ARRIVAL, EventLog.DEPARTURE, EventLog.ROUTE, EventLog.REJECTION,
+)
+
+
+def kind_names(kinds) -> list[str]:
+    """Event kinds as strings, whether stored as names or as integer codes.
+
+    Args:
+        kinds: The ``kinds`` column of a Python EventLog (strings) or of a
+               C++ EventLog (uint8 NumPy array of codes).
+
+    Returns:
+        A list of kind names (``"arrival"``, ``"departure"``, ...).
+    """
+    if len(kinds) == 0 or isinstance(kinds[0], str):
+        return list(kinds)
+    return [KIND_NAMES[int(k)] for k in kinds]
+
+
+class MappedEventLog:
+    """Read-only event log memory-mapped from a file.
+
+    Reads the binary format written by the C++ backend's
+    ``sim(event_log_path=...)``: a header describing the columns followed
+    by packed fixed-width records.  Columns are NumPy views into the
+    mapping, so pages are only read when touched and a trace larger than
+    RAM can still be sliced, plotted, or passed to ``per_server_states``.
+
+    Args:
+        path: File written by ``sim(event_log_path=path)``.
+
+    Raises:
+        ValueError: If the file is not an event log in a supported format.
+    """
+
+    MAGIC = b"QSEVLOG\0"
+    VERSION = 1
+
+    EXTERNAL: int = EventLog.EXTERNAL
+    SYSTEM_EXIT: int = EventLog.SYSTEM_EXIT
+
+    def __init__(self, path: str | os.PathLike) -> None:
+        import numpy as np
+
+        self.path = os.fspath(path)
+        with open(self.path, "rb") as f:
+            fixed = f.read(32)
+            if len(fixed) < 32 or fixed[:8] != self.MAGIC:
+                raise ValueError(f"{self.path!r} is not an event log file")
+            (version, header_bytes, n_events,
+             record_bytes, n_columns) = struct.unpack("=IIQII", fixed[8:])
+            if version != self.VERSION:
+                raise ValueError(
+                    f"unsupported event log version {version} in {self.path!r}"
+                )
+            descriptors = f.read(24 * n_columns)
+
+        names, formats, offsets = [], [], []
+        for c in range(n_columns):
+            d = descriptors[24 * c:24 * (c + 1)]
+            names.append(d[:16].rstrip(b"\0").decode("ascii"))
+            formats.append(d[16:20].rstrip(b"\0").decode("ascii"))
+            offsets.append(struct.unpack("=I", d[20:24])[0])
+        dtype = np.dtype({"names": names, "formats": formats,
+                          "offsets": offsets, "itemsize": record_bytes})
+
+        # An unfinished file (n_events == 0) holds every complete record.
+        n = (os.path.getsize(self.path) - header_bytes) // record_bytes
+        if n_events:
+            n = min(n, n_events)
+        if n > 0:
+            self.records = np.memmap(self.path, dtype=dtype, mode="r",
+                                     offset=header_bytes, shape=(n,))
+        else:
+            self.records = np.empty(0, dtype=dtype)
+
+    @property
+    def times(self):
+        return self.records["time"]
+
+    @property
+    def kinds(self):
+        return self.records["kind"]
+
+    @property
+    def from_servers(self):
+        return self.records["from_server"]
+
+    @property
+    def to_servers(self):
+        return self.records["to_server"]
+
+    @property
+    def states(self):
+        return self.records["state"]
+
+    def __len__(self) -> int:
+        return len(self.records)
+
+
 def per_server_states(
     log,
     n_servers: int | None = None,
 ) -> dict[str, list]:
     """Reconstruct per-server occupancy from an event log.
 
-    Works with both Python and C++ EventLog objects via duck typing.
+    Works with both Python and C++ EventLog objects via duck typing; C++
+    columns may be NumPy arrays with integer kind codes.
 
     Args:
         log: An EventLog (Python or C++) with times, kinds, from_servers,
@@ -61,10 +168,13 @@ def per_server_states(
     if len(log) == 0:
         raise ValueError("Event log is empty")
 
-    kinds = log.kinds
-    from_servers = log.from_servers
-    to_servers = log.to_servers
-    times = log.times
+    if not isinstance(log.kinds[0], str):
+        return _per_server_states_coded(log, n_servers)
+
+    kinds = kind_names(log.kinds)
+    from_servers = list(log.from_servers)
+    to_servers = list(log.to_servers)
+    times = list(log.times)
 
     if n_servers is None:
         max_idx = -1
@@ -108,6 +218,42 @@ def per_server_states(
     return {"times": result_times, "server_states": server_states}
 
 
+def _per_server_states_coded(log, n_servers: int | None) -> dict[str, list]:
+    """Vectorized per_server_states for logs with integer kind codes.
+
+    C++ and memory-mapped logs store columns as NumPy arrays, so each
+    server's occupancy is a cumulative sum of +1/-1 steps rather than a
+    Python loop over events.
+    """
+    import numpy as np
+
+    kinds = np.asarray(log.kinds)
+    from_servers = np.asarray(log.from_servers)
+    to_servers = np.asarray(log.to_servers)
+
+    if n_servers is None:
+        n_servers = int(max(from_servers.max(), to_servers.max())) + 1
+
+    arrival, departure, route, rejection = (
+        KIND_NAMES.index(k) for k in (EventLog.ARRIVAL, EventLog.DEPARTURE,
+                                      EventLog.ROUTE, EventLog.REJECTION)
+    )
+    # Arrivals and routes add a job at to_server; departures, routes, and
+    # routed rejections (from_server >= 0) remove one from from_server.
+    enters = (kinds == arrival) | (kinds == route)
+    leaves = ((kinds == departure) | (kinds == route)
+              | ((kinds == rejection) & (from_servers >= 0)))
+
+    server_states = []
+    for s in range(n_servers):
+        steps = (enters & (to_servers == s)).astype(np.int64)
+        steps -= leaves & (from_servers == s)
+        server_states.append(np.cumsum(steps).tolist())
+
+    return {"times": np.asarray(log.times).tolist(),
+            "server_states": server_states}
+
+
 def _bin_step_function(
     times,
     values,
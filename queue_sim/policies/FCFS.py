@@ -77,11 +77,11 @@ class FCFS(Server):
             del self.channelArrivals[idx]
             self.state -= 1
 
+            # The queued job was already counted in state when it arrived.
             if self.waitQueue:
                 arr_time = self.waitQueue.popleft()
                 self.channelRemaining.append(self.genSize())
                 self.channelArrivals.append(arr_time)
-                self.state += 1
 
             self._recalc_ttnc()
             return True
@@ -1,13 +1,31 @@
-"""Build configuration for the C++ extension module."""
+"""Build configuration for the C++ extension module.
+
+Set QUEUE_SIM_PROFILE=1 in the environment to compile in the event-loop
+profiling counters (QueueSystem.profile); normal builds carry none.
+"""
+
+import os
+import sys
 
 from pybind11.setup_helpers import Pybind11Extension, build_ext
 from setuptools import setup
 
+define_macros = []
+if os.environ.get("QUEUE_SIM_PROFILE", "") not in ("", "0"):
+    define_macros.append(("QUEUE_SIM_PROFILE", "1"))
+
+# No fused multiply-adds: replicate(vectorized=True) reproduces the event
+# loop bit for bit only if neither is contracted (GCC does so by default
+# on targets with FMA, e.g. aarch64).
+extra_compile_args = [] if sys.platform == "win32" else ["-ffp-contract=off"]
+
 ext_modules = [
     Pybind11Extension(
         "_queue_sim_cpp",
         ["csrc/src/bindings.cpp"],
         include_dirs=["csrc/include"],
+        define_macros=define_macros,
+        extra_compile_args=extra_compile_args,
         cxx_std=17,
     ),
 ]
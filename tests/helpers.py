@@ -39,6 +39,9 @@ def mm1k_ploss(rho: float, K: int) -> float:
 def erlang_c(k: int, a: float) -> float:
     """Erlang-C formula: probability an arriving customer must wait in M/M/k.
 
+    Computed from Erlang-B, C = B / (1 - rho * (1 - B)), so it stays
+    finite for k in the hundreds.
+
     Args:
         k: number of servers
         a: offered load (lambda / mu)
@@ -47,9 +50,25 @@ def erlang_c(k: int, a: float) -> float:
         P(wait) — the probability a customer must queue.
     """
     rho = a / k
-    num = a**k / (factorial(k) * (1 - rho))
-    denom = sum(a**n / factorial(n) for n in range(k)) + num
-    return num / denom
+    b = erlang_b(k, a)
+    return b / (1 - rho * (1 - b))
+
+
+def mmck_ploss(c: int, K: int, a: float) -> float:
+    """Loss probability for M/M/c/K (c servers, K total capacity).
+
+    Args:
+        c: number of servers
+        K: total system capacity (in-service + waiting), K >= c
+        a: offered load (lambda / mu)
+
+    Returns:
+        P(loss) — fraction of arrivals rejected.
+    """
+    p = [a**n / factorial(n) for n in range(c + 1)]
+    for n in range(c + 1, K + 1):
+        p.append(p[-1] * a / c)
+    return p[K] / sum(p)
 
 
 def mmk_expected_T(lam: float, mu: float, k: int) -> float:
@@ -9,7 +9,7 @@ import pytest
 
 from queue_sim import FB, FCFS, PS, QueueSystem, genExp, genUniform
 
-from .helpers import erlang_b, mm1k_ploss, mmk_expected_T
+from .helpers import erlang_b, mm1k_ploss, mmck_ploss, mmk_expected_T
 
 NUM_EVENTS = 500_000
 RTOL = 0.05  # 5% relative tolerance
@@ -190,6 +190,27 @@ class TestErlangB:
         )
 
 
+class TestMMcK:
+    """M/M/c/K (multi-server, finite buffer): P(loss) matches analytical formula."""
+
+    @pytest.mark.parametrize("lam,mu,c,K", [
+        (2.5, 1.0, 3, 5),
+        (1.5, 1.0, 2, 5),
+    ])
+    def test_mmck_loss_probability(
+        self, lam: float, mu: float, c: int, K: int
+    ) -> None:
+        expected_ploss = mmck_ploss(c, K, lam / mu)
+        server = FCFS(sizefn=genExp(mu), num_servers=c, buffer_capacity=K)
+        system = QueueSystem([server], arrivalfn=genExp(lam))
+        system.sim(num_events=NUM_EVENTS, seed=42)
+        ploss = server.num_rejected / server.num_arrivals
+        assert ploss == pytest.approx(expected_ploss, abs=0.02), (
+            f"M/M/{c}/{K}: lam={lam}, mu={mu}: simulated P(loss)={ploss:.4f}, "
+            f"expected={expected_ploss:.4f}"
+        )
+
+
 class TestMM1K:
     """M/M/1/K (finite buffer): P(loss) matches analytical formula."""
 
@@ -3,11 +3,13 @@
 Mirrors test_analytical.py but uses the C++ extension module.
 """
 
+import math
+
 import pytest
 
 _queue_sim_cpp = pytest.importorskip("_queue_sim_cpp")
 
-from .helpers import erlang_b, mm1k_ploss, mmk_expected_T  # noqa: E402
+from .helpers import erlang_b, mm1k_ploss, mmck_ploss, mmk_expected_T  # noqa: E402
 
 NUM_EVENTS = 500_000
 RTOL = 0.05  # 5% relative tolerance
@@ -95,6 +97,47 @@ class TestMG1Cpp:
         )
 
 
+class TestMG1FamiliesCpp:
+    """M/G/1 FCFS (Pollaczek-Khinchine) and PS for each parametric family."""
+
+    FAMILIES = {
+        "hyperexponential": (lambda: _queue_sim_cpp.HyperExponentialDist(0.2, 0.5, 4.0),
+                             0.2 / 0.5 + 0.8 / 4.0, 0.2 * 2 / 0.5**2 + 0.8 * 2 / 4.0**2),
+        "erlang": (lambda: _queue_sim_cpp.ErlangDist(3, 3.0), 1.0, 4.0 / 3.0),
+        "lognormal": (lambda: _queue_sim_cpp.LognormalDist(-0.125, 0.5),
+                      1.0, math.exp(0.25)),
+        "weibull": (lambda: _queue_sim_cpp.WeibullDist(1.5, 1.0),
+                    math.gamma(1 + 1 / 1.5), math.gamma(1 + 2 / 1.5)),
+        "deterministic": (lambda: _queue_sim_cpp.DeterministicDist(1.0), 1.0, 1.0),
+    }
+
+    @pytest.mark.parametrize("family", sorted(FAMILIES))
+    def test_mean(self, family: str) -> None:
+        make, ES, _ = self.FAMILIES[family]
+        assert make().mean == pytest.approx(ES, rel=1e-12)
+
+    @pytest.mark.parametrize("family", sorted(FAMILIES))
+    def test_fcfs_pk_formula(self, family: str) -> None:
+        make, ES, ES2 = self.FAMILIES[family]
+        lam = 0.6 / ES
+        expected_T = ES + lam * ES2 / (2 * (1 - 0.6))
+        system = _queue_sim_cpp.QueueSystem(
+            [_queue_sim_cpp.FCFS(make())], _queue_sim_cpp.ExponentialDist(lam)
+        )
+        N, T = system.sim(num_events=NUM_EVENTS, seed=42, warmup=10_000)
+        assert T == pytest.approx(expected_T, rel=RTOL), family
+
+    @pytest.mark.parametrize("family", sorted(FAMILIES))
+    def test_ps_mean_response_time(self, family: str) -> None:
+        make, ES, _ = self.FAMILIES[family]
+        lam = 0.6 / ES
+        system = _queue_sim_cpp.QueueSystem(
+            [_queue_sim_cpp.PS(make())], _queue_sim_cpp.ExponentialDist(lam)
+        )
+        N, T = system.sim(num_events=NUM_EVENTS, seed=42, warmup=10_000)
+        assert T == pytest.approx(ES / (1 - 0.6), rel=RTOL), family
+
+
 class TestMM1PSCpp:
     """M/M/1-PS via C++ backend: E[T] = 1/(mu - lambda)."""
 
@@ -156,6 +199,25 @@ class TestMMkCpp:
             f"expected={expected_T:.4f}"
         )
 
+    @pytest.mark.parametrize("lam,mu,k", [
+        (95.0, 1.0, 100),
+        (475.0, 1.0, 500),
+    ])
+    def test_fcfs_mmk_large_k(self, lam: float, mu: float, k: int) -> None:
+        """Call-center scale k: exercises the channel heap."""
+        expected_T = mmk_expected_T(lam, mu, k)
+        server = _queue_sim_cpp.FCFS(
+            _queue_sim_cpp.ExponentialDist(mu), num_servers=k
+        )
+        system = _queue_sim_cpp.QueueSystem(
+            [server], _queue_sim_cpp.ExponentialDist(lam)
+        )
+        N, T = system.sim(num_events=2_000_000, seed=42, warmup=100_000)
+        assert T == pytest.approx(expected_T, rel=0.01), (
+            f"M/M/{k} FCFS: lam={lam}, mu={mu}: simulated E[T]={T:.4f}, "
+            f"expected={expected_T:.4f}"
+        )
+
     @pytest.mark.parametrize("lam,mu,k,expected_T", [
         (1.0, 1.0, 2, 4.0 / 3.0),
         (1.5, 1.0, 2, 16.0 / 7.0),
@@ -204,6 +266,34 @@ class TestErlangBCpp:
         )
 
 
+class TestMMcKCpp:
+    """M/M/c/K (multi-server, finite buffer) via C++ backend."""
+
+    @pytest.mark.parametrize("lam,mu,c,K", [
+        (2.5, 1.0, 3, 5),
+        (1.5, 1.0, 2, 5),
+        (9.0, 1.0, 10, 15),
+    ])
+    def test_mmck_loss_probability(
+        self, lam: float, mu: float, c: int, K: int
+    ) -> None:
+        expected_ploss = mmck_ploss(c, K, lam / mu)
+        server = _queue_sim_cpp.FCFS(
+            _queue_sim_cpp.ExponentialDist(mu),
+            num_servers=c,
+            buffer_capacity=K,
+        )
+        system = _queue_sim_cpp.QueueSystem(
+            [server], _queue_sim_cpp.ExponentialDist(lam)
+        )
+        system.sim(num_events=NUM_EVENTS, seed=42)
+        ploss = server.num_rejected / server.num_arrivals
+        assert ploss == pytest.approx(expected_ploss, abs=0.02), (
+            f"M/M/{c}/{K}: lam={lam}, mu={mu}: simulated P(loss)={ploss:.4f}, "
+            f"expected={expected_ploss:.4f}"
+        )
+
+
 class TestMM1KCpp:
     """M/M/1/K (finite buffer) via C++ backend."""
 
@@ -229,3 +319,72 @@ class TestMM1KCpp:
             f"M/M/1/{K}: lam={lam}, mu={mu}: simulated P(loss)={ploss:.4f}, "
             f"expected={expected_ploss:.4f}"
         )
+
+
+class TestJacksonNetworkCpp:
+    """Open Jackson ring network via C++ backend (event-calendar engine).
+
+    Server i routes to (i + 1) mod n w.p. p and exits w.p. 1 - p.
+    Each node is M/M/1, so E[N] = sum_i rho_i / (1 - rho_i) and, by
+    Little's law, E[T] = E[N] / lam.
+    """
+
+    @pytest.mark.parametrize("n,p", [(20, 0.9), (50, 0.5)])
+    def test_ring_mean_response_time(self, n: int, p: float) -> None:
+        lam, mu = 1.0, 15.0
+        # Traffic equations: l_0 = lam + p * l_{n-1}, l_i = p * l_{i-1}
+        rates = [lam / (1 - p**n) * p**i for i in range(n)]
+        expected_T = sum(
+            (r / mu) / (1 - r / mu) for r in rates
+        ) / lam
+
+        servers = [
+            _queue_sim_cpp.FCFS(_queue_sim_cpp.ExponentialDist(mu))
+            for _ in range(n)
+        ]
+        tm = [[0.0] * (n + 1) for _ in range(n)]
+        for i in range(n):
+            tm[i][(i + 1) % n] = p
+            tm[i][n] = 1 - p
+        system = _queue_sim_cpp.QueueSystem(
+            servers, _queue_sim_cpp.ExponentialDist(lam), tm
+        )
+        N, T = system.sim(num_events=NUM_EVENTS, seed=42)
+        assert T == pytest.approx(expected_T, rel=RTOL), (
+            f"ring n={n}, p={p}: simulated E[T]={T:.4f}, "
+            f"expected={expected_T:.4f}"
+        )
+
+
+class TestPSInsensitivityCpp:
+    """M/G/1-PS is insensitive: E[T] = E[S] / (1 - rho) for heavy tails too."""
+
+    def test_bounded_pareto(self) -> None:
+        k, p, alpha = 0.1, 100.0, 1.5
+        ES = (
+            p**alpha * k**alpha / (p**alpha - k**alpha)
+            * alpha / (alpha - 1)
+            * (1 / k ** (alpha - 1) - 1 / p ** (alpha - 1))
+        )
+        rho = 0.7
+        lam = rho / ES
+        expected_T = ES / (1 - rho)
+        server = _queue_sim_cpp.PS(_queue_sim_cpp.BoundedParetoDist(k, p, alpha))
+        system = _queue_sim_cpp.QueueSystem(
+            [server], _queue_sim_cpp.ExponentialDist(lam)
+        )
+        N, T = system.sim(num_events=NUM_EVENTS, seed=42)
+        assert T == pytest.approx(expected_T, rel=RTOL), (
+            f"M/BP/1-PS: simulated E[T]={T:.4f}, expected={expected_T:.4f}"
+        )
+
+    def test_unsaturated_k_serves_at_full_rate(self) -> None:
+        """With more servers than jobs, every job is served at rate 1."""
+        server = _queue_sim_cpp.PS(
+            _queue_sim_cpp.UniformDist(1.0, 1.0), num_servers=1000
+        )
+        system = _queue_sim_cpp.QueueSystem(
+            [server], _queue_sim_cpp.ExponentialDist(1.0)
+        )
+        system.sim(num_events=10_000, seed=1, track_response_times=True)
+        assert all(t == pytest.approx(1.0, abs=1e-9) for t in system.response_times)
@@ -0,0 +1,78 @@
+"""Tests for the C++ batch-means estimator (sim(n_batches=...))."""
+
+import pytest
+
+_queue_sim_cpp = pytest.importorskip("_queue_sim_cpp")
+
+from queue_sim.results import _build_replication_result  # noqa: E402
+
+
+def _make_mm1_cpp(lam: float = 0.8, mu: float = 1.0):
+    server = _queue_sim_cpp.FCFS(_queue_sim_cpp.ExponentialDist(mu))
+    return _queue_sim_cpp.QueueSystem([server], _queue_sim_cpp.ExponentialDist(lam))
+
+
+class TestBatchMeans:
+
+    def test_off_by_default(self) -> None:
+        sys = _make_mm1_cpp()
+        sys.sim(num_events=10_000, seed=1)
+        assert len(sys.batch_means) == 0
+
+    def test_batches_cover_run(self) -> None:
+        sys = _make_mm1_cpp()
+        N, T = sys.sim(num_events=200_000, seed=5, warmup=20_000, n_batches=20)
+        bm = sys.batch_means
+        assert len(bm) == 20
+        assert bm.batch_size == 10_000
+        assert len(bm.batch_N) == len(bm.batch_T) == 20
+        # Equal-sized batches partition the run: their T means average to
+        # the run's own estimate.
+        assert sum(bm.batch_T) / 20 == pytest.approx(T, rel=1e-9)
+
+    def test_estimates_unchanged(self) -> None:
+        with_batches = _make_mm1_cpp().sim(num_events=50_000, seed=3,
+                                           n_batches=10)
+        without = _make_mm1_cpp().sim(num_events=50_000, seed=3)
+        assert with_batches == without
+
+    @pytest.mark.parametrize("policy", ["FCFS", "PS", "FB"])
+    def test_ci_covers_analytical(self, policy: str) -> None:
+        lam, mu = 0.8, 1.0
+        expected_T = 1.0 / (mu - lam)
+        server = getattr(_queue_sim_cpp, policy)(_queue_sim_cpp.ExponentialDist(mu))
+        sys = _queue_sim_cpp.QueueSystem([server], _queue_sim_cpp.ExponentialDist(lam))
+        sys.sim(num_events=1_000_000, seed=42, warmup=10_000, n_batches=20)
+        bm = sys.batch_means
+        mean_T = sum(bm.batch_T) / len(bm)
+        assert abs(mean_T - expected_T) <= 2 * bm.ci_half_T()
+        assert abs(bm.lag1_T) < 0.5
+
+    def test_matches_replication_helpers(self) -> None:
+        sys = _make_mm1_cpp()
+        sys.sim(num_events=100_000, seed=9, n_batches=25)
+        bm = sys.batch_means
+        result = _build_replication_result(
+            tuple(bm.batch_N), tuple(bm.batch_T), 0.9)
+        assert bm.ci_half_T(0.9) == pytest.approx(result.ci_half_T, rel=1e-9)
+        assert bm.ci_half_N(0.9) == pytest.approx(result.ci_half_N, rel=1e-9)
+
+    def test_remainder_dropped(self) -> None:
+        sys = _make_mm1_cpp()
+        sys.sim(num_events=1_003, seed=1, n_batches=10)
+        assert len(sys.batch_means) == 10
+        assert sys.batch_means.batch_size == 100
+
+    def test_specialized_matches_generic(self) -> None:
+        def run(use_specialized):
+            sys = _make_mm1_cpp()
+            sys.use_specialized = use_specialized
+            sys.sim(num_events=20_000, seed=2, n_batches=8)
+            return list(sys.batch_means.batch_T)
+
+        assert run(True) == run(False)
+
+    @pytest.mark.parametrize("n_batches", [1, -3, 101])
+    def test_invalid_batch_count(self, n_batches: int) -> None:
+        with pytest.raises(ValueError):
+            _make_mm1_cpp().sim(num_events=100, n_batches=n_batches)
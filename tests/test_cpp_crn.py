@@ -0,0 +1,112 @@
+"""Tests for common random numbers and paired comparisons in the C++ backend."""
+
+import math
+
+import numpy as np
+import pytest
+
+_queue_sim_cpp = pytest.importorskip("_queue_sim_cpp")
+
+
+def _network(policy, crn=True):
+    """FCFS front server feeding two `policy` servers, with feedback."""
+    sys = _queue_sim_cpp.QueueSystem(
+        [_queue_sim_cpp.FCFS(_queue_sim_cpp.ExponentialDist(2.0)),
+         policy(_queue_sim_cpp.ExponentialDist(1.5)),
+         policy(_queue_sim_cpp.ExponentialDist(1.5))],
+        _queue_sim_cpp.ExponentialDist(1.0),
+        [[0, 0.5, 0.5, 0], [0, 0, 0.2, 0.8], [0.1, 0, 0, 0.9]])
+    sys.common_random_numbers = crn
+    return sys
+
+
+def _external_arrivals(sys):
+    log = sys.event_log
+    kinds = np.asarray(log.kinds)
+    mask = ((kinds == _queue_sim_cpp.EventLog.ARRIVAL)
+            & (np.asarray(log.from_servers) == _queue_sim_cpp.EventLog.EXTERNAL))
+    return np.asarray(log.times)[mask]
+
+
+def _mm1(policy, lam=0.8):
+    return _queue_sim_cpp.QueueSystem(
+        [policy(_queue_sim_cpp.ExponentialDist(1.0))],
+        _queue_sim_cpp.ExponentialDist(lam))
+
+
+class TestCommonRandomNumbers:
+
+    @pytest.mark.parametrize("crn", [False, True])
+    def test_arrivals_shared_across_policies(self, crn: bool) -> None:
+        times = []
+        for policy in (_queue_sim_cpp.FCFS, _queue_sim_cpp.PS, _queue_sim_cpp.SRPT):
+            sys = _network(policy, crn)
+            sys.sim(num_events=20_000, seed=3, track_events=True)
+            times.append(_external_arrivals(sys))
+        n = min(len(t) for t in times)
+        same = all(np.array_equal(times[0][:n], t[:n]) for t in times[1:])
+        assert same == crn
+
+    def test_specialized_and_generic_agree(self) -> None:
+        results = []
+        for use_specialized in (True, False):
+            sys = _network(_queue_sim_cpp.PS)
+            sys.use_specialized = use_specialized
+            raw = sys.replicate(n_replications=3, num_events=20_000, seed=5,
+                                n_threads=2)
+            results.append(list(raw.raw_T))
+        assert results[0] == results[1]
+
+    def test_default_off(self) -> None:
+        sys = _mm1(_queue_sim_cpp.FCFS)
+        assert not sys.common_random_numbers
+        expected = sys.sim(num_events=20_000, seed=1)
+        sys.common_random_numbers = True
+        assert sys.sim(num_events=20_000, seed=1) != expected
+        sys.common_random_numbers = False
+        assert sys.sim(num_events=20_000, seed=1) == expected
+
+
+class TestCompare:
+
+    def test_paired_difference_is_tighter(self) -> None:
+        systems = [_mm1(_queue_sim_cpp.FCFS), _mm1(_queue_sim_cpp.PS),
+                   _mm1(_queue_sim_cpp.SRPT)]
+        result = _queue_sim_cpp.compare(systems, n_replications=20,
+                                        num_events=50_000, seed=7,
+                                        warmup=5_000)
+        assert result.n_paired == 20 and not result.cancelled
+        assert result.diff_mean[0] == 0.0
+        # FCFS and PS have the same M/M/1 mean response time, 5.
+        assert abs(result.diff_mean[1]) < result.diff_half_width[1] * 2
+        assert result.diff_half_width[1] < result.half_width[0] / 4
+        assert result.diff_mean[2] < 0
+        assert result.mean_T[0] == pytest.approx(5.0, rel=0.1)
+
+        # The same comparison without common random numbers.
+        rows = _queue_sim_cpp.sweep(systems, n_replications=20,
+                                    num_events=50_000, seed=7, warmup=5_000)
+        T = rows["mean_T"].reshape(3, 20)
+        independent = _queue_sim_cpp.ci_half_width(list(T[1] - T[0]), 0.95)
+        assert result.diff_half_width[1] < independent / 4
+
+    def test_rows_match_replicate(self) -> None:
+        systems = [_mm1(_queue_sim_cpp.FCFS), _mm1(_queue_sim_cpp.SRPT)]
+        result = _queue_sim_cpp.compare(systems, n_replications=4,
+                                        num_events=10_000, seed=2,
+                                        n_threads=3)
+        assert not systems[1].common_random_numbers
+        systems[1].common_random_numbers = True
+        raw = systems[1].replicate(n_replications=4, num_events=10_000, seed=2)
+        assert list(result.rows["mean_T"][4:]) == list(raw.raw_T)
+
+    def test_single_replication(self) -> None:
+        result = _queue_sim_cpp.compare([_mm1(_queue_sim_cpp.FCFS)],
+                                        n_replications=1, num_events=1_000,
+                                        seed=1)
+        assert math.isnan(result.diff_half_width[0])
+
+    def test_bad_confidence(self) -> None:
+        with pytest.raises(ValueError):
+            _queue_sim_cpp.compare([_mm1(_queue_sim_cpp.FCFS)],
+                                   num_events=100, confidence=1.5)
@@ -0,0 +1,117 @@
+"""Tests for the C++ empirical and trace-replay distributions."""
+
+import numpy as np
+import pytest
+
+_queue_sim_cpp = pytest.importorskip("_queue_sim_cpp")
+
+
+def _mm1_trace(path, n, lam, mu, seed=0):
+    rng = np.random.default_rng(seed)
+    cols = np.column_stack([rng.exponential(1 / lam, n), rng.exponential(1 / mu, n)])
+    cols.astype(np.float64).tofile(path)
+
+
+class TestEmpiricalDist:
+
+    @pytest.mark.parametrize("interpolate", [False, True])
+    def test_resampled_exponential_matches_mm1(self, interpolate: bool) -> None:
+        lam, mu = 0.7, 1.0
+        sizes = np.random.default_rng(1).exponential(1 / mu, 200_000)
+        dist = _queue_sim_cpp.EmpiricalDist(sizes, interpolate=interpolate)
+        assert dist.mean == pytest.approx(sizes.mean())
+        assert len(dist) == len(sizes)
+        sys = _queue_sim_cpp.QueueSystem([_queue_sim_cpp.FCFS(dist)],
+                                         _queue_sim_cpp.ExponentialDist(lam))
+        _, T = sys.sim(num_events=500_000, seed=3, warmup=10_000)
+        rho = lam * dist.mean
+        assert T == pytest.approx(dist.mean / (1 - rho), rel=0.05)
+
+    def test_draws_are_observed_values(self) -> None:
+        values = np.array([0.5, 2.0, 7.0])
+        sys = _queue_sim_cpp.QueueSystem(
+            [_queue_sim_cpp.FCFS(_queue_sim_cpp.EmpiricalDist(values))],
+            _queue_sim_cpp.ExponentialDist(0.01))
+        sys.sim(num_events=3_000, seed=1, track_response_times=True)
+        # At this load almost every job finds the server idle.
+        rt = np.round(sys.response_times, 6)
+        assert set(np.unique(rt)) >= set(values)
+
+    def test_sorted_and_unsorted_input_agree(self) -> None:
+        values = np.random.default_rng(2).uniform(0.1, 2.0, 1_000)
+
+        def run(v):
+            sys = _queue_sim_cpp.QueueSystem(
+                [_queue_sim_cpp.PS(_queue_sim_cpp.EmpiricalDist(v))],
+                _queue_sim_cpp.ExponentialDist(0.5))
+            return sys.sim(num_events=20_000, seed=4)
+
+        assert run(values) == run(np.sort(values))
+        assert run(list(values)) == run(values)
+
+    def test_bad_values(self) -> None:
+        with pytest.raises(ValueError):
+            _queue_sim_cpp.EmpiricalDist(np.array([]))
+        with pytest.raises(ValueError):
+            _queue_sim_cpp.EmpiricalDist(np.array([1.0, -0.5]))
+        with pytest.raises(ValueError):
+            _queue_sim_cpp.EmpiricalDist(np.array([1.0, np.nan]))
+
+
+class TestTraceDist:
+
+    def test_replay_matches_mm1(self, tmp_path) -> None:
+        path = tmp_path / "trace.bin"
+        _mm1_trace(path, 400_000, lam=0.5, mu=1.0)
+        arrivals = _queue_sim_cpp.TraceDist(path, column=0, n_columns=2)
+        sizes = _queue_sim_cpp.TraceDist(path, column=1, n_columns=2)
+        assert len(arrivals) == 400_000
+        sys = _queue_sim_cpp.QueueSystem([_queue_sim_cpp.FCFS(sizes)], arrivals)
+        _, T = sys.sim(num_events=300_000, seed=1)
+        assert T == pytest.approx(2.0, rel=0.05)
+
+    def test_every_run_replays_from_the_start(self, tmp_path) -> None:
+        path = tmp_path / "trace.bin"
+        _mm1_trace(path, 50_000, lam=0.5, mu=1.0)
+        sys = _queue_sim_cpp.QueueSystem(
+            [_queue_sim_cpp.FCFS(_queue_sim_cpp.TraceDist(path, 1, 2))],
+            _queue_sim_cpp.TraceDist(path, 0, 2))
+        first = sys.sim(num_events=20_000, seed=1)
+        # No random draws remain, so the seed does not matter either.
+        assert sys.sim(num_events=20_000, seed=2) == first
+        raw = sys.replicate(n_replications=3, num_events=20_000, seed=1,
+                            n_threads=2)
+        assert list(raw.raw_T) == [first[1]] * 3
+
+    def test_wraps_around(self, tmp_path) -> None:
+        path = tmp_path / "trace.bin"
+        _mm1_trace(path, 1_000, lam=0.5, mu=1.0)
+        sys = _queue_sim_cpp.QueueSystem(
+            [_queue_sim_cpp.FCFS(_queue_sim_cpp.TraceDist(path, 1, 2))],
+            _queue_sim_cpp.TraceDist(path, 0, 2))
+        _, T = sys.sim(num_events=10_000, seed=1)
+        assert np.isfinite(T) and T > 0
+
+    def test_header_offset(self, tmp_path) -> None:
+        path = tmp_path / "trace.bin"
+        sizes = np.full(10, 0.25)
+        with open(path, "wb") as f:
+            f.write(b"\0" * 16)
+            sizes.tofile(f)
+        sys = _queue_sim_cpp.QueueSystem(
+            [_queue_sim_cpp.FCFS(_queue_sim_cpp.TraceDist(path, offset=16))],
+            _queue_sim_cpp.ExponentialDist(0.001))
+        sys.sim(num_events=100, seed=1, track_response_times=True)
+        assert np.allclose(sys.response_times, 0.25)
+
+    def test_bad_files(self, tmp_path) -> None:
+        path = tmp_path / "trace.bin"
+        np.zeros(3).tofile(path)
+        with pytest.raises(ValueError):
+            _queue_sim_cpp.TraceDist(path, column=0, n_columns=2)
+        with pytest.raises(ValueError):
+            _queue_sim_cpp.TraceDist(path, column=1)
+        with pytest.raises(ValueError):
+            _queue_sim_cpp.TraceDist(path, offset=4)
+        with pytest.raises(RuntimeError):
+            _queue_sim_cpp.TraceDist(tmp_path / "missing.bin")
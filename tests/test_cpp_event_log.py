@@ -1,5 +1,6 @@
 """Tests for event log tracking (C++ backend)."""
 
+import numpy as np
 import pytest
 
 _queue_sim_cpp = pytest.importorskip("_queue_sim_cpp")
@@ -209,16 +210,71 @@ class TestConstants:
     """Constants are accessible on the C++ EventLog class."""
 
     def test_kind_constants(self):
-        assert EventLog.ARRIVAL == "arrival"
-        assert EventLog.DEPARTURE == "departure"
-        assert EventLog.ROUTE == "route"
-        assert EventLog.REJECTION == "rejection"
+        assert EventLog.ARRIVAL == 0
+        assert EventLog.DEPARTURE == 1
+        assert EventLog.ROUTE == 2
+        assert EventLog.REJECTION == 3
+
+    def test_kind_names_match_python(self):
+        from queue_sim.event_log import KIND_NAMES
+
+        assert EventLog.KIND_NAMES == KIND_NAMES
+        assert EventLog.KIND_NAMES[EventLog.DEPARTURE] == "departure"
 
     def test_server_constants(self):
         assert EventLog.EXTERNAL == -1
         assert EventLog.SYSTEM_EXIT == -1
 
 
+class TestNumpyColumns:
+    """Columns are zero-copy, read-only, fixed-width NumPy arrays."""
+
+    def _log(self):
+        system = _make_tandem()
+        system.sim(num_events=NUM_EVENTS, seed=42, track_events=True)
+        return system, system.event_log
+
+    def test_dtypes(self):
+        _, log = self._log()
+        assert log.times.dtype == np.float64
+        assert log.kinds.dtype == np.uint8
+        assert log.from_servers.dtype == np.int32
+        assert log.to_servers.dtype == np.int32
+        assert log.states.dtype == np.int32
+
+    def test_zero_copy(self):
+        _, log = self._log()
+        assert np.shares_memory(log.times, log.times)
+        assert np.shares_memory(log.states, log.states)
+
+    def test_read_only(self):
+        _, log = self._log()
+        with pytest.raises(ValueError):
+            log.states[0] = 7
+
+    def test_arrays_outlive_next_run(self):
+        """A later sim() replaces the log; earlier arrays stay valid."""
+        system, log = self._log()
+        times = log.times
+        snapshot = times.copy()
+        del log
+        system.sim(num_events=100, seed=1, track_events=True)
+        assert np.array_equal(times, snapshot)
+        assert len(system.event_log) < len(snapshot)
+
+    def test_vectorized_counts(self):
+        _, log = self._log()
+        assert int((log.kinds == EventLog.DEPARTURE).sum()) == NUM_EVENTS
+
+    def test_kind_names(self):
+        from queue_sim.event_log import kind_names
+
+        _, log = self._log()
+        names = kind_names(log.kinds)
+        assert set(names) <= {"arrival", "departure", "route", "rejection"}
+        assert names.count("departure") == NUM_EVENTS
+
+
 class TestPerServerStates:
     """Tests for per_server_states() with C++ EventLog."""
 
@@ -257,3 +313,69 @@ class TestPerServerStates:
         # C++ backend: event_log exists but is empty
         with pytest.raises(ValueError, match="empty"):
             per_server_states(system.event_log)
+
+
+def _make_overloaded():
+    """Near-critical M/M/1/30: long busy periods and occasional rejections."""
+    server = _queue_sim_cpp.FCFS(_queue_sim_cpp.ExponentialDist(1.1), buffer_capacity=30)
+    return _queue_sim_cpp.QueueSystem([server], _queue_sim_cpp.ExponentialDist(1.0))
+
+
+class TestEventWindow:
+    """Ring-buffer capture keeps the last `capacity` events plus snapshots."""
+
+    def test_window_is_tail_of_full_log(self):
+        full = _make_overloaded()
+        full.sim(num_events=50_000, seed=4, track_events=True)
+        windowed = _make_overloaded()
+        windowed.event_window = _queue_sim_cpp.EventWindow(capacity=1000)
+        N, T = windowed.sim(num_events=50_000, seed=4, track_events=True)
+        assert T == full.T
+        log = windowed.event_log
+        assert len(log) == 1000
+        assert np.array_equal(log.times, full.event_log.times[-1000:])
+        assert np.array_equal(log.states, full.event_log.states[-1000:])
+
+    def test_state_trigger_snapshots(self):
+        full = _make_overloaded()
+        full.sim(num_events=200_000, seed=4, track_events=True)
+        ref_times = full.event_log.times
+        ref_states = full.event_log.states
+
+        windowed = _make_overloaded()
+        windowed.event_window = _queue_sim_cpp.EventWindow(
+            capacity=1000, trigger_state=25, post_trigger_events=200, max_snapshots=5)
+        windowed.sim(num_events=200_000, seed=4, track_events=True)
+        snapshots = windowed.event_log.snapshots
+        assert len(snapshots) == 5
+        previous = None
+        for snap in snapshots:
+            i = snap.trigger_index
+            # Fired as the state crossed the threshold from below...
+            assert ref_states[i] >= 25 and (i == 0 or ref_states[i - 1] < 25)
+            assert snap.trigger_time == ref_times[i]
+            # ...capturing the events up to 200 after the trigger...
+            end = i + 201
+            start = max(0, end - 1000)
+            assert np.array_equal(snap.events.times, ref_times[start:end])
+            # ...with no overlap between consecutive snapshots.
+            if previous is not None:
+                assert i >= previous + 1000
+            previous = i
+
+    def test_rejection_trigger_is_bounded(self):
+        system = _make_overloaded()
+        system.event_window = _queue_sim_cpp.EventWindow(
+            capacity=64, trigger_on_rejection=True, max_snapshots=3)
+        system.sim(num_events=200_000, seed=4, track_events=True)
+        snapshots = system.event_log.snapshots
+        assert len(snapshots) == 3
+        assert all(s.events.kinds[-1] == EventLog.REJECTION for s in snapshots)
+        assert len(system.event_log) == 64
+
+    def test_replications_bounded(self):
+        system = _make_overloaded()
+        system.event_window = _queue_sim_cpp.EventWindow(capacity=500)
+        raw = system.replicate(n_replications=3, num_events=20_000, seed=2,
+                               n_threads=2, track_events=True)
+        assert [len(log) for log in raw.event_logs] == [500, 500, 500]
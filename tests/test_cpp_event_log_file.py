@@ -0,0 +1,102 @@
+"""Tests for streaming C++ event logs to disk and memory-mapping them back."""
+
+import numpy as np
+import pytest
+
+_queue_sim_cpp = pytest.importorskip("_queue_sim_cpp")
+
+from queue_sim.event_log import MappedEventLog, kind_names, per_server_states  # noqa: E402
+
+# Enough jobs that the trace spans several write chunks.
+NUM_EVENTS = 50_000
+
+
+def _make_network():
+    """2-server network with a finite buffer, so every event kind occurs."""
+    s0 = _queue_sim_cpp.FCFS(_queue_sim_cpp.ExponentialDist(3.0), buffer_capacity=5)
+    s1 = _queue_sim_cpp.PS(_queue_sim_cpp.ExponentialDist(2.0))
+    return _queue_sim_cpp.QueueSystem(
+        [s0, s1], _queue_sim_cpp.ExponentialDist(1.0),
+        [[0, 0.5, 0.5], [0.2, 0, 0.8]],
+    )
+
+
+def _run_both(path):
+    """The same run logged in memory and streamed to ``path``."""
+    in_memory = _make_network()
+    in_memory.sim(num_events=NUM_EVENTS, seed=5, warmup=100, track_events=True)
+    streamed = _make_network()
+    streamed.sim(num_events=NUM_EVENTS, seed=5, warmup=100, event_log_path=path)
+    return in_memory, streamed
+
+
+class TestStreamedFile:
+    """sim(event_log_path=...) writes the same trace as track_events=True."""
+
+    def test_columns_match_in_memory_log(self, tmp_path):
+        path = tmp_path / "events.qslog"
+        in_memory, streamed = _run_both(path)
+        assert streamed.T == in_memory.T
+        mapped = MappedEventLog(path)
+        log = in_memory.event_log
+        assert len(mapped) == len(log) > 0
+        for col in ("times", "kinds", "from_servers", "to_servers", "states"):
+            assert np.array_equal(getattr(mapped, col), getattr(log, col)), col
+
+    def test_nothing_kept_in_memory(self, tmp_path):
+        _, streamed = _run_both(tmp_path / "events.qslog")
+        assert len(streamed.event_log) == 0
+
+    def test_header(self, tmp_path):
+        path = tmp_path / "events.qslog"
+        _run_both(path)
+        with open(path, "rb") as f:
+            assert f.read(8) == MappedEventLog.MAGIC
+
+
+class TestMappedEventLog:
+    """A mapped log works with the existing analysis helpers."""
+
+    def test_memmap_columns(self, tmp_path):
+        path = tmp_path / "events.qslog"
+        _run_both(path)
+        mapped = MappedEventLog(path)
+        assert isinstance(mapped.records, np.memmap)
+        assert mapped.times.dtype == np.float64
+        assert set(kind_names(mapped.kinds[:1000])) <= {
+            "arrival", "departure", "route", "rejection"}
+
+    def test_per_server_states_matches(self, tmp_path):
+        path = tmp_path / "events.qslog"
+        in_memory, _ = _run_both(path)
+        assert (per_server_states(MappedEventLog(path), n_servers=2)
+                == per_server_states(in_memory.event_log, n_servers=2))
+
+    def test_vectorized_matches_string_kinds(self, tmp_path):
+        """The NumPy fast path agrees with the per-event loop."""
+        path = tmp_path / "events.qslog"
+        _run_both(path)
+        mapped = MappedEventLog(path)
+
+        class StringLog:
+            times = list(mapped.times)
+            kinds = kind_names(mapped.kinds)
+            from_servers = list(mapped.from_servers)
+            to_servers = list(mapped.to_servers)
+
+            def __len__(self):
+                return len(self.times)
+
+        assert per_server_states(mapped) == per_server_states(StringLog())
+
+    def test_rejects_other_files(self, tmp_path):
+        path = tmp_path / "not_a_log.bin"
+        path.write_bytes(b"\0" * 64)
+        with pytest.raises(ValueError):
+            MappedEventLog(path)
+
+    def test_unwritable_path_raises(self, tmp_path):
+        system = _make_network()
+        with pytest.raises(RuntimeError):
+            system.sim(num_events=10, seed=1,
+                       event_log_path=tmp_path / "missing" / "events.qslog")
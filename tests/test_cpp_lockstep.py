@@ -0,0 +1,111 @@
+"""Tests for the lockstep replicate() engine of the C++ backend."""
+
+import pytest
+
+_queue_sim_cpp = pytest.importorskip("_queue_sim_cpp")
+
+RNG_KINDS = [_queue_sim_cpp.RngKind.MT19937_64,
+             _queue_sim_cpp.RngKind.XOSHIRO256PP,
+             _queue_sim_cpp.RngKind.PCG64]
+
+
+def _stats(raw):
+    return [[(s.area, s.busy_time, s.duration, s.max_state, s.completions,
+              s.response_sum) for s in rep] for rep in raw.server_stats]
+
+
+def _assert_same(a, b) -> None:
+    assert list(a.raw_N) == list(b.raw_N)
+    assert list(a.raw_T) == list(b.raw_T)
+    assert _stats(a) == _stats(b)
+    assert a.converged == b.converged and a.cancelled == b.cancelled
+
+
+def _both(sys, **kwargs):
+    return (sys.replicate(**kwargs),
+            sys.replicate(vectorized=True, **kwargs))
+
+
+class TestLockstep:
+
+    @pytest.mark.parametrize("rng_kind", RNG_KINDS)
+    @pytest.mark.parametrize("crn", [False, True])
+    @pytest.mark.parametrize("policy,sizefn", [
+        (_queue_sim_cpp.FCFS, _queue_sim_cpp.ExponentialDist(1.25)),
+        (_queue_sim_cpp.FCFS, _queue_sim_cpp.UniformDist(0.2, 1.4)),
+        (_queue_sim_cpp.SRPT, _queue_sim_cpp.BoundedParetoDist(0.3, 100, 1.5)),
+    ])
+    def test_matches_event_loop(self, policy, sizefn, crn: bool,
+                                rng_kind) -> None:
+        sys = _queue_sim_cpp.QueueSystem(
+            [policy(sizefn)], _queue_sim_cpp.ExponentialDist(1.0),
+            rng_kind=rng_kind)
+        sys.common_random_numbers = crn
+        assert sys.vectorizable()
+        # 19 replications: two full lane groups and a partial one.
+        a, b = _both(sys, n_replications=19, num_events=5_000, seed=7,
+                     warmup=300, n_threads=3)
+        _assert_same(a, b)
+
+    @pytest.mark.parametrize("policy", [_queue_sim_cpp.FCFS,
+                                        _queue_sim_cpp.SRPT])
+    def test_finite_buffer_and_exit_matrix(self, policy) -> None:
+        sys = _queue_sim_cpp.QueueSystem(
+            [policy(_queue_sim_cpp.ExponentialDist(1.1), buffer_capacity=3)],
+            _queue_sim_cpp.ExponentialDist(1.0), [[0, 1]])
+        assert sys.vectorizable()
+        a, b = _both(sys, n_replications=10, num_events=3_000, seed=4)
+        _assert_same(a, b)
+        assert max(s[0].max_state for s in _stats(b)) == 3
+
+    def test_thread_count_invariant(self) -> None:
+        sys = _queue_sim_cpp.QueueSystem(
+            [_queue_sim_cpp.SRPT(_queue_sim_cpp.ExponentialDist(1.25))],
+            _queue_sim_cpp.ExponentialDist(1.0))
+        runs = [sys.replicate(n_replications=20, num_events=2_000, seed=3,
+                              n_threads=t, vectorized=True) for t in (1, 2, 4)]
+        for r in runs[1:]:
+            _assert_same(runs[0], r)
+
+    def test_stopping_rule(self) -> None:
+        sys = _queue_sim_cpp.QueueSystem(
+            [_queue_sim_cpp.FCFS(_queue_sim_cpp.ExponentialDist(1.25))],
+            _queue_sim_cpp.ExponentialDist(1.0))
+        rule = _queue_sim_cpp.StoppingRule(rel_half_width=0.02,
+                                           min_replications=5, wave_size=7)
+        a, b = _both(sys, n_replications=200, num_events=3_000, seed=9,
+                     warmup=100, n_threads=2, stopping_rule=rule)
+        _assert_same(a, b)
+        assert b.converged
+
+    @pytest.mark.parametrize("make", [
+        lambda: _queue_sim_cpp.QueueSystem(
+            [_queue_sim_cpp.FCFS(_queue_sim_cpp.ExponentialDist(1.5), 2)],
+            _queue_sim_cpp.ExponentialDist(1.0)),
+        lambda: _queue_sim_cpp.QueueSystem(
+            [_queue_sim_cpp.PS(_queue_sim_cpp.ExponentialDist(1.5))],
+            _queue_sim_cpp.ExponentialDist(1.0)),
+        lambda: _queue_sim_cpp.QueueSystem(
+            [_queue_sim_cpp.FCFS(_queue_sim_cpp.ErlangDist(2, 3.0))],
+            _queue_sim_cpp.ExponentialDist(1.0)),
+        lambda: _queue_sim_cpp.QueueSystem(
+            [_queue_sim_cpp.FCFS(_queue_sim_cpp.ExponentialDist(1.5))],
+            _queue_sim_cpp.ExponentialDist(1.0), [[0.3, 0.7]]),
+        lambda: _queue_sim_cpp.QueueSystem(
+            [_queue_sim_cpp.FCFS(_queue_sim_cpp.ExponentialDist(3.0)),
+             _queue_sim_cpp.FCFS(_queue_sim_cpp.ExponentialDist(3.0))],
+            _queue_sim_cpp.ExponentialDist(1.0), [[0, 1, 0], [0, 0, 1]]),
+    ])
+    def test_ineligible_systems_fall_back(self, make) -> None:
+        sys = make()
+        assert not sys.vectorizable()
+        a, b = _both(sys, n_replications=5, num_events=1_000, seed=2)
+        _assert_same(a, b)
+
+    def test_traces_fall_back(self) -> None:
+        sys = _queue_sim_cpp.QueueSystem(
+            [_queue_sim_cpp.FCFS(_queue_sim_cpp.ExponentialDist(1.25))],
+            _queue_sim_cpp.ExponentialDist(1.0))
+        raw = sys.replicate(n_replications=4, num_events=1_000, seed=1,
+                            track_response_times=True, vectorized=True)
+        assert [len(rt) for rt in raw.response_times] == [1_000] * 4
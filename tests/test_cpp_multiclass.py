@@ -0,0 +1,103 @@
+"""Tests for multi-class traffic in the C++ backend."""
+
+import pytest
+
+_queue_sim_cpp = pytest.importorskip("_queue_sim_cpp")
+
+
+def _two_class_mg1():
+    """One FCFS server fed by two Poisson classes with different sizes."""
+    server = _queue_sim_cpp.FCFS(_queue_sim_cpp.ExponentialDist(1.0))
+    server.class_size_dists = [_queue_sim_cpp.ExponentialDist(2.0),
+                               _queue_sim_cpp.ExponentialDist(0.5)]
+    sys = _queue_sim_cpp.QueueSystem([server],
+                                     _queue_sim_cpp.ExponentialDist(1.0))
+    sys.classes = [_queue_sim_cpp.TrafficClass(_queue_sim_cpp.ExponentialDist(0.6)),
+                   _queue_sim_cpp.TrafficClass(_queue_sim_cpp.ExponentialDist(0.1))]
+    return sys
+
+
+class TestMultiClass:
+
+    def test_single_class_matches_classic_system(self) -> None:
+        tm = [[0.0, 0.7, 0.3], [0.1, 0.0, 0.9]]
+
+        def make():
+            return _queue_sim_cpp.QueueSystem(
+                [_queue_sim_cpp.FCFS(_queue_sim_cpp.ExponentialDist(2.0)),
+                 _queue_sim_cpp.PS(_queue_sim_cpp.ExponentialDist(3.0))],
+                _queue_sim_cpp.ExponentialDist(1.0), tm)
+
+        classic = make()
+        expected = classic.sim(num_events=50_000, seed=7, warmup=1_000)
+        sys = make()
+        sys.classes = [_queue_sim_cpp.TrafficClass(_queue_sim_cpp.ExponentialDist(1.0))]
+        assert sys.sim(num_events=50_000, seed=7, warmup=1_000) == expected
+        assert classic.class_stats == []
+        assert len(sys.class_stats) == 1
+        assert sys.class_stats[0].mean_N == pytest.approx(expected[0], rel=1e-12)
+        assert sys.class_stats[0].mean_T == pytest.approx(expected[1], rel=1e-12)
+
+    def test_mg1_fcfs_per_class_response_times(self) -> None:
+        # rho = 0.5, E[S^2] = 11/7; P-K wait W = lam E[S^2] / (2 (1 - rho)) = 1.1
+        sys = _two_class_mg1()
+        N, T = sys.sim(num_events=1_000_000, seed=3, warmup=10_000)
+        c0, c1 = sys.class_stats
+        assert c0.mean_T == pytest.approx(1.1 + 0.5, rel=0.05)
+        assert c1.mean_T == pytest.approx(1.1 + 2.0, rel=0.05)
+        assert c0.mean_N + c1.mean_N == pytest.approx(N, rel=1e-9)
+        assert c0.arrivals / c1.arrivals == pytest.approx(6.0, rel=0.05)
+
+    def test_per_class_entry_and_routing(self) -> None:
+        mu = _queue_sim_cpp.ExponentialDist(2.0)
+        sys = _queue_sim_cpp.QueueSystem(
+            [_queue_sim_cpp.FCFS(mu), _queue_sim_cpp.FCFS(mu)],
+            _queue_sim_cpp.ExponentialDist(1.0))
+        sys.classes = [
+            # Server 0 only
+            _queue_sim_cpp.TrafficClass(_queue_sim_cpp.ExponentialDist(0.5), 0,
+                                        [[0, 0, 1], [0, 0, 1]]),
+            # Server 1, then server 0
+            _queue_sim_cpp.TrafficClass(_queue_sim_cpp.ExponentialDist(0.5), 1,
+                                        [[0, 0, 1], [1, 0, 0]]),
+        ]
+        sys.sim(num_events=500_000, seed=5, warmup=10_000)
+        # Server 0 sees lam = 1 (T = 1), server 1 lam = 0.5 (T = 2/3)
+        assert sys.class_stats[0].mean_T == pytest.approx(1.0, rel=0.05)
+        assert sys.class_stats[1].mean_T == pytest.approx(5 / 3, rel=0.05)
+        assert sys.servers[1].stats.utilization == pytest.approx(0.25, rel=0.05)
+
+    @pytest.mark.parametrize("n_threads", [1, 3])
+    def test_replicate_per_class(self, n_threads: int) -> None:
+        sys = _two_class_mg1()
+        raw = sys.replicate(n_replications=4, num_events=20_000, seed=2,
+                            n_threads=n_threads)
+        assert len(raw.class_stats) == 4
+        ref = sys.replicate(n_replications=4, num_events=20_000, seed=2,
+                            n_threads=1)
+        for mine, theirs in zip(raw.class_stats, ref.class_stats):
+            assert [c.area for c in mine] == [c.area for c in theirs]
+        for N, classes in zip(raw.raw_N, raw.class_stats):
+            assert sum(c.mean_N for c in classes) == pytest.approx(N, rel=1e-9)
+
+    def test_class_size_dists_round_trip(self) -> None:
+        server = _queue_sim_cpp.PS(_queue_sim_cpp.ExponentialDist(1.0))
+        server.class_size_dists = [_queue_sim_cpp.UniformDist(0.5, 1.5)]
+        [dist] = server.class_size_dists
+        assert isinstance(dist, _queue_sim_cpp.UniformDist)
+        with pytest.raises(TypeError):
+            server.class_size_dists = [1.0]
+
+    def test_bad_entry_server(self) -> None:
+        sys = _two_class_mg1()
+        sys.classes = [_queue_sim_cpp.TrafficClass(
+            _queue_sim_cpp.ExponentialDist(1.0), entry_server=3)]
+        with pytest.raises(ValueError, match="entry_server"):
+            sys.sim(num_events=100)
+
+    def test_bad_class_matrix(self) -> None:
+        sys = _two_class_mg1()
+        sys.classes = [_queue_sim_cpp.TrafficClass(
+            _queue_sim_cpp.ExponentialDist(1.0), 0, [[0.5, 0.4]])]
+        with pytest.raises(ValueError, match="Class 0"):
+            sys.sim(num_events=100)
@@ -0,0 +1,87 @@
+"""Tests for the compiled-in event-loop profile of the C++ backend."""
+
+import pytest
+
+_queue_sim_cpp = pytest.importorskip("_queue_sim_cpp")
+
+profiling = pytest.mark.skipif(
+    not _queue_sim_cpp.PROFILING,
+    reason="extension built without QUEUE_SIM_PROFILE")
+
+
+def _network():
+    """FB front server feeding a two-channel PS server with a buffer of 5."""
+    return _queue_sim_cpp.QueueSystem(
+        [_queue_sim_cpp.FB(_queue_sim_cpp.ExponentialDist(1.25)),
+         _queue_sim_cpp.PS(_queue_sim_cpp.ExponentialDist(2.0), 2, 5)],
+        _queue_sim_cpp.ExponentialDist(1.0),
+        [[0, 1, 0], [0.2, 0, 0.8]])
+
+
+class TestProfile:
+
+    def test_disabled_build_reports_nothing(self) -> None:
+        if _queue_sim_cpp.PROFILING:
+            pytest.skip("extension built with QUEUE_SIM_PROFILE")
+        sys = _network()
+        sys.sim(num_events=10_000, seed=1)
+        p = sys.profile
+        assert not p.enabled
+        assert p.arrivals == p.departures == p.rng_draws == 0
+        assert p.servers == []
+
+    @profiling
+    def test_mm1_counts(self) -> None:
+        sys = _queue_sim_cpp.QueueSystem(
+            [_queue_sim_cpp.FCFS(_queue_sim_cpp.ExponentialDist(1.25))],
+            _queue_sim_cpp.ExponentialDist(1.0))
+        sys.sim(num_events=20_000, seed=3, warmup=1_000)
+        p = sys.profile
+        assert p.enabled
+        assert p.departures == 21_000
+        assert p.routes == p.rejections == p.level_crossings == 0
+        assert p.arrivals == p.departures + sys.servers[0].state
+        # Every arrival and departure is one event.
+        assert p.warmup_events + p.measurement_events == (
+            p.arrivals + p.departures)
+        # One interarrival time per arrival (plus the pending one) and one
+        # size per job.
+        assert p.rng_draws == 2 * p.arrivals + 1
+        assert p.warmup_seconds >= 0 and p.measurement_seconds > 0
+        assert p.servers[0].peak_state >= sys.servers[0].stats.max_state
+        assert p.job_pool_capacity >= p.servers[0].peak_state
+
+    @profiling
+    @pytest.mark.parametrize("specialized", [True, False])
+    def test_network_flow_balance(self, specialized: bool) -> None:
+        sys = _network()
+        sys.use_specialized = specialized
+        sys.sim(num_events=20_000, seed=5, warmup=500)
+        p = sys.profile
+        in_system = sum(s.state for s in sys.servers)
+        assert p.arrivals == p.departures + p.rejections + in_system
+        assert p.routes > 0 and p.rejections > 0
+        assert p.level_crossings > 0  # FB groups catching up
+        assert p.servers[1].peak_state == 5
+        assert all(s.queue_capacity >= s.peak_state for s in p.servers)
+
+    @profiling
+    def test_counts_match_across_engines(self) -> None:
+        counts = []
+        for specialized in (True, False):
+            sys = _network()
+            sys.use_specialized = specialized
+            sys.sim(num_events=20_000, seed=5, warmup=500)
+            p = sys.profile
+            counts.append((p.arrivals, p.routes, p.departures, p.rejections,
+                           p.level_crossings, p.warmup_events,
+                           p.measurement_events, p.rng_draws))
+        assert counts[0] == counts[1]
+
+    @profiling
+    def test_event_log_capacity(self) -> None:
+        sys = _network()
+        sys.sim(num_events=5_000, seed=2, track_events=True)
+        assert sys.profile.event_log_capacity >= len(sys.event_log)
+        sys.sim(num_events=5_000, seed=2)
+        assert sys.profile.event_log_capacity == 0
@@ -0,0 +1,126 @@
+"""Tests for streaming response-time quantile sketches (C++ backend)."""
+
+import numpy as np
+import pytest
+
+_queue_sim_cpp = pytest.importorskip("_queue_sim_cpp")
+
+QUANTILES = [0.5, 0.9, 0.95, 0.99, 0.999]
+
+
+def _make_network():
+    """Two-station network with a heavy-tailed PS station."""
+    servers = [
+        _queue_sim_cpp.FCFS(_queue_sim_cpp.ExponentialDist(3.0)),
+        _queue_sim_cpp.PS(_queue_sim_cpp.BoundedParetoDist(0.3, 1000, 1.5)),
+    ]
+    return _queue_sim_cpp.QueueSystem(
+        servers, _queue_sim_cpp.ExponentialDist(1.0),
+        [[0, 0.5, 0.5], [0.2, 0, 0.8]],
+    )
+
+
+class TestQuantileSketch:
+    """The sketch on its own."""
+
+    def test_relative_error_bound(self):
+        rng = np.random.default_rng(0)
+        xs = rng.lognormal(0.0, 2.0, 100_000)
+        sketch = _queue_sim_cpp.QuantileSketch(0.01)
+        for x in xs:
+            sketch.add(x)
+        for q in QUANTILES:
+            exact = np.quantile(xs, q, method="lower")
+            assert sketch.quantile(q) == pytest.approx(exact, rel=0.011)
+        assert sketch.count == len(xs)
+        assert sketch.min == xs.min() and sketch.max == xs.max()
+
+    def test_merge_equals_single_stream(self):
+        rng = np.random.default_rng(1)
+        xs = rng.exponential(1.0, 20_000)
+        whole = _queue_sim_cpp.QuantileSketch()
+        a = _queue_sim_cpp.QuantileSketch()
+        b = _queue_sim_cpp.QuantileSketch()
+        for i, x in enumerate(xs):
+            whole.add(x)
+            (a if i % 2 else b).add(x)
+        a.merge(b)
+        assert a.quantiles(QUANTILES) == whole.quantiles(QUANTILES)
+        assert a.count == whole.count
+
+    def test_merge_rejects_mismatched_accuracy(self):
+        with pytest.raises(ValueError):
+            _queue_sim_cpp.QuantileSketch(0.01).merge(
+                _queue_sim_cpp.QuantileSketch(0.02))
+
+    def test_histogram_covers_all_samples(self):
+        sketch = _queue_sim_cpp.QuantileSketch()
+        for x in [0.0, 0.5, 1.0, 2.0, 100.0]:
+            sketch.add(x)
+        edges, counts = sketch.histogram()
+        assert len(edges) == len(counts) + 1
+        assert counts.sum() == 5
+        assert np.all(np.diff(edges) > 0)
+
+    def test_empty_and_invalid(self):
+        sketch = _queue_sim_cpp.QuantileSketch()
+        assert np.isnan(sketch.quantile(0.5))
+        with pytest.raises(ValueError):
+            sketch.quantile(1.5)
+        with pytest.raises(ValueError):
+            _queue_sim_cpp.QuantileSketch(0.0)
+
+
+class TestSimSketch:
+    """sim(sketch_response_times=True) fills system.sketch."""
+
+    def test_matches_exact_quantiles(self):
+        system = _make_network()
+        system.sim(num_events=100_000, seed=3, warmup=1000,
+                   track_response_times=True, sketch_response_times=True)
+        rt = system.response_times
+        e2e = system.sketch.end_to_end
+        assert e2e.count == len(rt)
+        for q in QUANTILES:
+            exact = np.quantile(rt, q, method="lower")
+            assert e2e.quantile(q) == pytest.approx(exact, rel=0.011)
+        assert e2e.mean == pytest.approx(rt.mean())
+
+    def test_per_server_counts(self):
+        system = _make_network()
+        system.sim(num_events=50_000, seed=3, sketch_response_times=True)
+        per_server = system.sketch.per_server
+        assert len(per_server) == 2
+        # Every system exit is also a completion at some station.
+        assert sum(s.count for s in per_server) >= system.sketch.end_to_end.count
+        assert all(s.count > 0 for s in per_server)
+
+    def test_off_by_default(self):
+        system = _make_network()
+        system.sim(num_events=1000, seed=3)
+        assert system.sketch.end_to_end.count == 0
+
+    def test_accuracy_setting(self):
+        system = _make_network()
+        system.sketch_accuracy = 0.05
+        system.sim(num_events=1000, seed=3, sketch_response_times=True)
+        assert system.sketch.end_to_end.relative_accuracy == 0.05
+
+
+class TestReplicateSketch:
+    """Per-replication sketches merge across threads deterministically."""
+
+    def test_merged_counts_and_thread_invariance(self):
+        system = _make_network()
+        kwargs = dict(n_replications=4, num_events=20_000, seed=9,
+                      sketch_response_times=True)
+        one = system.replicate(n_threads=1, **kwargs)
+        four = system.replicate(n_threads=4, **kwargs)
+        assert len(four.sketches) == 4
+        assert four.merged_sketch.end_to_end.count == 4 * 20_000
+        assert (four.merged_sketch.end_to_end.quantiles(QUANTILES)
+                == one.merged_sketch.end_to_end.quantiles(QUANTILES))
+
+    def test_empty_when_disabled(self):
+        raw = _make_network().replicate(n_replications=2, num_events=1000, seed=1)
+        assert len(raw.sketches) == 0
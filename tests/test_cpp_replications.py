@@ -211,3 +211,221 @@ class TestCppParallelReplicate:
         r2 = sys.replicate(n_replications=10, num_events=10_000, seed=42, n_threads=4)
         assert list(r1.raw_T) == list(r2.raw_T)
         assert list(r1.raw_N) == list(r2.raw_N)
+
+
+class TestCppReplicateScheduling:
+    """Thread-pool scheduler: progress reporting and cooperative cancel."""
+
+    def test_heavy_tail_thread_invariant(self) -> None:
+        """Dynamic scheduling must not change per-replication results."""
+        def run(n_threads):
+            server = _queue_sim_cpp.FCFS(
+                _queue_sim_cpp.BoundedParetoDist(0.01, 1e4, 1.1))
+            sys = _queue_sim_cpp.QueueSystem(
+                [server], _queue_sim_cpp.ExponentialDist(1.0))
+            raw = sys.replicate(n_replications=12, num_events=5_000, seed=8,
+                                n_threads=n_threads)
+            return list(raw.raw_T)
+
+        assert run(1) == run(3) == run(12)
+
+    def test_progress_callback(self) -> None:
+        calls = []
+        sys = _make_mm1_cpp()
+        raw = sys.replicate(n_replications=8, num_events=5_000, seed=1,
+                            n_threads=2,
+                            progress=lambda done, total: calls.append((done, total)))
+        assert not raw.cancelled
+        assert calls[-1] == (8, 8)
+        dones = [d for d, _ in calls]
+        assert dones == sorted(set(dones))
+        assert sys.progress == (8, 8)
+
+    def test_progress_exception_propagates(self) -> None:
+        def boom(done, total):
+            raise RuntimeError("stop")
+
+        sys = _make_mm1_cpp()
+        with pytest.raises(RuntimeError, match="stop"):
+            sys.replicate(n_replications=8, num_events=5_000, seed=1,
+                          n_threads=2, progress=boom)
+        # The system (and the shared pool) remain usable.
+        raw = sys.replicate(n_replications=4, num_events=5_000, seed=1)
+        assert len(raw.raw_T) == 4
+        assert not raw.cancelled
+
+    def test_cancel_from_progress(self) -> None:
+        sys = _make_mm1_cpp()
+
+        def cancel_after_two(done, total):
+            if done >= 2:
+                sys.cancel()
+
+        raw = sys.replicate(n_replications=200, num_events=20_000, seed=1,
+                            n_threads=1, progress=cancel_after_two)
+        assert raw.cancelled
+        assert 2 <= len(raw.raw_T) < 200
+        assert len(raw.raw_N) == len(raw.raw_T)
+
+    def test_cancel_from_other_thread(self) -> None:
+        import threading
+
+        sys = _make_mm1_cpp()
+        timer = threading.Timer(0.2, sys.cancel)
+        timer.start()
+        try:
+            raw = sys.replicate(n_replications=10_000, num_events=200_000,
+                                seed=1, n_threads=2)
+        finally:
+            timer.cancel()
+        assert raw.cancelled
+        assert len(raw.raw_T) < 10_000
+
+    def test_cancelled_prefix_matches_full_run(self) -> None:
+        """Replications that did finish are the same as in a full run."""
+        sys = _make_mm1_cpp()
+
+        def cancel_after_three(done, total):
+            if done >= 3:
+                sys.cancel()
+
+        partial = sys.replicate(n_replications=50, num_events=5_000, seed=6,
+                                n_threads=1, progress=cancel_after_three)
+        full = sys.replicate(n_replications=50, num_events=5_000, seed=6,
+                             n_threads=1)
+        k = len(partial.raw_T)
+        assert list(partial.raw_T) == list(full.raw_T)[:k]
+
+
+class TestCppReplicateTraces:
+    """Per-replication response times / event logs from replicate()."""
+
+    def test_not_collected_by_default(self) -> None:
+        raw = _make_mm1_cpp().replicate(n_replications=3, num_events=2_000, seed=1)
+        assert len(raw.response_times) == 0
+        assert len(raw.event_logs) == 0
+
+    def test_response_times_per_replication(self) -> None:
+        sys = _make_mm1_cpp()
+        raw = sys.replicate(n_replications=6, num_events=5_000, seed=3,
+                            n_threads=3, track_response_times=True)
+        assert len(raw.response_times) == 6
+        for rts, T in zip(raw.response_times, raw.raw_T):
+            assert len(rts) == 5_000
+            assert sum(rts) / len(rts) == pytest.approx(T, rel=0.05)
+
+    def test_traces_match_single_replication(self) -> None:
+        """A replication's traces don't depend on what runs beside it."""
+        kwargs = dict(num_events=3_000, seed=9, track_response_times=True,
+                      track_events=True)
+        many = _make_mm1_cpp().replicate(n_replications=4, n_threads=2, **kwargs)
+        one = _make_mm1_cpp().replicate(n_replications=1, **kwargs)
+        assert list(many.response_times[0]) == list(one.response_times[0])
+        assert list(many.event_logs[0].times) == list(one.event_logs[0].times)
+        assert many.raw_T[0] == one.raw_T[0]
+
+    def test_thread_invariant(self) -> None:
+        def run(n_threads):
+            raw = _make_mm1_cpp().replicate(
+                n_replications=5, num_events=2_000, seed=4,
+                n_threads=n_threads, track_response_times=True)
+            return [list(r) for r in raw.response_times]
+
+        assert run(1) == run(4)
+
+    def test_event_logs_per_replication(self) -> None:
+        raw = _make_mm1_cpp().replicate(n_replications=3, num_events=2_000,
+                                        seed=5, track_events=True)
+        assert len(raw.event_logs) == 3
+        for log in raw.event_logs:
+            kinds = list(log.kinds)
+            assert kinds.count(_queue_sim_cpp.EventLog.DEPARTURE) == 2_000
+
+    def test_cancelled_traces_are_trimmed(self) -> None:
+        sys = _make_mm1_cpp()
+
+        def cancel_after_two(done, total):
+            if done >= 2:
+                sys.cancel()
+
+        raw = sys.replicate(n_replications=100, num_events=20_000, seed=1,
+                            n_threads=1, track_response_times=True,
+                            progress=cancel_after_two)
+        assert raw.cancelled
+        assert len(raw.response_times) == len(raw.raw_T)
+        assert all(len(r) == 20_000 for r in raw.response_times)
+
+
+class TestCppSequentialStopping:
+    """replicate(stopping_rule=...) runs waves until the CI is narrow enough."""
+
+    def test_t_inv_cdf_matches_python(self) -> None:
+        from queue_sim.results import _ci_half_width, _t_inv_cdf
+
+        for p, df in [(0.975, 29), (0.975, 9), (0.95, 1), (0.025, 3)]:
+            assert _queue_sim_cpp.t_inv_cdf(p, df) == pytest.approx(
+                _t_inv_cdf(p, df), rel=1e-12)
+        values = [1.0, 2.5, 0.7, 3.1, 1.9]
+        assert _queue_sim_cpp.ci_half_width(values, 0.9) == pytest.approx(
+            _ci_half_width(tuple(values), 0.9), rel=1e-12)
+
+    def test_stops_at_target(self) -> None:
+        rule = _queue_sim_cpp.StoppingRule(rel_half_width=0.03,
+                                           min_replications=5, wave_size=7)
+        raw = _make_mm1_cpp(0.8, 1.0).replicate(
+            n_replications=500, num_events=20_000, seed=9, stopping_rule=rule)
+        assert raw.converged
+        n = len(raw.raw_T)
+        assert 5 <= n < 500
+        assert (n - 5) % 7 == 0
+        result = _build_replication_result(
+            tuple(raw.raw_N), tuple(raw.raw_T), 0.95)
+        assert result.ci_half_T <= 0.03 * result.mean_T
+
+    def test_prefix_of_fixed_run(self) -> None:
+        sys = _make_mm1_cpp(0.8, 1.0)
+        rule = _queue_sim_cpp.StoppingRule(rel_half_width=0.05)
+        seq = sys.replicate(n_replications=200, num_events=10_000, seed=3,
+                            stopping_rule=rule)
+        full = sys.replicate(n_replications=len(seq.raw_T),
+                             num_events=10_000, seed=3)
+        assert list(seq.raw_T) == list(full.raw_T)
+
+    def test_thread_invariant(self) -> None:
+        def run(n_threads):
+            rule = _queue_sim_cpp.StoppingRule(rel_half_width=0.04,
+                                               min_replications=3, wave_size=2)
+            raw = _make_mm1_cpp(0.8, 1.0).replicate(
+                n_replications=300, num_events=10_000, seed=4,
+                n_threads=n_threads, stopping_rule=rule)
+            return list(raw.raw_T)
+
+        assert run(1) == run(4)
+
+    def test_budget_exhausted(self) -> None:
+        rule = _queue_sim_cpp.StoppingRule(rel_half_width=1e-6)
+        raw = _make_mm1_cpp().replicate(n_replications=23, num_events=2_000,
+                                        seed=1, stopping_rule=rule)
+        assert not raw.converged
+        assert len(raw.raw_T) == 23
+
+    def test_progress_reports_budget(self) -> None:
+        calls = []
+        rule = _queue_sim_cpp.StoppingRule(rel_half_width=1e-6,
+                                           min_replications=4, wave_size=3)
+        sys = _make_mm1_cpp()
+        sys.replicate(n_replications=10, num_events=1_000, seed=1,
+                      stopping_rule=rule,
+                      progress=lambda done, total: calls.append((done, total)))
+        assert calls[-1] == (10, 10)
+        assert all(total == 10 for _, total in calls)
+
+    @pytest.mark.parametrize("kwargs", [
+        dict(rel_half_width=0.0),
+        dict(confidence=1.0),
+        dict(min_replications=1),
+        dict(wave_size=0),
+    ])
+    def test_invalid_rule(self, kwargs) -> None:
+        with pytest.raises(ValueError):
+            _queue_sim_cpp.StoppingRule(**kwargs)
@@ -2,6 +2,7 @@
 
 import statistics
 
+import numpy as np
 import pytest
 
 _queue_sim_cpp = pytest.importorskip("_queue_sim_cpp")
@@ -153,3 +154,147 @@ class TestDeterminism:
         system2.sim(num_events=1000, seed=42, track_response_times=True)
 
         assert list(system1.response_times) == list(system2.response_times)
+
+
+class TestZeroCopyExport:
+    """response_times is a NumPy view of C++ memory, not a copy."""
+
+    def test_float64_array(self):
+        system = _make_system(_queue_sim_cpp.FCFS)
+        system.sim(num_events=1000, seed=42, track_response_times=True)
+        rt = system.response_times
+        assert isinstance(rt, np.ndarray)
+        assert rt.dtype == np.float64
+        assert not rt.flags.writeable
+
+    def test_repeated_access_shares_memory(self):
+        system = _make_system(_queue_sim_cpp.FCFS)
+        system.sim(num_events=1000, seed=42, track_response_times=True)
+        assert np.shares_memory(system.response_times, system.response_times)
+
+    def test_view_outlives_next_run_and_system(self):
+        system = _make_system(_queue_sim_cpp.FCFS)
+        system.sim(num_events=1000, seed=42, track_response_times=True)
+        rt = system.response_times
+        snapshot = rt.copy()
+        system.sim(num_events=1000, seed=7, track_response_times=True)
+        del system
+        assert np.array_equal(rt, snapshot)
+
+    def test_replicate_arrays(self):
+        system = _make_system(_queue_sim_cpp.FCFS)
+        raw = system.replicate(n_replications=3, num_events=1000, seed=1,
+                               n_threads=2, track_response_times=True)
+        assert all(isinstance(r, np.ndarray) and len(r) == 1000
+                   for r in raw.response_times)
+
+
+class TestResponseTimesOut:
+    """sim(response_times_out=buf) fills a caller-owned buffer in place."""
+
+    def test_fills_buffer(self):
+        buf = np.zeros(1500)
+        system = _make_system(_queue_sim_cpp.FCFS)
+        system.sim(num_events=1000, seed=42, response_times_out=buf)
+        rt = system.response_times
+        assert len(rt) == 1000
+        assert np.shares_memory(rt, buf)
+        assert (buf[:1000] > 0).all()
+        assert (buf[1000:] == 0).all()
+
+    def test_matches_tracked_run(self):
+        buf = np.empty(1000)
+        a = _make_system(_queue_sim_cpp.FCFS)
+        a.sim(num_events=1000, seed=42, response_times_out=buf)
+        b = _make_system(_queue_sim_cpp.FCFS)
+        b.sim(num_events=1000, seed=42, track_response_times=True)
+        assert list(buf) == list(b.response_times)
+
+    @pytest.mark.parametrize("make", [
+        lambda np: np.empty(999),                       # too short
+        lambda np: np.empty(1000, dtype=np.float32),     # wrong dtype
+        lambda np: np.empty(2000)[::2],                  # not contiguous
+        lambda np: np.empty((10, 100)),                  # not 1-D
+    ])
+    def test_rejects_bad_buffer(self, make):
+        system = _make_system(_queue_sim_cpp.FCFS)
+        with pytest.raises(ValueError):
+            system.sim(num_events=1000, seed=42, response_times_out=make(np))
+
+    def test_rejects_read_only_and_non_array(self):
+        system = _make_system(_queue_sim_cpp.FCFS)
+        ro = np.empty(1000)
+        ro.flags.writeable = False
+        with pytest.raises(ValueError):
+            system.sim(num_events=1000, seed=42, response_times_out=ro)
+        with pytest.raises(TypeError):
+            system.sim(num_events=1000, seed=42, response_times_out=[0.0] * 1000)
+
+
+class TestEndToEndSojourn:
+    """Networks record each job's sojourn since entry, not its last visit."""
+
+    @pytest.mark.parametrize("policy_cls", [
+        _queue_sim_cpp.FCFS, _queue_sim_cpp.PS,
+        _queue_sim_cpp.FB, _queue_sim_cpp.SRPT,
+    ])
+    def test_tandem_mean_matches_T(self, policy_cls):
+        servers = [policy_cls(_queue_sim_cpp.ExponentialDist(2.0))
+                   for _ in range(3)]
+        system = _queue_sim_cpp.QueueSystem(
+            servers, _queue_sim_cpp.ExponentialDist(1.0))
+        system.track_visits = True
+        _, T = system.sim(num_events=NUM_EVENTS, seed=3, warmup=5_000,
+                          track_response_times=True)
+        assert np.mean(system.response_times) == pytest.approx(T, rel=0.01)
+        assert (np.asarray(system.visit_counts) == 3).all()
+
+    def test_feedback_visits(self):
+        system = _queue_sim_cpp.QueueSystem(
+            [_queue_sim_cpp.FCFS(_queue_sim_cpp.ExponentialDist(4.0)),
+             _queue_sim_cpp.FCFS(_queue_sim_cpp.ExponentialDist(4.0))],
+            _queue_sim_cpp.ExponentialDist(1.0),
+            [[0.0, 0.5, 0.5], [0.2, 0.0, 0.8]],
+        )
+        system.track_visits = True
+        _, T = system.sim(num_events=200_000, seed=4, warmup=5_000,
+                          track_response_times=True,
+                          sketch_response_times=True)
+        visits = np.asarray(system.visit_counts)
+        assert len(visits) == len(system.response_times)
+        assert visits.min() >= 1
+        # Expected visits: v0 = 1 + 0.2 v1, v1 = 0.5 v0  =>  v0 + v1 = 5/3.
+        assert visits.mean() == pytest.approx(5 / 3, rel=0.02)
+        assert np.mean(system.response_times) == pytest.approx(T, rel=0.01)
+        assert system.sketch.end_to_end.mean == pytest.approx(
+            np.mean(system.response_times), rel=1e-9)
+
+    def test_single_station_unchanged(self):
+        system = _make_system(_queue_sim_cpp.FCFS)
+        system.track_visits = True
+        system.sim(num_events=10_000, seed=1, track_response_times=True)
+        assert (np.asarray(system.visit_counts) == 1).all()
+
+    def test_visits_only_on_request(self):
+        system = _make_system(_queue_sim_cpp.FCFS)
+        system.sim(num_events=1000, seed=1, track_response_times=True)
+        assert system.visit_counts is None
+        buf = np.empty(1000)
+        system.sim(num_events=1000, seed=1, response_times_out=buf)
+        assert system.visit_counts is None
+        system.track_visits = True
+        system.sim(num_events=1000, seed=1, response_times_out=buf)
+        assert (np.asarray(system.visit_counts) == 1).all()
+
+    def test_replicate_visit_counts(self):
+        servers = [_queue_sim_cpp.PS(_queue_sim_cpp.ExponentialDist(3.0))
+                   for _ in range(2)]
+        system = _queue_sim_cpp.QueueSystem(
+            servers, _queue_sim_cpp.ExponentialDist(1.0))
+        system.track_visits = True
+        raw = system.replicate(n_replications=3, num_events=5_000, seed=2,
+                               track_response_times=True)
+        assert len(raw.visit_counts) == 3
+        for rts, visits in zip(raw.response_times, raw.visit_counts):
+            assert len(visits) == len(rts) == 5_000
+            assert (np.asarray(visits) == 2).all()
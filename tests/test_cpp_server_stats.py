@@ -0,0 +1,86 @@
+"""Tests for per-server statistics accumulated in the C++ event loop."""
+
+import numpy as np
+import pytest
+
+_queue_sim_cpp = pytest.importorskip("_queue_sim_cpp")
+
+from queue_sim.event_log import per_server_states  # noqa: E402
+
+
+def _make_network():
+    """PS -> 2-channel FCFS with feedback."""
+    return _queue_sim_cpp.QueueSystem(
+        [_queue_sim_cpp.PS(_queue_sim_cpp.ExponentialDist(3.0)),
+         _queue_sim_cpp.FCFS(_queue_sim_cpp.ExponentialDist(3.0), num_servers=2)],
+        _queue_sim_cpp.ExponentialDist(1.0),
+        [[0.0, 0.5, 0.5], [0.2, 0.0, 0.8]],
+    )
+
+
+class TestServerStats:
+
+    def test_mm1_matches_theory(self) -> None:
+        lam, mu = 0.7, 1.0
+        rho = lam / mu
+        server = _queue_sim_cpp.FCFS(_queue_sim_cpp.ExponentialDist(mu))
+        sys = _queue_sim_cpp.QueueSystem([server],
+                                         _queue_sim_cpp.ExponentialDist(lam))
+        N, T = sys.sim(num_events=500_000, seed=42, warmup=10_000)
+        stats = sys.servers[0].stats
+        assert stats.utilization == pytest.approx(rho, rel=0.03)
+        assert stats.mean_state == pytest.approx(rho / (1 - rho), rel=0.05)
+        assert stats.mean_response_time == pytest.approx(1 / (mu - lam), rel=0.05)
+        # A single station is the whole system.
+        assert stats.mean_state == pytest.approx(N, rel=1e-9)
+        assert stats.completions == 500_000
+
+    @pytest.mark.parametrize("use_specialized", [True, False])
+    def test_matches_event_log(self, use_specialized: bool) -> None:
+        sys = _make_network()
+        sys.use_specialized = use_specialized
+        sys.sim(num_events=50_000, seed=3, track_events=True)
+        recon = per_server_states(sys.event_log, n_servers=2)
+        times = np.asarray(recon["times"])
+        dt = np.diff(times, append=times[-1])
+        for s, server in enumerate(sys.servers):
+            states = np.asarray(recon["server_states"][s])
+            stats = server.stats
+            assert stats.duration == pytest.approx(times[-1])
+            assert stats.area == pytest.approx(float(np.sum(states * dt)), rel=1e-9)
+            busy = np.minimum(states, server.num_servers)
+            assert stats.busy_time == pytest.approx(float(np.sum(busy * dt)), rel=1e-9)
+            assert stats.max_state == states.max()
+
+    def test_littles_law_per_node(self) -> None:
+        sys = _make_network()
+        sys.sim(num_events=100_000, seed=8, warmup=5_000)
+        for server in sys.servers:
+            stats = server.stats
+            throughput = stats.completions / stats.duration
+            assert stats.mean_state == pytest.approx(
+                throughput * stats.mean_response_time, rel=0.02)
+
+    def test_reset_at_measurement_start(self) -> None:
+        sys = _make_network()
+        sys.sim(num_events=10_000, seed=1, warmup=50_000)
+        stats = sys.servers[0].stats
+        assert stats.completions < 30_000
+
+    def test_stats_do_not_change_results(self) -> None:
+        def run(use_specialized):
+            sys = _make_network()
+            sys.use_specialized = use_specialized
+            return sys.sim(num_events=20_000, seed=5)
+
+        assert run(True) == run(False)
+
+    def test_replicate_per_replication(self) -> None:
+        sys = _make_network()
+        raw = sys.replicate(n_replications=4, num_events=20_000, seed=5,
+                            n_threads=2)
+        assert len(raw.server_stats) == 4
+        assert all(len(per_rep) == 2 for per_rep in raw.server_stats)
+        one = sys.replicate(n_replications=1, num_events=20_000, seed=5)
+        assert raw.server_stats[0][1].area == one.server_stats[0][1].area
+        assert raw.server_stats[0][1].max_state == one.server_stats[0][1].max_state
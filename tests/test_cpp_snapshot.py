@@ -0,0 +1,109 @@
+"""Tests for C++ snapshots: warm up once, resume, fork and serialize runs."""
+
+import copy
+import random
+
+import pytest
+
+_queue_sim_cpp = pytest.importorskip("_queue_sim_cpp")
+
+
+def _network():
+    return _queue_sim_cpp.QueueSystem(
+        [_queue_sim_cpp.PS(_queue_sim_cpp.BoundedParetoDist(0.3, 100, 1.5), 2),
+         _queue_sim_cpp.SRPT(_queue_sim_cpp.UniformDist(0.1, 1.0), buffer_capacity=8)],
+        _queue_sim_cpp.ExponentialDist(0.5), [[0, 0.6, 0.4], [0.3, 0, 0.7]])
+
+
+def _fcfs_fb():
+    return _queue_sim_cpp.QueueSystem(
+        [_queue_sim_cpp.FCFS(_queue_sim_cpp.ExponentialDist(3.0), num_servers=2),
+         _queue_sim_cpp.FB(_queue_sim_cpp.ErlangDist(2, 2.0))],
+        _queue_sim_cpp.ExponentialDist(0.7))
+
+
+class TestSnapshot:
+
+    @pytest.mark.parametrize("make", [_network, _fcfs_fb])
+    def test_warm_up_then_sim_equals_sim(self, make) -> None:
+        expected = make()
+        ref = expected.sim(num_events=50_000, seed=11, warmup=2_000)
+        sys = make()
+        snap = sys.warm_up(warmup=2_000, seed=11)
+        assert snap.warmup_done >= 2_000 and not snap.measuring
+        assert sys.sim_from(snap, num_events=50_000) == ref
+        for mine, theirs in zip(sys.servers, expected.servers):
+            assert mine.stats.area == theirs.stats.area
+            assert mine.num_rejected == theirs.num_rejected
+
+    @pytest.mark.parametrize("rng_kind", list(_queue_sim_cpp.RngKind.__members__.values()))
+    def test_resume_from_bytes(self, rng_kind) -> None:
+        sys = _network()
+        sys.rng_kind = rng_kind
+        ref = sys.sim(num_events=60_000, seed=4, warmup=1_000)
+        snap = sys.warm_up(warmup=1_000, seed=4)
+        # Preempted twice; each resume starts from the saved bytes.
+        for target in (20_000, 40_000):
+            sys.sim_from(snap, num_events=target)
+            snap = sys.load_snapshot(snap.to_bytes())
+        assert snap.measuring and snap.completions >= 40_000
+        assert sys.sim_from(snap, num_events=60_000) == ref
+
+    def test_copies_are_independent(self) -> None:
+        sys = _fcfs_fb()
+        snap = sys.warm_up(warmup=5_000, seed=2)
+        fork = copy.copy(snap)
+        first = sys.sim_from(fork, num_events=10_000)
+        assert not snap.measuring and snap.now < fork.now
+        assert sys.sim_from(copy.copy(snap), num_events=10_000) == first
+
+    @pytest.mark.parametrize("n_threads", [1, 3])
+    def test_replicate_from(self, n_threads: int) -> None:
+        sys = _queue_sim_cpp.QueueSystem(
+            [_queue_sim_cpp.FCFS(_queue_sim_cpp.ExponentialDist(1.0))],
+            _queue_sim_cpp.ExponentialDist(0.7))
+        snap = sys.warm_up(warmup=20_000, seed=3)
+        raw = sys.replicate_from(snap, n_replications=8, num_events=100_000,
+                                 seed=5, n_threads=n_threads)
+        assert len(raw.raw_T) == 8 and len(set(raw.raw_T)) == 8
+        assert sum(raw.raw_T) / 8 == pytest.approx(1 / 0.3, rel=0.05)
+        serial = sys.replicate_from(snap, n_replications=8, num_events=100_000,
+                                    seed=5, n_threads=1)
+        assert list(raw.raw_T) == list(serial.raw_T)
+        assert len(raw.server_stats) == 8
+        # The snapshot itself is not advanced.
+        assert not snap.measuring
+
+    def test_bad_snapshots(self) -> None:
+        data = _fcfs_fb().warm_up(warmup=100, seed=1).to_bytes()
+        with pytest.raises(ValueError, match="truncated"):
+            _fcfs_fb().load_snapshot(data[:-5])
+        with pytest.raises(ValueError, match="not a queue_sim snapshot"):
+            _fcfs_fb().load_snapshot(b"x" * 64)
+        with pytest.raises(ValueError, match="FCFS server where this system has PS"):
+            _network().load_snapshot(data)
+        mm1 = _queue_sim_cpp.QueueSystem(
+            [_queue_sim_cpp.FCFS(_queue_sim_cpp.ExponentialDist(1.0))],
+            _queue_sim_cpp.ExponentialDist(0.5))
+        mm1.common_random_numbers = True
+        with pytest.raises(ValueError, match="common_random_numbers"):
+            mm1.warm_up(warmup=10)
+
+    @pytest.mark.parametrize("make", [_network, _fcfs_fb])
+    def test_bit_flipped_snapshots(self, make) -> None:
+        sys = make()
+        data = sys.warm_up(warmup=2_000, seed=3).to_bytes()
+        rng = random.Random(7)
+        rejected = 0
+        for _ in range(300):
+            bad = bytearray(data)
+            pos = rng.randrange(len(bad))
+            bad[pos] ^= 1 << rng.randrange(8)
+            try:
+                snap = sys.load_snapshot(bytes(bad))
+            except ValueError:
+                rejected += 1
+                continue
+            # A flipped time or size may load; it must still run.
+            sys.sim_from(snap, num_events=200)
+        assert rejected > 0
@@ -0,0 +1,105 @@
+"""Tests for the C++ rare-event (multilevel splitting) loss estimator."""
+
+import math
+
+import pytest
+
+_queue_sim_cpp = pytest.importorskip("_queue_sim_cpp")
+
+
+def _mm1k(lam, K):
+    return _queue_sim_cpp.QueueSystem(
+        [_queue_sim_cpp.FCFS(_queue_sim_cpp.ExponentialDist(1.0),
+                             buffer_capacity=K)],
+        _queue_sim_cpp.ExponentialDist(lam))
+
+
+def _mm1k_loss(rho, K):
+    return (1 - rho) * rho**K / (1 - rho**(K + 1))
+
+
+def _erlang_b(c, a):
+    b = 1.0
+    for k in range(1, c + 1):
+        b = a * b / (k + a * b)
+    return b
+
+
+class TestSplitting:
+
+    def test_mm1k_rare_loss(self) -> None:
+        # ~1.5e-8: hopeless for crude simulation at this event budget.
+        res = _mm1k(0.5, 25).estimate_loss(n_runs=10, seed=1)
+        exact = _mm1k_loss(0.5, 25)
+        assert res.loss_probability == pytest.approx(exact, rel=0.2)
+        assert abs(res.loss_probability - exact) < 2 * res.half_width
+        assert res.events < 2e7
+        assert res.levels == list(range(2, 26))
+        assert res.arrivals_per_cycle == pytest.approx(2.0, rel=0.05)
+
+    def test_single_slot_has_no_levels(self) -> None:
+        # M/M/1/1: the default levels are empty, so stage 0 counts it all.
+        res = _mm1k(0.5, 1).estimate_loss(n_runs=10, seed=1)
+        exact = _mm1k_loss(0.5, 1)
+        assert res.levels == []
+        assert res.loss_probability == pytest.approx(exact, rel=0.05)
+
+    def test_erlang_b(self) -> None:
+        system = _queue_sim_cpp.QueueSystem(
+            [_queue_sim_cpp.FCFS(_queue_sim_cpp.ExponentialDist(1.0),
+                                 num_servers=10, buffer_capacity=10)],
+            _queue_sim_cpp.ExponentialDist(2.0))
+        rule = _queue_sim_cpp.SplittingRule(effort=4000)
+        res = system.estimate_loss(rule, n_runs=10, seed=3)
+        assert res.loss_probability == pytest.approx(_erlang_b(10, 2.0), rel=0.25)
+
+    def test_no_levels_is_crude_monte_carlo(self) -> None:
+        system = _mm1k(0.8, 5)
+        rule = _queue_sim_cpp.SplittingRule(levels=[100], n_cycles=50_000)
+        crude = system.estimate_loss(rule, n_runs=8, seed=2)
+        split = system.estimate_loss(n_runs=8, seed=2)
+        exact = _mm1k_loss(0.8, 5)
+        assert crude.loss_probability == pytest.approx(exact, rel=0.03)
+        assert split.loss_probability == pytest.approx(exact, rel=0.1)
+        assert crude.level_probabilities == [0.0]
+
+    def test_network_matches_crude_simulation(self) -> None:
+        def make():
+            return _queue_sim_cpp.QueueSystem(
+                [_queue_sim_cpp.FCFS(_queue_sim_cpp.ExponentialDist(2.0),
+                                     buffer_capacity=6),
+                 _queue_sim_cpp.SRPT(_queue_sim_cpp.UniformDist(0.2, 0.8),
+                                     buffer_capacity=4)],
+                _queue_sim_cpp.ExponentialDist(1.0), [[0, 0.7, 0.3], [0.2, 0, 0.8]])
+
+        res = make().estimate_loss(n_runs=10, seed=4)
+        crude = make()
+        crude.use_specialized = False
+        crude.sim(num_events=2_000_000, seed=9, track_events=True)
+        log = crude.event_log
+        external = sum(1 for f, k in zip(log.from_servers, log.kinds)
+                       if f == _queue_sim_cpp.EventLog.EXTERNAL)
+        lost = sum(s.num_rejected for s in crude.servers)
+        assert res.loss_probability == pytest.approx(lost / external, rel=0.1)
+
+    def test_thread_invariant(self) -> None:
+        system = _mm1k(0.5, 12)
+        one = system.estimate_loss(n_runs=4, seed=5, n_threads=1)
+        many = system.estimate_loss(n_runs=4, seed=5, n_threads=3)
+        assert one.raw == many.raw
+        assert math.isnan(system.estimate_loss(n_runs=1, seed=5).half_width)
+
+    def test_bad_arguments(self) -> None:
+        unlimited = _queue_sim_cpp.QueueSystem(
+            [_queue_sim_cpp.FCFS(_queue_sim_cpp.ExponentialDist(1.0))],
+            _queue_sim_cpp.ExponentialDist(0.5))
+        with pytest.raises(ValueError, match="levels"):
+            unlimited.estimate_loss()
+        with pytest.raises(ValueError):
+            _queue_sim_cpp.SplittingRule(levels=[3, 2])
+        with pytest.raises(ValueError):
+            _queue_sim_cpp.SplittingRule(effort=0)
+        system = _mm1k(0.5, 5)
+        system.classes = [_queue_sim_cpp.TrafficClass(_queue_sim_cpp.ExponentialDist(0.5))]
+        with pytest.raises(ValueError, match="single-class"):
+            system.estimate_loss()
@@ -0,0 +1,107 @@
+"""Tests for the C++ backend sweep() over a grid of systems."""
+
+import numpy as np
+import pytest
+
+_queue_sim_cpp = pytest.importorskip("_queue_sim_cpp")
+
+
+def _grid():
+    """FCFS, PS and a mixed-policy tandem at three load levels."""
+    systems = []
+    for lam in (0.5, 0.7, 0.9):
+        systems.append(_queue_sim_cpp.QueueSystem(
+            [_queue_sim_cpp.FCFS(_queue_sim_cpp.ExponentialDist(1.0))],
+            _queue_sim_cpp.ExponentialDist(lam),
+        ))
+        systems.append(_queue_sim_cpp.QueueSystem(
+            [_queue_sim_cpp.PS(_queue_sim_cpp.BoundedParetoDist(0.3, 1000.0, 1.5))],
+            _queue_sim_cpp.ExponentialDist(lam),
+        ))
+        systems.append(_queue_sim_cpp.QueueSystem(
+            [_queue_sim_cpp.PS(_queue_sim_cpp.ExponentialDist(3.0)),
+             _queue_sim_cpp.FCFS(_queue_sim_cpp.ExponentialDist(3.0))],
+            _queue_sim_cpp.ExponentialDist(lam),
+        ))
+    return systems
+
+
+class TestSweep:
+
+    def test_structured_result(self) -> None:
+        systems = _grid()
+        rows = _queue_sim_cpp.sweep(systems, n_replications=4,
+                                    num_events=10_000, seed=1)
+        assert isinstance(rows, np.ndarray)
+        assert rows.dtype.names == (
+            "config", "replication", "seed", "mean_N", "mean_T")
+        assert len(rows) == len(systems) * 4
+        assert list(rows["config"]) == [c for c in range(len(systems))
+                                         for _ in range(4)]
+        assert list(rows["replication"]) == list(range(4)) * len(systems)
+
+    @pytest.mark.parametrize("n_threads", [1, 3])
+    def test_matches_replicate(self, n_threads: int) -> None:
+        systems = _grid()
+        rows = _queue_sim_cpp.sweep(systems, n_replications=5,
+                                    num_events=20_000, seed=11, warmup=500,
+                                    n_threads=n_threads)
+        for c, system in enumerate(systems):
+            raw = system.replicate(n_replications=5, num_events=20_000,
+                                   seed=11, warmup=500)
+            mine = rows[rows["config"] == c]
+            assert list(mine["mean_N"]) == list(raw.raw_N)
+            assert list(mine["mean_T"]) == list(raw.raw_T)
+
+    def test_common_random_numbers(self) -> None:
+        rows = _queue_sim_cpp.sweep(_grid(), n_replications=3,
+                                    num_events=1_000, seed=5)
+        seeds = rows["seed"].reshape(-1, 3)
+        assert (seeds == seeds[0]).all()
+        assert len(set(seeds[0])) == 3
+
+    def test_load_ordering(self) -> None:
+        systems = [
+            _queue_sim_cpp.QueueSystem(
+                [_queue_sim_cpp.FCFS(_queue_sim_cpp.ExponentialDist(1.0))],
+                _queue_sim_cpp.ExponentialDist(lam),
+            )
+            for lam in (0.3, 0.6, 0.9)
+        ]
+        rows = _queue_sim_cpp.sweep(systems, n_replications=5,
+                                    num_events=50_000, seed=2)
+        means = [rows["mean_T"][rows["config"] == c].mean() for c in range(3)]
+        assert means[0] < means[1] < means[2]
+
+    def test_systems_left_untouched(self) -> None:
+        system = _grid()[0]
+        _queue_sim_cpp.sweep([system], n_replications=2, num_events=5_000,
+                             seed=3)
+        assert system.T == 0.0
+
+    def test_progress_counts_runs(self) -> None:
+        calls = []
+        _queue_sim_cpp.sweep(_grid()[:2], n_replications=3, num_events=2_000,
+                             seed=1, progress=lambda d, t: calls.append((d, t)))
+        assert calls[-1] == (6, 6)
+
+    def test_progress_exception_propagates(self) -> None:
+        def stop(done, total):
+            raise KeyboardInterrupt
+
+        with pytest.raises(KeyboardInterrupt):
+            _queue_sim_cpp.sweep(_grid(), n_replications=3,
+                                 num_events=5_000, seed=1, progress=stop)
+
+    def test_bad_transition_matrix(self) -> None:
+        bad = _queue_sim_cpp.QueueSystem(
+            [_queue_sim_cpp.FCFS(_queue_sim_cpp.ExponentialDist(2.0))],
+            _queue_sim_cpp.ExponentialDist(1.0),
+            [[0.5, 0.4]],
+        )
+        with pytest.raises(ValueError):
+            _queue_sim_cpp.sweep([bad], n_replications=1, num_events=100)
+
+    def test_empty_grid(self) -> None:
+        rows = _queue_sim_cpp.sweep([], n_replications=3, num_events=100)
+        assert len(rows) == 0
@@ -34,6 +34,24 @@ class TestSeedReproducibility:
         r2 = make_system().sim(num_events=100_000, seed=2)
         assert r1 != r2
 
+    @pytest.mark.parametrize("make_server", [
+        lambda: _queue_sim_cpp.FCFS(_queue_sim_cpp.ExponentialDist(2.0)),
+        lambda: _queue_sim_cpp.FCFS(_queue_sim_cpp.ExponentialDist(0.6), num_servers=3),
+        lambda: _queue_sim_cpp.SRPT(_queue_sim_cpp.ExponentialDist(2.0)),
+        lambda: _queue_sim_cpp.PS(_queue_sim_cpp.ExponentialDist(2.0)),
+        lambda: _queue_sim_cpp.FB(_queue_sim_cpp.ExponentialDist(2.0)),
+    ])
+    def test_rerun_reuses_job_storage(self, make_server) -> None:
+        """A system's job arena carries over between runs without leaking state."""
+        servers = [make_server(), make_server()]
+        system = _queue_sim_cpp.QueueSystem(
+            servers, _queue_sim_cpp.ExponentialDist(1.0),
+            [[0, 0.5, 0.5], [0.3, 0, 0.7]],
+        )
+        first = system.sim(num_events=20_000, seed=7)
+        system.sim(num_events=50_000, seed=8)
+        assert system.sim(num_events=20_000, seed=7) == first
+
 
 class TestTransitionMatrix:
     """Transition matrix validation."""
@@ -59,6 +77,44 @@ class TestTransitionMatrix:
             system.sim(num_events=100, seed=1)
 
 
+    def test_routing_frequencies_match_matrix(self) -> None:
+        """Server 0 splits 0.2 / 0.5 / 0.3 between servers 1, 2 and exit."""
+        servers = [
+            _queue_sim_cpp.FCFS(_queue_sim_cpp.ExponentialDist(10.0))
+            for _ in range(3)
+        ]
+        system = _queue_sim_cpp.QueueSystem(
+            servers,
+            _queue_sim_cpp.ExponentialDist(1.0),
+            transitionMatrix=[
+                [0.0, 0.2, 0.5, 0.3],
+                [0.0, 0.0, 0.0, 1.0],
+                [0.0, 0.0, 0.0, 1.0],
+            ],
+        )
+        system.sim(num_events=200_000, seed=4)
+        routed = servers[0].num_completions
+        assert servers[1].num_arrivals / routed == pytest.approx(0.2, abs=0.005)
+        assert servers[2].num_arrivals / routed == pytest.approx(0.5, abs=0.005)
+
+    def test_zero_probability_destination_never_used(self) -> None:
+        servers = [
+            _queue_sim_cpp.FCFS(_queue_sim_cpp.ExponentialDist(10.0))
+            for _ in range(3)
+        ]
+        system = _queue_sim_cpp.QueueSystem(
+            servers,
+            _queue_sim_cpp.ExponentialDist(1.0),
+            transitionMatrix=[
+                [0.0, 0.0, 0.6, 0.4],
+                [0.0, 0.0, 0.0, 1.0],
+                [0.0, 0.0, 0.0, 1.0],
+            ],
+        )
+        system.sim(num_events=50_000, seed=4)
+        assert servers[1].num_arrivals == 0
+
+
 class TestTandemNetwork:
     """Two-server tandem queue (no transition matrix)."""
 
@@ -86,6 +142,22 @@ class TestSRPT:
         # M/M/1 FCFS E[T] = 1/(mu - lam) = 1.0
         assert T < 1.1  # allow some slack
 
+    @pytest.mark.parametrize("specialized", [True, False])
+    def test_equal_sizes_served_in_arrival_order(self, specialized: bool) -> None:
+        """With deterministic sizes no job preempts another, and waiting
+        jobs (all of the same remaining size) go first-come first-served:
+        every job's response time equals FCFS's."""
+        runs = []
+        for policy in (_queue_sim_cpp.FCFS, _queue_sim_cpp.SRPT):
+            system = _queue_sim_cpp.QueueSystem(
+                [policy(_queue_sim_cpp.DeterministicDist(1.0))],
+                _queue_sim_cpp.ExponentialDist(0.9),
+            )
+            system.use_specialized = specialized
+            system.sim(num_events=20_000, seed=3, track_response_times=True)
+            runs.append(list(system.response_times))
+        assert runs[0] == runs[1]
+
 
 class TestPS:
     """PS policy smoke tests."""
@@ -134,6 +206,30 @@ class TestFB:
         r2 = make().sim(num_events=10_000, seed=42)
         assert r1 == r2
 
+    def test_fb_beats_ps_for_heavy_tails(self) -> None:
+        """FB favours short jobs, so it beats PS under decreasing hazard."""
+        def run(policy_cls):
+            server = policy_cls(
+                _queue_sim_cpp.BoundedParetoDist(0.1, 1000.0, 1.2)
+            )
+            system = _queue_sim_cpp.QueueSystem(
+                [server], _queue_sim_cpp.ExponentialDist(1.6)
+            )
+            return system.sim(num_events=100_000, seed=42)[1]
+
+        assert run(_queue_sim_cpp.FB) < run(_queue_sim_cpp.PS)
+
+    def test_fb_deterministic_sizes(self) -> None:
+        """Deterministic sizes exercise level merges: no job may finish
+        faster than its size, and a job served alone takes exactly 1."""
+        server = _queue_sim_cpp.FB(_queue_sim_cpp.UniformDist(1.0, 1.0))
+        system = _queue_sim_cpp.QueueSystem(
+            [server], _queue_sim_cpp.ExponentialDist(0.5)
+        )
+        N, T = system.sim(num_events=50_000, seed=42, track_response_times=True)
+        assert server.num_completions > 0
+        assert min(system.response_times) == pytest.approx(1.0, abs=1e-9)
+
 
 class TestMultiServer:
 
@@ -216,6 +312,32 @@ class TestDistributions:
         with pytest.raises(TypeError):
             _queue_sim_cpp.FCFS("not_a_distribution")
 
+    @pytest.mark.parametrize("make", [
+        lambda: _queue_sim_cpp.HyperExponentialDist(1.5, 1.0, 2.0),
+        lambda: _queue_sim_cpp.ErlangDist(0, 1.0),
+        lambda: _queue_sim_cpp.LognormalDist(0.0, -1.0),
+        lambda: _queue_sim_cpp.WeibullDist(0.0),
+        lambda: _queue_sim_cpp.DeterministicDist(-1.0),
+    ])
+    def test_invalid_parameters_raise(self, make) -> None:
+        with pytest.raises(ValueError):
+            make()
+
+    def test_every_family_accepted_everywhere(self) -> None:
+        dists = [
+            _queue_sim_cpp.HyperExponentialDist(0.5, 1.0, 3.0),
+            _queue_sim_cpp.ErlangDist(2, 4.0),
+            _queue_sim_cpp.LognormalDist(-1.0, 0.5),
+            _queue_sim_cpp.WeibullDist(2.0, 0.5),
+            _queue_sim_cpp.DeterministicDist(0.5),
+        ]
+        for d in dists:
+            servers = [_queue_sim_cpp.FCFS(d), _queue_sim_cpp.SRPT(d),
+                       _queue_sim_cpp.PS(d), _queue_sim_cpp.FB(d)]
+            system = _queue_sim_cpp.QueueSystem(servers, d)
+            N, T = system.sim(num_events=2_000, seed=1)
+            assert T > 0
+
 
 class TestFiniteBufferCpp:
 
@@ -321,3 +443,161 @@ class TestFiniteBufferCpp:
             _queue_sim_cpp.ExponentialDist(2.0), buffer_capacity=10
         )
         assert server.buffer_capacity == 10
+
+
+class TestSpecializedEngine:
+    """Homogeneous systems run on the devirtualized engine; results must be
+    bit-identical to the generic (virtual-dispatch) fallback."""
+
+    DISTS = [
+        lambda: _queue_sim_cpp.ExponentialDist(2.0),
+        lambda: _queue_sim_cpp.UniformDist(0.2, 0.8),
+        lambda: _queue_sim_cpp.BoundedParetoDist(0.2, 20.0, 1.5),
+    ]
+
+    @staticmethod
+    def _run(policy_cls, make_dist, use_specialized, **kwargs):
+        servers = [policy_cls(make_dist(), **kwargs) for _ in range(2)]
+        system = _queue_sim_cpp.QueueSystem(
+            servers, _queue_sim_cpp.ExponentialDist(1.0)
+        )
+        system.use_specialized = use_specialized
+        result = system.sim(num_events=20_000, seed=7, warmup=500)
+        return result, [(s.num_completions, s.num_arrivals, s.T) for s in servers]
+
+    @pytest.mark.parametrize("policy_cls", [
+        _queue_sim_cpp.FCFS, _queue_sim_cpp.SRPT,
+        _queue_sim_cpp.PS, _queue_sim_cpp.FB,
+    ])
+    @pytest.mark.parametrize("dist_idx", [0, 1, 2])
+    def test_matches_generic(self, policy_cls, dist_idx) -> None:
+        make_dist = self.DISTS[dist_idx]
+        fast = self._run(policy_cls, make_dist, True)
+        generic = self._run(policy_cls, make_dist, False)
+        assert fast == generic
+
+    def test_multiserver_with_buffer_matches_generic(self) -> None:
+        def run(use_specialized):
+            server = _queue_sim_cpp.FCFS(
+                _queue_sim_cpp.ExponentialDist(1.0),
+                num_servers=3,
+                buffer_capacity=5,
+            )
+            system = _queue_sim_cpp.QueueSystem(
+                [server], _queue_sim_cpp.ExponentialDist(2.5)
+            )
+            system.use_specialized = use_specialized
+            return system.sim(num_events=20_000, seed=3), server.num_rejected
+
+        assert run(True) == run(False)
+        assert run(True)[1] > 0
+
+    def test_replicate_matches_generic(self) -> None:
+        def run(use_specialized):
+            server = _queue_sim_cpp.SRPT(_queue_sim_cpp.UniformDist(0.1, 0.9))
+            system = _queue_sim_cpp.QueueSystem(
+                [server], _queue_sim_cpp.ExponentialDist(1.0)
+            )
+            system.use_specialized = use_specialized
+            raw = system.replicate(n_replications=4, num_events=5_000, seed=11)
+            return list(raw.raw_N), list(raw.raw_T)
+
+        assert run(True) == run(False)
+
+    def test_heterogeneous_network_falls_back(self) -> None:
+        """Mixed policies use the generic engine and still run."""
+        s0 = _queue_sim_cpp.PS(_queue_sim_cpp.ExponentialDist(4.0))
+        s1 = _queue_sim_cpp.FCFS(_queue_sim_cpp.UniformDist(0.1, 0.3))
+        system = _queue_sim_cpp.QueueSystem(
+            [s0, s1], _queue_sim_cpp.ExponentialDist(1.0)
+        )
+        N, T = system.sim(num_events=20_000, seed=42)
+        assert N > 0
+        assert T > 0
+        assert s1.num_completions > 0
+
+
+class TestRngKind:
+    """Selectable generators: deterministic per kind, statistically sound."""
+
+    KINDS = [
+        _queue_sim_cpp.RngKind.MT19937_64,
+        _queue_sim_cpp.RngKind.XOSHIRO256PP,
+        _queue_sim_cpp.RngKind.PCG64,
+    ]
+
+    @staticmethod
+    def _system(rng_kind=None):
+        server = _queue_sim_cpp.FCFS(_queue_sim_cpp.ExponentialDist(2.0))
+        if rng_kind is None:
+            return _queue_sim_cpp.QueueSystem(
+                [server], _queue_sim_cpp.ExponentialDist(1.0)
+            )
+        return _queue_sim_cpp.QueueSystem(
+            [server], _queue_sim_cpp.ExponentialDist(1.0), rng_kind=rng_kind
+        )
+
+    def test_default_is_mt19937_64(self) -> None:
+        system = self._system()
+        assert system.rng_kind == _queue_sim_cpp.RngKind.MT19937_64
+
+    @pytest.mark.parametrize("rng_kind", KINDS)
+    def test_seed_determinism(self, rng_kind) -> None:
+        r1 = self._system(rng_kind).sim(num_events=10_000, seed=5)
+        r2 = self._system(rng_kind).sim(num_events=10_000, seed=5)
+        assert r1 == r2
+
+    def test_kinds_give_distinct_streams(self) -> None:
+        results = {self._system(k).sim(num_events=10_000, seed=5)
+                   for k in self.KINDS}
+        assert len(results) == len(self.KINDS)
+
+    def test_property_selects_generator(self) -> None:
+        system = self._system()
+        system.rng_kind = _queue_sim_cpp.RngKind.PCG64
+        expected = self._system(_queue_sim_cpp.RngKind.PCG64).sim(
+            num_events=10_000, seed=5)
+        assert system.sim(num_events=10_000, seed=5) == expected
+
+    @pytest.mark.parametrize("rng_kind", KINDS)
+    def test_mm1_mean_response_time(self, rng_kind) -> None:
+        N, T = self._system(rng_kind).sim(num_events=500_000, seed=42)
+        assert T == pytest.approx(1.0, rel=0.05)
+
+    @pytest.mark.parametrize("rng_kind", KINDS)
+    def test_batched_bounded_pareto_sizes(self, rng_kind) -> None:
+        # Sizes on a stream of their own take the block-transform path.
+        k, p, alpha = 0.2, 20.0, 1.5
+        mean = (alpha * k**alpha / (1 - (k / p) ** alpha)
+                * (k ** (1 - alpha) - p ** (1 - alpha)) / (alpha - 1))
+        system = _queue_sim_cpp.QueueSystem(
+            [_queue_sim_cpp.PS(_queue_sim_cpp.BoundedParetoDist(k, p, alpha))],
+            _queue_sim_cpp.ExponentialDist(0.5 / mean), rng_kind=rng_kind,
+        )
+        system.common_random_numbers = True
+        N, T = system.sim(num_events=500_000, seed=42)
+        assert T == pytest.approx(mean / 0.5, rel=0.05)
+
+    @pytest.mark.parametrize("rng_kind", KINDS[1:])
+    def test_specialized_matches_generic(self, rng_kind) -> None:
+        def run(use_specialized):
+            server = _queue_sim_cpp.PS(
+                _queue_sim_cpp.BoundedParetoDist(0.2, 20.0, 1.5))
+            system = _queue_sim_cpp.QueueSystem(
+                [server], _queue_sim_cpp.ExponentialDist(1.0),
+                rng_kind=rng_kind,
+            )
+            system.use_specialized = use_specialized
+            return system.sim(num_events=20_000, seed=7)
+
+        assert run(True) == run(False)
+
+    def test_replicate_uses_generator(self) -> None:
+        def run(rng_kind):
+            raw = self._system(rng_kind).replicate(
+                n_replications=4, num_events=5_000, seed=3, n_threads=2)
+            return list(raw.raw_T)
+
+        xo = _queue_sim_cpp.RngKind.XOSHIRO256PP
+        assert run(xo) == run(xo)
+        assert run(xo) != run(_queue_sim_cpp.RngKind.MT19937_64)